@@ -17,7 +17,7 @@
 
 QT       += core gui svg
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 TARGET = Bandage
 TEMPLATE = app
@@ -34,14 +34,25 @@ SOURCES += \
     program/settings.cpp \
     program/globals.cpp \
     program/graphlayoutworker.cpp \
+    program/layoutcache.cpp \
+    program/incrementallayout.cpp \
+    program/layoutcoarsener.cpp \
+    program/gridlayout.cpp \
+    program/forcekernel.cpp \
     graph/debruijnnode.cpp \
     graph/debruijnedge.cpp \
     graph/graphicsitemnode.cpp \
     graph/graphicsitemedge.cpp \
+    graph/labelcache.cpp \
     ui/mainwindow.cpp \
     ui/graphicsviewzoom.cpp \
     ui/settingsdialog.cpp \
     ui/mygraphicsview.cpp \
+    ui/tilerenderer.cpp \
+    ui/sceneindex.cpp \
+    ui/sceneimageexporter.cpp \
+    ui/svgwriter.cpp \
+    ui/edgebundler.cpp \
     ui/mygraphicsscene.cpp \
     ui/aboutdialog.cpp \
     ui/enteroneblastquerydialog.cpp \
@@ -65,6 +76,8 @@ SOURCES += \
     blast/runblastsearchworker.cpp \
     blast/blastsearch.cpp \
     graph/path.cpp \
+    graph/csvtable.cpp \
+    graph/pathtable.cpp \
     ui/pathspecifydialog.cpp \
     graph/graphlocation.cpp \
     ui/tablewidgetitemint.cpp \
@@ -80,21 +93,34 @@ SOURCES += \
     graph/barcodesetting.cpp \
     ui/blasthitfiltersdialog.cpp \
     program/scinot.cpp \
+    program/gzipfile.cpp \
+    program/pngwriter.cpp \
     ui/changenodenamedialog.cpp \
     ui/changenodereaddepthdialog.cpp
 HEADERS  += \
     program/settings.h \
     program/globals.h \
     program/graphlayoutworker.h \
+    program/layoutcache.h \
+    program/incrementallayout.h \
+    program/layoutcoarsener.h \
+    program/gridlayout.h \
+    program/forcekernel.h \
     graph/debruijnnode.h \
     graph/debruijnedge.h \
     graph/graphicsitemnode.h \
     graph/graphicsitemedge.h \
+    graph/labelcache.h \
     graph/ogdfnode.h \
     ui/mainwindow.h \
     ui/graphicsviewzoom.h \
     ui/settingsdialog.h \
     ui/mygraphicsview.h \
+    ui/tilerenderer.h \
+    ui/sceneindex.h \
+    ui/sceneimageexporter.h \
+    ui/svgwriter.h \
+    ui/edgebundler.h \
     ui/mygraphicsscene.h \
     ui/aboutdialog.h \
     ui/enteroneblastquerydialog.h \
@@ -119,6 +145,8 @@ HEADERS  += \
     ui/colourbutton.h \
     blast/runblastsearchworker.h \
     graph/path.h \
+    graph/csvtable.h \
+    graph/pathtable.h \
     ui/pathspecifydialog.h \
     graph/graphlocation.h \
     ui/tablewidgetitemint.h \
@@ -135,6 +163,8 @@ HEADERS  += \
     graph/barcodesetting.h \
     ui/blasthitfiltersdialog.h \
     program/scinot.h \
+    program/gzipfile.h \
+    program/pngwriter.h \
     ui/changenodenamedialog.h \
     ui/changenodereaddepthdialog.h
 
@@ -159,12 +189,13 @@ unix:LIBS += -L/usr/lib
 unix:QMAKE_CXXFLAGS += -isystem ../OGDF/ #prevents compilers warnings for OGDF
 unix:LIBS += -L$$PWD/../OGDF/_release
 unix:LIBS += -lOGDF
+unix:LIBS += -lz
 unix:INCLUDEPATH += $$PWD/../OGDF/include
 
 
 # The following settings are compatible with OGDF being
 # built in 64 bit release mode using Visual Studio 2013
-win32:LIBS += -lpsapi -logdf
+win32:LIBS += -lpsapi -logdf -lzlib
 win32:LIBS += -L$$PWD/../OGDF/x64/Release/
 win32:INCLUDEPATH += $$PWD/../OGDF/
 win32:RC_FILE = images/myapp.rc
@@ -20,6 +20,7 @@
 #include "../program/settings.h"
 #include "../graph/path.h"
 #include "../graph/debruijnnode.h"
+#include "../graph/graphicsitemnode.h"
 
 BlastQuery::BlastQuery(QString name, QString sequence) :
     m_name(name), m_sequence(sequence), m_searchedFor(false), m_shown(true)
@@ -252,3 +253,18 @@ bool BlastQuery::positionInHitList(int position, const QList<BlastHit *> * hitsT
     }
     return false;
 }
+
+
+//Nodes cache their BLAST hit part paths, coloured by query, so they must
+//make them again when a query's colour or visibility changes.
+void BlastQuery::setColour(QColor newColour)
+{
+    m_colour = newColour;
+    GraphicsItemNode::invalidateAllColouredPartPaths();
+}
+
+void BlastQuery::setShown(bool newShown)
+{
+    m_shown = newShown;
+    GraphicsItemNode::invalidateAllColouredPartPaths();
+}
@@ -62,8 +62,8 @@ public:
     void findQueryPaths();
 
 public slots:
-    void setColour(QColor newColour) {m_colour = newColour;}
-    void setShown(bool newShown) {m_shown = newShown;}
+    void setColour(QColor newColour);
+    void setShown(bool newShown);
 
 private:
     QString m_name;
@@ -25,6 +25,7 @@
 #include "../program/settings.h"
 #include <QApplication>
 #include "../graph/debruijnnode.h"
+#include "../graph/graphicsitemnode.h"
 #include "../program/memory.h"
 #include <math.h>
 
@@ -359,4 +360,7 @@ void BlastSearch::blastQueryChanged(QString queryName)
                 hit->m_node->addBlastHit(hit);
         }
     }
+
+    //Nodes make their hit paths again the next time they are drawn.
+    GraphicsItemNode::invalidateAllColouredPartPaths();
 }
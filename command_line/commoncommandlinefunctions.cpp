@@ -24,6 +24,7 @@
 #include <QCoreApplication>
 #include "../program/memory.h"
 #include <QStringList>
+#include <limits>
 
 
 void printSettingsUsage(QTextStream * out)
@@ -64,6 +65,23 @@ void printSettingsUsage(QTextStream * out)
     *out << "                              in shorter nodes." << endl;
     *out << "          --quality <int>     Graph layout quality, 0 (low) to 4 (high)" << endl;
     *out << "                              (default: " + QString::number(g_settings->graphLayoutQuality) + ")" << endl;
+    *out << "          --layout <name>     Graph layout algorithm, from one of the following" << endl;
+    *out << "                              options: fmmm, grid.  The grid layout is faster" << endl;
+    *out << "                              for very large graphs (default: fmmm)" << endl;
+    *out << "          --componentlayout   Lay out each connected component separately and" << endl;
+    *out << "                              in parallel, then pack them together (default:" << endl;
+    *out << "                              off)" << endl;
+    *out << "          --capsegments       Lay out long nodes with fewer segments, which are" << endl;
+    *out << "                              smoothed out when drawn (default: off)" << endl;
+    *out << "          --coarsen           Lay out unbranched chains as single nodes first," << endl;
+    *out << "                              then refine the layout of every node (default:" << endl;
+    *out << "                              off)" << endl;
+    *out << "          --seed <int>        Random seed for the graph layout.  The same graph" << endl;
+    *out << "                              and settings with the same seed always give the" << endl;
+    *out << "                              same layout (default: a different seed each time)" << endl;
+    *out << "          --layoutfile <file> A layout file saved by Bandage.  The nodes in the" << endl;
+    *out << "                              file are drawn where it says, and no layout is" << endl;
+    *out << "                              done (default: none)" << endl;
     *out << endl;
     *out << "          Node width" << endl;
     *out << "          ---------------------------------------------------------------------" << endl;
@@ -103,6 +121,9 @@ void printSettingsUsage(QTextStream * out)
     *out << "          --centre            Node labels appear at the centre of the node" << endl;
     *out << "                              (default: off, node labels appear over visible" << endl;
     *out << "                              parts of nodes)" << endl;
+    *out << "          --overlap           Draw all labels, even where they overlap" << endl;
+    *out << "                              (default: off, labels overlapping others are" << endl;
+    *out << "                              hidden)" << endl;
     *out << endl;
     *out << "          Node colours" << endl;
     *out << "          ---------------------------------------------------------------------" << endl;
@@ -236,6 +257,19 @@ QString checkForInvalidOrExcessSettings(QStringList * arguments)
     if (error.length() > 0) return error;
     error = checkOptionForInt("--quality", arguments, 1, 5);
     if (error.length() > 0) return error;
+    QStringList validLayoutOptions;
+    validLayoutOptions << "fmmm" << "grid";
+    error = checkOptionForString("--layout", arguments, validLayoutOptions);
+    if (error.length() > 0) return error;
+    checkOptionWithoutValue("--componentlayout", arguments);
+    checkOptionWithoutValue("--capsegments", arguments);
+    checkOptionWithoutValue("--coarsen", arguments);
+    error = checkOptionForInt("--seed", arguments, 0, std::numeric_limits<int>::max());
+    if (error.length() > 0) return error;
+    if (isOptionPresent("--layoutfile", arguments) && g_memory->commandLineCommand == NO_COMMAND)
+        return "The --layoutfile option can only be used with Bandage load and Bandage image";
+    error = checkOptionForFile("--layoutfile", arguments);
+    if (error.length() > 0) return error;
 
     error = checkOptionForFloat("--nodewidth", arguments, 0.5, 1000.0);
     if (error.length() > 0) return error;
@@ -258,6 +292,7 @@ QString checkForInvalidOrExcessSettings(QStringList * arguments)
     error = checkOptionForFloat("--toutline", arguments, 0.0, 2.0);
     if (error.length() > 0) return error;
     checkOptionWithoutValue("--centre", arguments);
+    checkOptionWithoutValue("--overlap", arguments);
 
     error = checkOptionForColour("--edgecol", arguments);
     if (error.length() > 0) return error;
@@ -383,6 +418,19 @@ void parseSettings(QStringList arguments)
         g_settings->graphLayoutQuality = quality;
     }
 
+    if (isOptionPresent("--layout", &arguments))
+        g_settings->layoutAlgorithm = getLayoutAlgorithmOption("--layout", &arguments);
+
+    g_settings->componentLayout = isOptionPresent("--componentlayout", &arguments);
+    g_settings->capNodeSegments = isOptionPresent("--capsegments", &arguments);
+    g_settings->coarsenChains = isOptionPresent("--coarsen", &arguments);
+
+    if (isOptionPresent("--seed", &arguments))
+        g_settings->layoutSeed = getIntOption("--seed", &arguments);
+
+    if (isOptionPresent("--layoutfile", &arguments))
+        g_settings->layoutFilename = getStringOption("--layoutfile", &arguments);
+
     if (isOptionPresent("--nodewidth", &arguments))
         g_settings->averageNodeWidth = getFloatOption("--nodewidth", &arguments);
     if (isOptionPresent("--depwidth", &arguments))
@@ -407,6 +455,7 @@ void parseSettings(QStringList arguments)
     if (isOptionPresent("--toutcol", &arguments))
         g_settings->textOutlineColour = getColourOption("--toutcol", &arguments);
     g_settings->positionTextNodeCentre = isOptionPresent("--centre", &arguments);
+    g_settings->hideOverlappingLabels = !isOptionPresent("--overlap", &arguments);
 
     g_settings->displayNodeNames = isOptionPresent("--names", &arguments);
     g_settings->displayNodeLengths = isOptionPresent("--lengths", &arguments);
@@ -933,6 +982,25 @@ GraphScope getGraphScopeOption(QString option, QStringList * arguments)
 }
 
 
+LayoutAlgorithm getLayoutAlgorithmOption(QString option, QStringList * arguments)
+{
+    int optionIndex = arguments->indexOf(option);
+    if (optionIndex == -1)
+        return FMMM_LAYOUT;
+
+    int algorithmIndex = optionIndex + 1;
+    if (algorithmIndex >= arguments->size())
+        return FMMM_LAYOUT;
+
+    QString algorithmString = arguments->at(algorithmIndex).toLower();
+    if (algorithmString == "grid")
+        return GRID_LAYOUT;
+
+    //FMMM is the default.
+    return FMMM_LAYOUT;
+}
+
+
 QColor getColourOption(QString option, QStringList * arguments)
 {
     int optionIndex = arguments->indexOf(option);
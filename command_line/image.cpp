@@ -21,11 +21,14 @@
 #include "../program/globals.h"
 #include "../ui/mygraphicsscene.h"
 #include "../ui/mygraphicsview.h"
+#include "../ui/sceneimageexporter.h"
+#include "../ui/svgwriter.h"
 #include "../graph/assemblygraph.h"
 #include <vector>
 #include "../program/settings.h"
+#include "../program/memory.h"
 #include <QPainter>
-#include <QSvgGenerator>
+#include <stdlib.h>
 #include <QDir>
 #include "../blast/blastsearch.h"
 
@@ -92,7 +95,8 @@ int bandageImage(QStringList arguments)
 
     int width = 0;
     int height = 0;
-    parseImageOptions(arguments, &width, &height);
+    QString layoutSaveFilename;
+    parseImageOptions(arguments, &width, &height, &layoutSaveFilename);
 
     //For Bandage image, it is necessary to position node labels at the
     //centre of the node, not the visible centre(s).  This is because there
@@ -122,25 +126,54 @@ int bandageImage(QStringList arguments)
         }
     }
 
-    QString errorTitle;
-    QString errorMessage;
-    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
-                                                                                  g_settings->doubleMode,
-                                                                                  g_settings->startingNodes,
-                                                                                  "all");
-
-    if (errorMessage != "")
+    //With a layout file, the nodes it includes are drawn where it says and
+    //the scope and layout settings are not used.
+    QHash<QString, std::vector<QPointF> > layoutLinePoints;
+    if (g_settings->layoutFilename != "")
     {
-        err << errorMessage << endl;
-        return 1;
+        bool layoutDoubleMode;
+        QString layoutError;
+        if (!g_assemblyGraph->loadLayout(g_settings->layoutFilename, &layoutLinePoints,
+                                         &layoutDoubleMode, &layoutError))
+        {
+            err << "Bandage error: could not load " << g_settings->layoutFilename << ": " << layoutError << endl;
+            return 1;
+        }
+        g_assemblyGraph->buildOgdfGraphFromLayout(layoutLinePoints, layoutDoubleMode);
+    }
+    else
+    {
+        QString errorTitle;
+        QString errorMessage;
+        std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
+                                                                                      g_settings->doubleMode,
+                                                                                      g_settings->startingNodes,
+                                                                                      "all");
+
+        if (errorMessage != "")
+        {
+            err << errorMessage << endl;
+            return 1;
+        }
+
+        g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+        g_assemblyGraph->layoutGraph();
     }
 
-    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
-    g_assemblyGraph->layoutGraph();
+    //Random node colours also come from the seed, so a seeded image is the
+    //same every time.
+    if (g_settings->layoutSeed >= 0)
+        srand(g_settings->layoutSeed);
 
     MyGraphicsScene scene;
-    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+    g_assemblyGraph->addGraphicsItemsToScene(&scene, &layoutLinePoints);
     scene.setSceneRectangle();
+
+    if (layoutSaveFilename != "" && !g_assemblyGraph->saveLayout(layoutSaveFilename))
+    {
+        err << "Bandage error: could not save the layout to " << layoutSaveFilename << endl;
+        return 1;
+    }
     double sceneRectAspectRatio = scene.sceneRect().width() / scene.sceneRect().height();
 
     //Determine image size
@@ -154,9 +187,29 @@ int bandageImage(QStringList arguments)
     else if (height == 0 && width > 0)
         height = width / sceneRectAspectRatio;
 
+    //PNG images are saved in bands, so only JPEG images are limited to the
+    //largest size of a QImage.
+    bool png = (imageFileExtension == ".png");
+    if (pixelImage && !png && (width > 32767 || height > 32767))
+    {
+        err << "Bandage error: JPEG images can not be taller or wider than 32767 pixels" << endl;
+        return 1;
+    }
+
+    //Images are saved in full detail, however small the nodes and labels
+    //are in them.
+    g_memory->fullDetailPainting = true;
+
     bool success = true;
     QPainter painter;
-    if (pixelImage)
+    if (png)
+    {
+        QString saveError;
+        success = SceneImageExporter::savePng(&scene, imageSaveFilename, QSize(width, height), &saveError);
+        if (!success)
+            err << saveError << endl;
+    }
+    else if (pixelImage)
     {
         QImage image(width, height, QImage::Format_ARGB32);
         image.fill(Qt::white);
@@ -169,17 +222,12 @@ int bandageImage(QStringList arguments)
     }
     else //SVG
     {
-        QSvgGenerator generator;
-        generator.setFileName(imageSaveFilename);
-        generator.setSize(QSize(width, height));
-        generator.setViewBox(QRect(0, 0, width, height));
-        painter.begin(&generator);
-        painter.fillRect(0, 0, width, height, Qt::white);
-        painter.setRenderHint(QPainter::Antialiasing);
-        painter.setRenderHint(QPainter::TextAntialiasing);
-        scene.render(&painter);
-        painter.end();
+        SvgWriter writer(imageSaveFilename);
+        success = writer.writeScene(&scene, QSize(width, height));
+        if (!success)
+            err << writer.errorString() << endl;
     }
+    g_memory->fullDetailPainting = false;
 
     int returnCode;
     if (!success)
@@ -207,6 +255,9 @@ void printImageUsage(QTextStream * out, bool all)
     *out << "                              If only height or width is set, the other will be" << endl;
     *out << "                              determined automatically. If both are set, the" << endl;
     *out << "                              image will be exactly that size." << endl;
+    *out << "          --savelayout <file> Save the node positions to a layout file, which" << endl;
+    *out << "                              can be drawn again without a layout using" << endl;
+    *out << "                              --layoutfile (default: not saved)" << endl;
     *out << endl;
     printCommonHelp(out);
     if (all)
@@ -217,10 +268,13 @@ void printImageUsage(QTextStream * out, bool all)
 
 QString checkForInvalidImageOptions(QStringList arguments)
 {
-    QString error = checkOptionForInt("--height", &arguments, 1, 32767);
+    QString error = checkOptionForInt("--height", &arguments, 1, 1000000);
     if (error.length() > 0) return error;
 
-    error = checkOptionForInt("--width", &arguments, 1, 32767);
+    error = checkOptionForInt("--width", &arguments, 1, 1000000);
+    if (error.length() > 0) return error;
+
+    error = checkOptionForString("--savelayout", &arguments, QStringList(), "a filename");
     if (error.length() > 0) return error;
 
     return checkForInvalidOrExcessSettings(&arguments);
@@ -231,7 +285,8 @@ QString checkForInvalidImageOptions(QStringList arguments)
 
 //This function parses the command line options.  It assumes that the options
 //have already been checked for correctness.
-void parseImageOptions(QStringList arguments, int * width, int * height)
+void parseImageOptions(QStringList arguments, int * width, int * height,
+                       QString * layoutSaveFilename)
 {
     if (isOptionPresent("--height", &arguments))
         *height = getIntOption("--height", &arguments);
@@ -239,6 +294,9 @@ void parseImageOptions(QStringList arguments, int * width, int * height)
     if (isOptionPresent("--width", &arguments))
         *width = getIntOption("--width", &arguments);
 
+    if (isOptionPresent("--savelayout", &arguments))
+        *layoutSaveFilename = getStringOption("--savelayout", &arguments);
+
     parseSettings(arguments);
 }
 
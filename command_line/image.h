@@ -27,6 +27,7 @@
 int bandageImage(QStringList arguments);
 void printImageUsage(QTextStream * out, bool all);
 QString checkForInvalidImageOptions(QStringList arguments);
-void parseImageOptions(QStringList arguments, int * width, int * height);
+void parseImageOptions(QStringList arguments, int * width, int * height,
+                       QString * layoutSaveFilename);
 
 #endif // IMAGE_H
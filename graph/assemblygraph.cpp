@@ -25,8 +25,11 @@
 #include "../graph/debruijnnode.h"
 #include "../graph/debruijnedge.h"
 #include "../graph/graphicsitemnode.h"
+#include "../graph/ogdfnode.h"
 #include <QFile>
+#include "../program/gzipfile.h"
 #include <QTextStream>
+#include <QCryptographicHash>
 #include <QApplication>
 #include "../graph/graphicsitemedge.h"
 #include "../blast/blastsearch.h"
@@ -38,17 +41,38 @@
 #include "path.h"
 #include "../ui/myprogressdialog.h"
 
+//Enough of the start of a graph file to hold the part of its first line
+//that is used to recognise the file type.
+static const qint64 FILE_TYPE_SNIFF_SIZE = 16384;
+
+//This function gives the position of one of a node's OGDF nodes along the
+//node's drawn line.  A node can be drawn with a different number of points
+//than it has OGDF nodes (e.g. when its segments were capped for the
+//layout), so the OGDF nodes are spread evenly over the line's points.
+static QPointF getLinePointForOgdfNode(const std::vector<QPointF> & linePoints,
+                                       size_t ogdfIndex, size_t ogdfNodeCount)
+{
+    if (ogdfNodeCount < 2 || linePoints.size() < 2)
+        return linePoints.front();
+    double linePosition = double(ogdfIndex) * (linePoints.size() - 1) / (ogdfNodeCount - 1);
+    size_t lineIndex = std::min(size_t(linePosition), linePoints.size() - 2);
+    double fraction = linePosition - lineIndex;
+    return linePoints[lineIndex] * (1.0 - fraction) + linePoints[lineIndex + 1] * fraction;
+}
+
 AssemblyGraph::AssemblyGraph() :
     m_kmer(0), m_contiguitySearchDone(false)
 {
     m_ogdfGraph = new ogdf::Graph();
     m_graphAttributes = new ogdf::GraphAttributes(*m_ogdfGraph, ogdf::GraphAttributes::nodeGraphics |
                                                   ogdf::GraphAttributes::edgeGraphics);
+    m_ogdfEdgeLengths = new ogdf::EdgeArray<double>(*m_ogdfGraph, 1.0);
     clearGraphInfo();
 }
 
 AssemblyGraph::~AssemblyGraph()
 {
+    delete m_ogdfEdgeLengths;
     delete m_graphAttributes;
     delete m_ogdfGraph;
 }
@@ -72,6 +96,8 @@ void AssemblyGraph::cleanUp()
     }
     m_deBruijnGraphEdges.clear();
 
+    m_csvTable.clear();
+    m_pathTable.clear();
     m_contiguitySearchDone = false;
 
     clearGraphInfo();
@@ -307,6 +333,13 @@ void AssemblyGraph::resetNodeContiguityStatus()
 
 void AssemblyGraph::resetAllNodeColours()
 {
+    if (g_settings->nodeColourScheme == CSV_COLOURS)
+        m_csvTable.determineColours(g_settings->displayNodeCsvDataCol,
+                                    g_settings->lowReadDepthColour,
+                                    g_settings->highReadDepthColour,
+                                    g_settings->randomColourPositiveSaturation,
+                                    g_settings->randomColourPositiveLightness);
+
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
@@ -438,10 +471,10 @@ void AssemblyGraph::buildDeBruijnGraphFromLastGraph(QString fullFileName)
     m_graphFileType = LAST_GRAPH;
 
     bool firstLine = true;
-    QFile inputFile(fullFileName);
-    if (inputFile.open(QIODevice::ReadOnly))
+    QSharedPointer<GzipFile> inputFile = openGraphFile(fullFileName);
+    if (inputFile->isOpen())
     {
-        QTextStream in(&inputFile);
+        QTextStream in(inputFile.data());
         while (!in.atEnd())
         {
             QApplication::processEvents();
@@ -497,7 +530,11 @@ void AssemblyGraph::buildDeBruijnGraphFromLastGraph(QString fullFileName)
                 createDeBruijnEdge(node1Name, node2Name);
             }
         }
-        inputFile.close();
+        inputFile->close();
+
+        //A damaged compressed file must not load as a partial graph.
+        if (inputFile->hasError())
+            throw "load error";
 
         setAllEdgesExactOverlap(0);
     }
@@ -525,14 +562,22 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName)
 {
     m_graphFileType = GFA;
 
-    QFile inputFile(fullFileName);
-    if (inputFile.open(QIODevice::ReadOnly))
+    QSharedPointer<GzipFile> inputFile = openGraphFile(fullFileName);
+    if (inputFile->isOpen())
     {
         std::vector<QString> edgeStartingNodeNames;
         std::vector<QString> edgeEndingNodeNames;
         std::vector<int> edgeOverlaps;
 
-        QTextStream in(&inputFile);
+        //Paths are saved as lists of node names and only turned into nodes
+        //once all of the nodes exist.
+        std::vector<QString> pathNames;
+        std::vector<QStringList> pathNodeNames;
+        std::vector<bool> pathSkipsUnknownNames;
+
+        bool gfa2 = false;
+
+        QTextStream in(inputFile.data());
         while (!in.atEnd())
         {
             QApplication::processEvents();
@@ -543,8 +588,18 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName)
             if (lineParts.size() < 1)
                 continue;
 
+            //The header line says which version of GFA the file uses.
+            if (lineParts.at(0) == "H")
+            {
+                for (int i = 1; i < lineParts.size(); ++i)
+                {
+                    if (lineParts.at(i).startsWith("VN:Z:2"))
+                        gfa2 = true;
+                }
+            }
+
             //Lines beginning with "S" are sequence (node) lines
-            if (lineParts.at(0) == "S")
+            else if (lineParts.at(0) == "S")
             {
                 if (lineParts.size() < 3)
                     throw "load error";
@@ -553,7 +608,19 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName)
                 if (nodeName.isEmpty())
                     nodeName = "node";
 
-                QByteArray sequence = lineParts.at(2).toLocal8Bit();
+                //GFA 2 segment lines have a length before the sequence.  Files
+                //without a header are recognised by that length being followed
+                //by something other than a tag.
+                int sequenceIndex = 2;
+                if (lineParts.size() >= 4)
+                {
+                    bool lengthIsInt;
+                    lineParts.at(2).toLongLong(&lengthIsInt);
+                    if (lengthIsInt && (gfa2 || !isGfaTag(lineParts.at(3))))
+                        sequenceIndex = 3;
+                }
+
+                QByteArray sequence = lineParts.at(sequenceIndex).toLocal8Bit();
 
                 //If there is an attribute holding the read depth, we'll use
                 //that. If there isn't, then we'll use zero.
@@ -561,7 +628,7 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName)
                 //'KC' (k-mer count)in that order of preference.
                 double nodeReadDepth = 0.0;
                 QString kc, rc, fc;
-                for (int i = 3; i < lineParts.size(); ++i)
+                for (int i = sequenceIndex + 1; i < lineParts.size(); ++i)
                 {
                     QString part = lineParts.at(i);
                     if (part.size() < 6)
@@ -617,8 +684,69 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName)
                 QString cigar = lineParts.at(5);
                 edgeOverlaps.push_back(getLengthFromCigar(cigar));
             }
+
+            //Lines beginning with "E" are GFA 2 edge lines.  Only dovetail
+            //overlaps become edges - containments have no place in the graph.
+            else if (lineParts.at(0) == "E")
+            {
+                if (lineParts.size() < 8)
+                    throw "load error";
+
+                QString startingNode, endingNode;
+                int overlap;
+                if (getEdgeFromGfa2EdgeLine(lineParts, &startingNode, &endingNode, &overlap))
+                {
+                    edgeStartingNodeNames.push_back(startingNode);
+                    edgeEndingNodeNames.push_back(endingNode);
+                    edgeOverlaps.push_back(overlap);
+                }
+            }
+
+            //Lines beginning with "P" are GFA 1 path lines, with the path's
+            //nodes given as a comma-delimited list like "1+,2-,3+".
+            else if (lineParts.at(0) == "P")
+            {
+                if (lineParts.size() < 3)
+                    throw "load error";
+
+                pathNames.push_back(lineParts.at(1));
+                pathNodeNames.push_back(lineParts.at(2).split(",", QString::SkipEmptyParts));
+                pathSkipsUnknownNames.push_back(false);
+            }
+
+            //Lines beginning with "W" are walk lines, with the nodes given
+            //like ">1<2>3".
+            else if (lineParts.at(0) == "W")
+            {
+                if (lineParts.size() < 7)
+                    throw "load error";
+
+                QString walkName = lineParts.at(1) + "#" + lineParts.at(2) + "#" + lineParts.at(3);
+                if (lineParts.at(4) != "*" && lineParts.at(5) != "*")
+                    walkName += ":" + lineParts.at(4) + "-" + lineParts.at(5);
+
+                pathNames.push_back(walkName);
+                pathNodeNames.push_back(getNodeNamesFromGfaWalk(lineParts.at(6)));
+                pathSkipsUnknownNames.push_back(false);
+            }
+
+            //Lines beginning with "O" are GFA 2 ordered groups.  They can
+            //refer to edges as well as segments, so anything that isn't a
+            //node is skipped over.
+            else if (lineParts.at(0) == "O")
+            {
+                if (lineParts.size() < 3)
+                    throw "load error";
+
+                pathNames.push_back(lineParts.at(1));
+                pathNodeNames.push_back(lineParts.at(2).split(" ", QString::SkipEmptyParts));
+                pathSkipsUnknownNames.push_back(true);
+            }
         }
 
+        if (inputFile->hasError())
+            throw "load error";
+
         //Pair up reverse complements, creating them if necessary.
         QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
         while (i.hasNext())
@@ -637,6 +765,29 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName)
             int overlap = edgeOverlaps[i];
             createDeBruijnEdge(node1Name, node2Name, overlap, EXACT_OVERLAP);
         }
+
+        //Now that the nodes exist, the paths can be stored.  Paths that
+        //refer to missing nodes are left out.
+        for (size_t i = 0; i < pathNames.size(); ++i)
+        {
+            const QStringList & nodeNames = pathNodeNames[i];
+            std::vector<DeBruijnNode *> pathNodes;
+            pathNodes.reserve(nodeNames.size());
+            bool allNodesFound = true;
+            for (int j = 0; j < nodeNames.size(); ++j)
+            {
+                DeBruijnNode * node = m_deBruijnGraphNodes.value(nodeNames[j], 0);
+                if (node != 0)
+                    pathNodes.push_back(node);
+                else if (!pathSkipsUnknownNames[i])
+                {
+                    allNodesFound = false;
+                    break;
+                }
+            }
+            if (allNodesFound && !pathNodes.empty())
+                m_pathTable.addPath(pathNames[i], pathNodes);
+        }
     }
 
     if (m_deBruijnGraphNodes.size() == 0)
@@ -646,6 +797,106 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName)
 
 
 
+//GFA tags look like "RC:i:1234".
+bool AssemblyGraph::isGfaTag(QString part)
+{
+    return part.length() >= 5 && part.at(2) == ':' && part.at(4) == ':';
+}
+
+
+//This function takes the parts of a GFA 2 edge line:
+//  E  id  sid1+  sid2-  beg1  end1  beg2  end2  alignment
+//and, if the alignment is a dovetail overlap, gives the starting and ending
+//node names of the edge it makes.  Positions at the end of a segment are
+//marked with a '$'.
+bool AssemblyGraph::getEdgeFromGfa2EdgeLine(QStringList lineParts, QString * startingNode,
+                                            QString * endingNode, int * overlap)
+{
+    QString ref1 = lineParts.at(2);
+    QString ref2 = lineParts.at(3);
+    if (ref1.length() < 2 || ref2.length() < 2)
+        return false;
+
+    QString name1 = ref1.left(ref1.length() - 1);
+    QString name2 = ref2.left(ref2.length() - 1);
+    QChar orientation1 = ref1.at(ref1.length() - 1);
+    QChar orientation2 = ref2.at(ref2.length() - 1);
+
+    //An edge from a reversed first segment is the same as an edge from the
+    //forward first segment with the second segment flipped.
+    if (orientation1 == '-')
+        orientation2 = (orientation2 == '+') ? '-' : '+';
+
+    QString beg1 = lineParts.at(4);
+    QString end1 = lineParts.at(5);
+    QString beg2 = lineParts.at(6);
+    QString end2 = lineParts.at(7);
+    bool beg1AtStart = (beg1 == "0");
+    bool end1AtEnd = end1.endsWith("$");
+    bool beg2AtStart = (beg2 == "0");
+    bool end2AtEnd = end2.endsWith("$");
+
+    QString node1 = name1 + "+";
+    QString node2 = name2 + orientation2;
+
+    *overlap = end1.remove("$").toInt() - beg1.remove("$").toInt();
+
+    if (end1AtEnd && ((orientation2 == '+' && beg2AtStart) || (orientation2 == '-' && end2AtEnd)))
+    {
+        *startingNode = node1;
+        *endingNode = node2;
+        return true;
+    }
+    if (beg1AtStart && ((orientation2 == '+' && end2AtEnd) || (orientation2 == '-' && beg2AtStart)))
+    {
+        *startingNode = node2;
+        *endingNode = node1;
+        return true;
+    }
+    return false;
+}
+
+
+//This function turns a GFA walk like ">1<2>3" into the node names
+//"1+", "2-" and "3+".
+QStringList AssemblyGraph::getNodeNamesFromGfaWalk(QString walk)
+{
+    QStringList nodeNames;
+    int nameStart = -1;
+    for (int i = 0; i <= walk.length(); ++i)
+    {
+        if (i == walk.length() || walk.at(i) == '>' || walk.at(i) == '<')
+        {
+            if (nameStart >= 0 && i > nameStart + 1)
+            {
+                QString direction = (walk.at(nameStart) == '>') ? "+" : "-";
+                nodeNames.push_back(walk.mid(nameStart + 1, i - nameStart - 1) + direction);
+            }
+            nameStart = i;
+        }
+    }
+    return nodeNames;
+}
+
+
+//This function gives the file left open by getGraphFileTypeFromFile if it
+//is the one asked for.  Otherwise the file is opened afresh.
+QSharedPointer<GzipFile> AssemblyGraph::openGraphFile(QString fullFileName)
+{
+    QSharedPointer<GzipFile> inputFile;
+    if (!m_sniffedFile.isNull() && m_sniffedFileName == fullFileName)
+        inputFile = m_sniffedFile;
+    else
+    {
+        inputFile = QSharedPointer<GzipFile>(new GzipFile(fullFileName));
+        inputFile->open(QIODevice::ReadOnly);
+    }
+
+    clearSniffedFile();
+    return inputFile;
+}
+
+
 //This function converts a CIGAR string to a length.  It is
 //currently incomplete, only looking at matches and mismatches.
 //I'm waiting for the GFA format to be pinned down before
@@ -683,14 +934,14 @@ void AssemblyGraph::buildDeBruijnGraphFromFastg(QString fullFileName)
 {
     m_graphFileType = FASTG;
 
-    QFile inputFile(fullFileName);
-    if (inputFile.open(QIODevice::ReadOnly))
+    QSharedPointer<GzipFile> inputFile = openGraphFile(fullFileName);
+    if (inputFile->isOpen())
     {
         std::vector<QString> edgeStartingNodeNames;
         std::vector<QString> edgeEndingNodeNames;
         DeBruijnNode * node = 0;
 
-        QTextStream in(&inputFile);
+        QTextStream in(inputFile.data());
         while (!in.atEnd())
         {
             QApplication::processEvents();
@@ -779,7 +1030,10 @@ void AssemblyGraph::buildDeBruijnGraphFromFastg(QString fullFileName)
             }
         }
 
-        inputFile.close();
+        inputFile->close();
+
+        if (inputFile->hasError())
+            throw "load error";
 
         //If all went well, each node will have a reverse complement and the code
         //will never get here.  However, I have noticed that some SPAdes fastg files
@@ -815,14 +1069,14 @@ void AssemblyGraph::buildDeBruijnGraphFromFastgBC(QString fullFileName, QString
 {
     m_graphFileType = FASTG;
 
-    QFile inputFile(fullFileName);
-    if (inputFile.open(QIODevice::ReadOnly))
+    QSharedPointer<GzipFile> inputFile = openGraphFile(fullFileName);
+    if (inputFile->isOpen())
     {
         std::vector<QString> edgeStartingNodeNames;
         std::vector<QString> edgeEndingNodeNames;
         DeBruijnNode * node = 0;
 
-        QTextStream in(&inputFile);
+        QTextStream in(inputFile.data());
         while (!in.atEnd())
         {
             QApplication::processEvents();
@@ -911,7 +1165,10 @@ void AssemblyGraph::buildDeBruijnGraphFromFastgBC(QString fullFileName, QString
             }
         }
 
-        inputFile.close();
+        inputFile->close();
+
+        if (inputFile->hasError())
+            throw "load error";
 
         //If all went well, each node will have a reverse complement and the code
         //will never get here.  However, I have noticed that some SPAdes fastg files
@@ -1018,7 +1275,8 @@ void AssemblyGraph::buildDeBruijnGraphFromTrinityFasta(QString fullFileName)
 
     std::vector<QString> names;
     std::vector<QString> sequences;
-    readFastaFile(fullFileName, &names, &sequences);
+    QSharedPointer<GzipFile> inputFile = openGraphFile(fullFileName);
+    readFastaFile(inputFile.data(), &names, &sequences);
 
     std::vector<QString> edgeStartingNodeNames;
     std::vector<QString> edgeEndingNodeNames;
@@ -1136,21 +1394,61 @@ void AssemblyGraph::buildDeBruijnGraphFromTrinityFasta(QString fullFileName)
 }
 
 
+//This function works out the type of a graph file from the start of its
+//first line.  The file is opened and read only once: it is then kept open,
+//with the bytes already read still buffered in the device, so the build
+//function can carry on without reading them again.  This is done even if
+//the type isn't recognised, as the user may choose to load it as some type
+//anyway.  The file stays open (also through cleanUp) until it is loaded or
+//clearSniffedFile is called.
 GraphFileType AssemblyGraph::getGraphFileTypeFromFile(QString fullFileName)
 {
-    if (checkFileIsLastGraph(fullFileName))
+    clearSniffedFile();
+
+    QSharedPointer<GzipFile> inputFile(new GzipFile(fullFileName));
+    if (!inputFile->open(QIODevice::ReadOnly))
+        return UNKNOWN_FILE_TYPE;
+
+    //Peeking leaves the bytes in the device's buffer for the parser.
+    QByteArray fileStart = inputFile->peek(FILE_TYPE_SNIFF_SIZE);
+    GraphFileType graphFileType = getGraphFileTypeFromFileStart(fileStart);
+
+    if (graphFileType == FASTG && fileExists(fullFileName + ".barcode"))
+        graphFileType = FASTG_BC;
+
+    m_sniffedFile = inputFile;
+    m_sniffedFileName = fullFileName;
+    return graphFileType;
+}
+
+
+//This function closes the file kept open by getGraphFileTypeFromFile, for
+//when it won't be loaded after all.
+void AssemblyGraph::clearSniffedFile()
+{
+    m_sniffedFile.clear();
+    m_sniffedFileName = "";
+}
+
+
+//This function classifies a graph file using its first line, taken from
+//the (already decompressed) start of the file.
+GraphFileType AssemblyGraph::getGraphFileTypeFromFileStart(const QByteArray & fileStart)
+{
+    //None of the graph formats have null bytes, so anything with one is
+    //binary and there's no point in looking for text patterns.
+    if (fileStart.contains('\0'))
+        return UNKNOWN_FILE_TYPE;
+
+    QString firstLine = QString::fromLocal8Bit(fileStart.left(fileStart.indexOf('\n')));
+
+    if (QRegExp("\\d+\\s+\\d+\\s+\\d+\\s+\\d+").indexIn(firstLine) != -1)
         return LAST_GRAPH;
-    if (checkFileIsFastG(fullFileName))
-    {
-        //qDebug()<<fullFileName + ".barcode";
-        if (fileExists(fullFileName + ".barcode"))
-            return FASTG_BC;
-        else
-            return FASTG;
-    }
-    if (checkFileIsGfa(fullFileName))
+    if (firstLine.contains(">NODE") || firstLine.contains(">EDGE"))
+        return FASTG;
+    if (QRegExp("[SLH]\t").indexIn(firstLine) != -1)
         return GFA;
-    if (checkFileIsTrinityFasta(fullFileName))
+    if (firstLine.contains("path=["))
         return TRINITY;
     return UNKNOWN_FILE_TYPE;
 }
@@ -1190,7 +1488,7 @@ bool AssemblyGraph::checkFileIsTrinityFasta(QString fullFileName)
 
 bool AssemblyGraph::checkFirstLineOfFile(QString fullFileName, QString regExp)
 {
-    QFile inputFile(fullFileName);
+    GzipFile inputFile(fullFileName);
     if (inputFile.open(QIODevice::ReadOnly))
     {
         QTextStream in(&inputFile);
@@ -1216,6 +1514,11 @@ bool AssemblyGraph::checkFirstLineOfFile(QString fullFileName, QString regExp)
  */
 QStringList AssemblyGraph::splitCsv(QString line, QString sep)
 {
+    //Without any quotes the regular expression below gives the same result
+    //as a plain split, which is much quicker.
+    if (!line.contains('"'))
+        return line.split(sep);
+
     QStringList list;
     QRegExp rx("(\"(?:[^\"]|\"\")*\"|[^"+sep+"]*)");
     int pos = 0;
@@ -1244,7 +1547,7 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
 {
     clearAllCsvData();
 
-    QFile inputFile(filename);
+    GzipFile inputFile(filename);
     if (!inputFile.open(QIODevice::ReadOnly))
     {
         *errormsg = "Unable to read from specified file.";
@@ -1277,7 +1580,18 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
 
     headers.pop_front();
     *columns = headers;
-    int columnCount = headers.size();
+    m_csvTable.setColumnNames(headers);
+
+    //Node names are resolved through a hash, built once, instead of a map
+    //lookup for every row.
+    QHash<QString, DeBruijnNode *> nodesByName;
+    nodesByName.reserve(m_deBruijnGraphNodes.size());
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        nodesByName.insert(i.key(), i.value());
+    }
 
     while (!in.atEnd())
     {
@@ -1289,16 +1603,18 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
         //Get rid of the node name - no need to save that.
         cols.pop_front();
 
-        //Get rid of any extra data that doesn't have a header.
-        while (cols.size() > columnCount)
-            cols.pop_back();
+        DeBruijnNode * node = 0;
+        if (nodeName != "")
+            node = nodesByName.value(nodeName, 0);
 
-        if (nodeName != "" && m_deBruijnGraphNodes.contains(nodeName))
-            m_deBruijnGraphNodes[nodeName]->setCsvData(cols);
-        else
+        if (node == 0)
             unmatched_nodes++;
+        else if (!cols.isEmpty())
+            node->setCsvRow(m_csvTable.addRow(cols));
     }
 
+    m_csvTable.finishLoading();
+
     if (unmatched_nodes)
         *errormsg = "There were " + QString::number(unmatched_nodes) + " unmatched entries in the CSV.";
 
@@ -1313,6 +1629,19 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
 //If the node name it finds does not end in a '+' or '-', it will add '+'.
 QString AssemblyGraph::getNodeNameFromString(QString string)
 {
+    //Most strings are just a node name without any underscores, so there is
+    //no need to split them.
+    if (!string.contains('_'))
+    {
+        if (string.isEmpty() || string == "NODE")
+            return "";
+        QChar lastChar = string.at(string.length() - 1);
+        if (lastChar == '+' || lastChar == '-')
+            return string;
+        else
+            return string + "+";
+    }
+
     QStringList parts = string.split("_");
     if (parts.size() == 0)
         return "";
@@ -1365,7 +1694,10 @@ bool AssemblyGraph::loadGraphFromFile(QString filename)
     GraphFileType graphFileType = getGraphFileTypeFromFile(filename);
 
     if (graphFileType == UNKNOWN_FILE_TYPE)
+    {
+        clearSniffedFile();
         return false;
+    }
 
     try
     {
@@ -1429,13 +1761,63 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
         }
     }
 
+    addDrawnNodesAndEdgesToOgdfGraph();
+}
+
+
+//This function draws exactly the nodes in a layout loaded from file, and
+//puts their OGDF nodes where the layout says.  The layout's points are
+//used directly for the graphics items, so the OGDF positions only matter
+//for things that are laid out later, like incremental layout.  A node
+//saved with a different number of points than it has OGDF nodes (e.g.
+//because it was drawn with capped segments, or with a different node
+//length setting) has its OGDF nodes spread along its saved points.
+void AssemblyGraph::buildOgdfGraphFromLayout(const QHash<QString, std::vector<QPointF> > & linePoints,
+                                             bool doubleMode)
+{
+    g_settings->doubleMode = doubleMode;
+    clearOgdfGraphAndResetNodes();
+
+    QHashIterator<QString, std::vector<QPointF> > i(linePoints);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = m_deBruijnGraphNodes.value(i.key(), 0);
+        if (node != 0)
+            node->setAsDrawn();
+    }
+
+    addDrawnNodesAndEdgesToOgdfGraph();
+
+    QHashIterator<QString, std::vector<QPointF> > j(linePoints);
+    while (j.hasNext())
+    {
+        j.next();
+        DeBruijnNode * node = m_deBruijnGraphNodes.value(j.key(), 0);
+        if (node == 0 || node->getOgdfNode() == 0)
+            continue;
+
+        const std::vector<ogdf::node> & ogdfNodes = node->getOgdfNode()->m_ogdfNodes;
+        const std::vector<QPointF> & points = j.value();
+        for (size_t k = 0; k < ogdfNodes.size(); ++k)
+        {
+            QPointF point = getLinePointForOgdfNode(points, k, ogdfNodes.size());
+            m_graphAttributes->x(ogdfNodes[k]) = point.x();
+            m_graphAttributes->y(ogdfNodes[k]) = point.y();
+        }
+    }
+}
+
+
+void AssemblyGraph::addDrawnNodesAndEdgesToOgdfGraph()
+{
     //First loop through each node, adding it to OGDF if it is drawn.
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
         if (i.value()->isDrawn())
-            i.value()->addToOgdfGraph(m_ogdfGraph);
+            i.value()->addToOgdfGraph(m_ogdfGraph, m_ogdfEdgeLengths);
     }
 
     //Then loop through each determining its drawn status and adding it
@@ -1453,7 +1835,10 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
 
 
 
-void AssemblyGraph::addGraphicsItemsToScene(MyGraphicsScene * scene)
+//If line points are given (from a layout file), they are used for the nodes
+//they include instead of the OGDF positions.
+void AssemblyGraph::addGraphicsItemsToScene(MyGraphicsScene * scene,
+                                            const QHash<QString, std::vector<QPointF> > * linePoints)
 {
     scene->clear();
 
@@ -1472,7 +1857,12 @@ void AssemblyGraph::addGraphicsItemsToScene(MyGraphicsScene * scene)
                 node->setReadDepthRelativeToMeanDrawnReadDepth(1.0);
             else
                 node->setReadDepthRelativeToMeanDrawnReadDepth(node->getReadDepth() / meanDrawnReadDepth);
-            GraphicsItemNode * graphicsItemNode = new GraphicsItemNode(node, m_graphAttributes);
+
+            GraphicsItemNode * graphicsItemNode;
+            if (linePoints != 0 && linePoints->contains(i.key()))
+                graphicsItemNode = new GraphicsItemNode(node, linePoints->value(i.key()));
+            else
+                graphicsItemNode = new GraphicsItemNode(node, m_graphAttributes);
             node->setGraphicsItemNode(graphicsItemNode);
             graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
             graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
@@ -1785,12 +2175,183 @@ QStringList AssemblyGraph::removeNullStringsFromList(QStringList in)
 void AssemblyGraph::layoutGraph()
 {
     ogdf::FMMMLayout fmmm;
-    GraphLayoutWorker * graphLayoutWorker = new GraphLayoutWorker(&fmmm, m_graphAttributes,
-                                                                  g_settings->graphLayoutQuality, g_settings->segmentLength);
+    GraphLayoutWorker * graphLayoutWorker = new GraphLayoutWorker(&fmmm, m_graphAttributes, m_ogdfEdgeLengths,
+                                                                  g_settings->graphLayoutQuality, g_settings->segmentLength,
+                                                                  g_settings->componentLayout, g_settings->coarsenChains,
+                                                                  g_settings->layoutSeed, g_settings->layoutAlgorithm);
     graphLayoutWorker->layoutGraph();
 }
 
 
+//This function makes a key for the current OGDF graph and the settings
+//that affect its layout, used to find the layout in the layout cache.
+//Everything goes in sorted by name, so the same drawn graph always gives
+//the same key.
+QString AssemblyGraph::getLayoutCacheKey() const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        if (node->inOgdf())
+        {
+            QString nodeKey = node->getName() + ":" + QString::number(node->getOgdfNode()->m_ogdfNodes.size()) + "\n";
+            hash.addData(nodeKey.toUtf8());
+        }
+    }
+
+    QStringList edgeKeys;
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
+    while (j.hasNext())
+    {
+        j.next();
+        DeBruijnEdge * edge = j.value();
+        if (edge->isDrawn())
+            edgeKeys.push_back(edge->getStartingNode()->getName() + ">" + edge->getEndingNode()->getName());
+    }
+    edgeKeys.sort();
+    hash.addData(edgeKeys.join("\n").toUtf8());
+
+    QString settingsKey = QString::number(g_settings->graphLayoutQuality) + " " +
+            QString::number(g_settings->segmentLength) + " " +
+            QString::number(g_settings->doubleMode) + " " +
+            QString::number(g_settings->componentLayout) + " " +
+            QString::number(g_settings->coarsenChains) + " " +
+            QString::number(g_settings->layoutSeed) + " " +
+            QString::number(g_settings->layoutAlgorithm);
+    hash.addData(settingsKey.toUtf8());
+
+    return QString(hash.result().toHex());
+}
+
+
+//These functions get and set the positions of all OGDF nodes as a flat
+//list of x and y values, in node name order.
+void AssemblyGraph::getOgdfNodePositions(std::vector<double> * positions) const
+{
+    positions->clear();
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        OgdfNode * ogdfNode = i.value()->getOgdfNode();
+        if (ogdfNode == 0)
+            continue;
+        for (size_t j = 0; j < ogdfNode->m_ogdfNodes.size(); ++j)
+        {
+            positions->push_back(m_graphAttributes->x(ogdfNode->m_ogdfNodes[j]));
+            positions->push_back(m_graphAttributes->y(ogdfNode->m_ogdfNodes[j]));
+        }
+    }
+}
+
+//Returns false (and changes nothing) if the number of positions doesn't
+//match the OGDF graph.
+bool AssemblyGraph::setOgdfNodePositions(const std::vector<double> & positions)
+{
+    if (positions.size() != size_t(m_ogdfGraph->numberOfNodes()) * 2)
+        return false;
+
+    size_t position = 0;
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        OgdfNode * ogdfNode = i.value()->getOgdfNode();
+        if (ogdfNode == 0)
+            continue;
+        for (size_t j = 0; j < ogdfNode->m_ogdfNodes.size(); ++j)
+        {
+            m_graphAttributes->x(ogdfNode->m_ogdfNodes[j]) = positions[position++];
+            m_graphAttributes->y(ogdfNode->m_ogdfNodes[j]) = positions[position++];
+        }
+    }
+    return true;
+}
+
+
+//These functions carry node positions over from one drawing of the graph
+//to the next, for incremental layout.  Positions are only restored to
+//nodes that are drawn with the same number of segments as before, and
+//those nodes are marked as fixed.  The number of fixed OGDF nodes is
+//returned.
+//The positions are taken from the graphics items, not the OGDF layout, so
+//nodes the user has dragged stay where they were dragged to.  In double
+//mode, a node and its complement are drawn either side of their shared
+//OGDF nodes, so their points are averaged.
+void AssemblyGraph::getOgdfNodePositionsByName(QHash<QString, std::vector<double> > * positions) const
+{
+    positions->clear();
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        OgdfNode * ogdfNode = node->getOgdfNode();
+        if (ogdfNode == 0)
+            continue;
+
+        GraphicsItemNode * graphicsItemNode = node->getGraphicsItemNode();
+        GraphicsItemNode * rcGraphicsItemNode = node->getReverseComplement()->getGraphicsItemNode();
+        if (graphicsItemNode == 0 && rcGraphicsItemNode == 0)
+            continue;
+
+        std::vector<QPointF> rcLinePoints;
+        if (rcGraphicsItemNode != 0)
+            rcLinePoints.assign(rcGraphicsItemNode->m_linePoints.rbegin(), rcGraphicsItemNode->m_linePoints.rend());
+
+        size_t ogdfNodeCount = ogdfNode->m_ogdfNodes.size();
+        std::vector<double> nodePositions;
+        for (size_t j = 0; j < ogdfNodeCount; ++j)
+        {
+            QPointF point;
+            if (graphicsItemNode != 0 && rcGraphicsItemNode != 0)
+                point = (getLinePointForOgdfNode(graphicsItemNode->m_linePoints, j, ogdfNodeCount) +
+                         getLinePointForOgdfNode(rcLinePoints, j, ogdfNodeCount)) / 2.0;
+            else if (graphicsItemNode != 0)
+                point = getLinePointForOgdfNode(graphicsItemNode->m_linePoints, j, ogdfNodeCount);
+            else
+                point = getLinePointForOgdfNode(rcLinePoints, j, ogdfNodeCount);
+            nodePositions.push_back(point.x());
+            nodePositions.push_back(point.y());
+        }
+        positions->insert(i.key(), nodePositions);
+    }
+}
+
+int AssemblyGraph::setOgdfNodePositionsByName(const QHash<QString, std::vector<double> > & positions,
+                                              ogdf::NodeArray<bool> * fixedNodes)
+{
+    int fixedCount = 0;
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        OgdfNode * ogdfNode = i.value()->getOgdfNode();
+        if (ogdfNode == 0)
+            continue;
+
+        QHash<QString, std::vector<double> >::const_iterator found = positions.constFind(i.key());
+        if (found == positions.constEnd() || found->size() != ogdfNode->m_ogdfNodes.size() * 2)
+            continue;
+
+        const std::vector<double> & nodePositions = found.value();
+        for (size_t j = 0; j < ogdfNode->m_ogdfNodes.size(); ++j)
+        {
+            ogdf::node node = ogdfNode->m_ogdfNodes[j];
+            m_graphAttributes->x(node) = nodePositions[j * 2];
+            m_graphAttributes->y(node) = nodePositions[j * 2 + 1];
+            (*fixedNodes)[node] = true;
+            ++fixedCount;
+        }
+    }
+    return fixedCount;
+}
+
+
 
 void AssemblyGraph::setAllEdgesExactOverlap(int overlap)
 {
@@ -1916,13 +2477,20 @@ QString AssemblyGraph::getOppositeNodeName(QString nodeName)
 
 void AssemblyGraph::readFastaFile(QString filename, std::vector<QString> * names, std::vector<QString> * sequences)
 {
-    QFile inputFile(filename);
+    GzipFile inputFile(filename);
     if (inputFile.open(QIODevice::ReadOnly))
+        readFastaFile(&inputFile, names, sequences);
+}
+
+
+void AssemblyGraph::readFastaFile(QIODevice * inputFile, std::vector<QString> * names, std::vector<QString> * sequences)
+{
+    if (inputFile->isOpen())
     {
         QString name = "";
         QString sequence = "";
 
-        QTextStream in(&inputFile);
+        QTextStream in(inputFile);
         while (!in.atEnd())
         {
             QApplication::processEvents();
@@ -1957,7 +2525,7 @@ void AssemblyGraph::readFastaFile(QString filename, std::vector<QString> * names
             sequences->push_back(sequence);
         }
 
-        inputFile.close();
+        inputFile->close();
     }
 }
 
@@ -1995,6 +2563,21 @@ void AssemblyGraph::recalculateAllNodeWidths()
 }
 
 
+//Edge bounding rectangles depend on the edge width setting, so when it
+//changes the scene needs to be told, which remaking their paths does.
+void AssemblyGraph::updateAllEdgeGeometry()
+{
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> i(m_deBruijnGraphEdges);
+    while (i.hasNext())
+    {
+        i.next();
+        GraphicsItemEdge * graphicsItemEdge = i.value()->getGraphicsItemEdge();
+        if (graphicsItemEdge != 0)
+            graphicsItemEdge->calculateAndSetPath();
+    }
+}
+
+
 bool AssemblyGraph::fileExists(QString path) {
     QFileInfo checkFile(path);
     // check if file exists and if yes: Is it really a file and no directory?
@@ -2014,6 +2597,7 @@ void AssemblyGraph::clearAllCsvData()
         i.next();
         i.value()->clearCsvData();
     }
+    m_csvTable.clear();
 }
 
 
@@ -2076,6 +2660,9 @@ void AssemblyGraph::deleteNodes(std::vector<DeBruijnNode *> * nodes)
     //Remove the edges from the graph,
     deleteEdges(&edgesToDelete);
 
+    //Drop any loaded paths that pass through the deleted nodes.
+    m_pathTable.removePathsWithNodes(QSet<DeBruijnNode *>::fromList(nodesToDelete));
+
     //Remove the nodes from the graph.
     for (int i = 0; i < nodesNamesToDelete.size(); ++i)
     {
@@ -2146,8 +2733,8 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * sce
     newNegNode->setCustomColour(originalNegNode->getCustomColour());
     newPosNode->setCustomLabel(originalPosNode->getCustomLabel());
     newNegNode->setCustomLabel(originalNegNode->getCustomLabel());
-    newPosNode->setCsvData(originalPosNode->getAllCsvData());
-    newNegNode->setCsvData(originalNegNode->getAllCsvData());
+    newPosNode->setCsvRow(originalPosNode->getCsvRow());
+    newNegNode->setCsvRow(originalNegNode->getCsvRow());
 
     m_deBruijnGraphNodes.insert(newPosNodeName, newPosNode);
     m_deBruijnGraphNodes.insert(newNegNodeName, newNegNode);
@@ -2818,6 +3405,124 @@ void AssemblyGraph::saveVisibleGraphToGfa(QString filename)
 
 
 
+//Layout files hold the drawn points of every node in the scene, so a
+//layout done once (e.g. on a big machine with Bandage image) can be drawn
+//again later without doing the layout.  They are tab-delimited text: a
+//header line saying whether the graph was drawn in single or double mode,
+//then one line per drawn node with its name and its points' x and y values.
+bool AssemblyGraph::saveLayout(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream out(&file);
+
+    out << "#Bandage layout\t" << (g_settings->doubleMode ? "double" : "single") << "\n";
+
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        GraphicsItemNode * graphicsItemNode = i.value()->getGraphicsItemNode();
+        if (graphicsItemNode == 0)
+            continue;
+
+        out << i.key();
+        for (size_t j = 0; j < graphicsItemNode->m_linePoints.size(); ++j)
+        {
+            QPointF point = graphicsItemNode->m_linePoints[j];
+            out << "\t" << QString::number(point.x(), 'f', 2) << "\t" << QString::number(point.y(), 'f', 2);
+        }
+        out << "\n";
+    }
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+
+bool AssemblyGraph::loadLayout(QString filename, QHash<QString, std::vector<QPointF> > * linePoints,
+                               bool * doubleMode, QString * errormsg)
+{
+    linePoints->clear();
+
+    GzipFile inputFile(filename);
+    if (!inputFile.open(QIODevice::ReadOnly))
+    {
+        *errormsg = "Unable to read from specified file.";
+        return false;
+    }
+    QTextStream in(&inputFile);
+
+    QStringList header = in.readLine().split("\t");
+    if (header.size() != 2 || header[0] != "#Bandage layout" ||
+            (header[1] != "single" && header[1] != "double"))
+    {
+        *errormsg = "The file is not a Bandage layout file.";
+        return false;
+    }
+    *doubleMode = (header[1] == "double");
+
+    while (!in.atEnd())
+    {
+        QString line = in.readLine();
+        if (line.isEmpty())
+            continue;
+
+        QStringList lineParts = line.split("\t");
+        QString nodeName = lineParts[0];
+        DeBruijnNode * node = m_deBruijnGraphNodes.value(nodeName, 0);
+        if (node == 0)
+        {
+            *errormsg = "The layout includes node " + nodeName + ", which is not in the graph.";
+            return false;
+        }
+        if (!*doubleMode && node->isNegativeNode())
+        {
+            *errormsg = "The layout is for single mode but includes the negative node " + nodeName + ".";
+            return false;
+        }
+
+        //Every node is drawn with at least one segment, so it has at least
+        //two points.
+        int valueCount = lineParts.size() - 1;
+        if (valueCount < 4 || valueCount % 2 != 0)
+        {
+            *errormsg = "The layout has the wrong number of values for node " + nodeName + ".";
+            return false;
+        }
+
+        std::vector<QPointF> points;
+        points.reserve(valueCount / 2);
+        for (int i = 1; i < lineParts.size(); i += 2)
+        {
+            bool xOk, yOk;
+            double x = lineParts[i].toDouble(&xOk);
+            double y = lineParts[i + 1].toDouble(&yOk);
+            if (!xOk || !yOk)
+            {
+                *errormsg = "The layout has a value that is not a number for node " + nodeName + ".";
+                return false;
+            }
+            points.push_back(QPointF(x, y));
+        }
+        linePoints->insert(nodeName, points);
+    }
+
+    if (inputFile.hasError())
+    {
+        *errormsg = inputFile.errorString();
+        return false;
+    }
+    if (linePoints->isEmpty())
+    {
+        *errormsg = "The layout does not include any nodes.";
+        return false;
+    }
+    return true;
+}
+
+
 
 //This function changes the name of a node pair.  The new and old names are
 //both assumed to not include the +/- at the end.
@@ -25,11 +25,18 @@
 #include "ogdf/basic/GraphAttributes.h"
 #include <QString>
 #include <QMap>
+#include <QHash>
+#include <QPointF>
+#include <QSharedPointer>
 #include "../program/globals.h"
 #include "../ui/mygraphicsscene.h"
 #include "path.h"
 #include <QFileInfo>
 #include "barcode.h"
+#include "csvtable.h"
+#include "pathtable.h"
+
+class GzipFile;
 
 
 class DeBruijnNode;
@@ -52,8 +59,15 @@ public:
     QMap<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> m_deBruijnGraphEdges;
 
 
+    //CSV data loaded for the nodes, stored by column.
+    CsvTable m_csvTable;
+
+    //Named paths loaded from the graph file.
+    PathTable m_pathTable;
+
     ogdf::Graph * m_ogdfGraph;
     ogdf::GraphAttributes * m_graphAttributes;
+    ogdf::EdgeArray<double> * m_ogdfEdgeLengths;
 
     int m_kmer;
     int m_nodeCount;
@@ -90,8 +104,11 @@ public:
     void buildDeBruijnGraphFromTrinityFasta(QString fullFileName);
     void recalculateAllReadDepthsRelativeToDrawnMean();
     void recalculateAllNodeWidths();
+    void updateAllEdgeGeometry();
 
     GraphFileType getGraphFileTypeFromFile(QString fullFileName);
+    void clearSniffedFile();
+    static GraphFileType getGraphFileTypeFromFileStart(const QByteArray & fileStart);
     bool checkFileIsLastGraph(QString fullFileName);
     bool checkFileIsFastG(QString fullFileName);
     bool checkFileIsFastG_barcode(QString fullFileName);
@@ -102,7 +119,10 @@ public:
     bool loadGraphFromFile(QString filename);
     void buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes,
                                          int nodeDistance);
-    void addGraphicsItemsToScene(MyGraphicsScene * scene);
+    void buildOgdfGraphFromLayout(const QHash<QString, std::vector<QPointF> > & linePoints,
+                                  bool doubleMode);
+    void addGraphicsItemsToScene(MyGraphicsScene * scene,
+                                 const QHash<QString, std::vector<QPointF> > * linePoints = 0);
 
     QStringList splitCsv(QString line, QString sep=",");
     bool loadCSV(QString filename, QStringList * columns,QString * errormsg);
@@ -119,12 +139,20 @@ public:
                                                    bool exactMatch,
                                                    std::vector<QString> * nodesNotInGraph = 0);
     void layoutGraph();
+    QString getLayoutCacheKey() const;
+    void getOgdfNodePositions(std::vector<double> * positions) const;
+    bool setOgdfNodePositions(const std::vector<double> & positions);
+    void getOgdfNodePositionsByName(QHash<QString, std::vector<double> > * positions) const;
+    int setOgdfNodePositionsByName(const QHash<QString, std::vector<double> > & positions,
+                                   ogdf::NodeArray<bool> * fixedNodes);
 
     void setAllEdgesExactOverlap(int overlap);
     void autoDetermineAllEdgesExactOverlap();
 
     static void readFastaFile(QString filename, std::vector<QString> * names,
                               std::vector<QString> * sequences);
+    static void readFastaFile(QIODevice * inputFile, std::vector<QString> * names,
+                              std::vector<QString> * sequences);
 
     int getDrawnNodeCount() const;
     void deleteNodes(std::vector<DeBruijnNode *> * nodes);
@@ -145,6 +173,9 @@ public:
     void saveEntireGraphToFastaOnlyPositiveNodes(QString filename);
     void saveEntireGraphToGfa(QString filename);
     void saveVisibleGraphToGfa(QString filename);
+    bool saveLayout(QString filename);
+    bool loadLayout(QString filename, QHash<QString, std::vector<QPointF> > * linePoints,
+                    bool * doubleMode, QString * errormsg);
     void changeNodeName(QString oldName, QString newName);
     NodeNameStatus checkNodeNameValidity(QString nodeName);
     void changeNodeReadDepth(std::vector<DeBruijnNode *> * nodes,
@@ -152,6 +183,12 @@ public:
 
 
 private:
+    //The file read by getGraphFileTypeFromFile is kept open, so the build
+    //function can carry on from the bytes already read.
+    QSharedPointer<GzipFile> m_sniffedFile;
+    QString m_sniffedFileName;
+
+    void addDrawnNodesAndEdgesToOgdfGraph();
     double getValueUsingFractionalIndex(std::vector<double> * doubleVector, double index);
     QString convertNormalNumberStringToBandageNodeName(QString number);
     void makeReverseComplementNodeIfNecessary(DeBruijnNode * node);
@@ -164,8 +201,13 @@ private:
     std::vector<int> makeOverlapCountVector();
     int getLengthFromCigar(QString cigar);
     int getCigarCount(QString cigarCode, QString cigar);
+    bool isGfaTag(QString part);
+    bool getEdgeFromGfa2EdgeLine(QStringList lineParts, QString * startingNode,
+                                 QString * endingNode, int * overlap);
+    QStringList getNodeNamesFromGfaWalk(QString walk);
     QString getOppositeNodeName(QString nodeName);
     bool fileExists(QString path);
+    QSharedPointer<GzipFile> openGraphFile(QString fullFileName);
 
 
 
@@ -0,0 +1,309 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "csvtable.h"
+#include <QtConcurrentMap>
+#include <QtNumeric>
+#include <limits>
+
+//Columns with fewer distinct values than this have their range found on
+//the calling thread, as farming them out would cost more than it saves.
+static const size_t PARALLEL_RANGE_THRESHOLD = 100000;
+static const size_t RANGE_CHUNK_SIZE = 65536;
+
+struct CsvValueChunk
+{
+    const std::vector<double> * values;
+    const std::vector<bool> * isNumber;
+    size_t start;
+    size_t end;
+};
+
+struct CsvValueRange
+{
+    CsvValueRange() : min(std::numeric_limits<double>::max()),
+        max(std::numeric_limits<double>::lowest()) {}
+    double min;
+    double max;
+};
+
+static CsvValueRange getChunkRange(const CsvValueChunk & chunk)
+{
+    CsvValueRange range;
+    for (size_t i = chunk.start; i < chunk.end; ++i)
+    {
+        if (!(*chunk.isNumber)[i])
+            continue;
+        double value = (*chunk.values)[i];
+        if (value < range.min)
+            range.min = value;
+        if (value > range.max)
+            range.max = value;
+    }
+    return range;
+}
+
+static void combineRanges(CsvValueRange & result, const CsvValueRange & chunkRange)
+{
+    if (chunkRange.min < result.min)
+        result.min = chunkRange.min;
+    if (chunkRange.max > result.max)
+        result.max = chunkRange.max;
+}
+
+
+
+CsvTable::CsvTable() :
+    m_rowCount(0), m_colourColumn(-1), m_colourMinValue(0.0), m_colourMaxValue(0.0)
+{
+}
+
+
+void CsvTable::clear()
+{
+    m_columns.clear();
+    m_rowCount = 0;
+    m_colourColumn = -1;
+    m_categoryColours.clear();
+}
+
+
+void CsvTable::setColumnNames(QStringList columnNames)
+{
+    clear();
+    m_columns.resize(columnNames.size());
+    for (int i = 0; i < columnNames.size(); ++i)
+    {
+        m_columns[i].name = columnNames[i];
+        m_columns[i].numeric = false;
+    }
+}
+
+
+//This function adds one row of cells to the table and returns its index.
+//Cells beyond the number of columns are ignored and missing cells are
+//stored as empty.
+int CsvTable::addRow(const QStringList & cells)
+{
+    for (size_t i = 0; i < m_columns.size(); ++i)
+    {
+        CsvColumn * column = &m_columns[i];
+
+        int category = -1;
+        if (int(i) < cells.size() && !cells[i].isEmpty())
+        {
+            const QString & cell = cells[i];
+            QHash<QString, int>::const_iterator found = column->categoryLookup.constFind(cell);
+            if (found != column->categoryLookup.constEnd())
+                category = found.value();
+            else
+            {
+                category = column->categories.size();
+                column->categories.push_back(cell);
+                column->categoryLookup.insert(cell, category);
+            }
+        }
+        column->rowCategories.push_back(category);
+    }
+
+    return m_rowCount++;
+}
+
+
+//This function is called after the last row is added.  It parses each
+//distinct cell value as a number once and decides which columns are
+//numeric: those with at least one value where every value is a number.
+//Values like "nan" and "inf" aren't counted as numbers, as they can't be
+//placed on a colour gradient.
+void CsvTable::finishLoading()
+{
+    for (size_t i = 0; i < m_columns.size(); ++i)
+    {
+        CsvColumn * column = &m_columns[i];
+        column->categoryLookup.clear();
+
+        int categoryCount = column->categories.size();
+        column->categoryValues.resize(categoryCount);
+        column->categoryIsNumber.resize(categoryCount);
+
+        bool allNumbers = true;
+        for (int j = 0; j < categoryCount; ++j)
+        {
+            bool ok;
+            column->categoryValues[j] = column->categories[j].trimmed().toDouble(&ok);
+            ok = ok && qIsFinite(column->categoryValues[j]);
+            column->categoryIsNumber[j] = ok;
+            if (!ok)
+                allNumbers = false;
+        }
+        column->numeric = (categoryCount > 0 && allNumbers);
+    }
+}
+
+
+QStringList CsvTable::getColumnNames() const
+{
+    QStringList columnNames;
+    for (size_t i = 0; i < m_columns.size(); ++i)
+        columnNames.push_back(m_columns[i].name);
+    return columnNames;
+}
+
+
+QString CsvTable::getColumnName(int column) const
+{
+    if (column < 0 || column >= getColumnCount())
+        return "";
+    return m_columns[column].name;
+}
+
+
+bool CsvTable::isValidCell(int row, int column) const
+{
+    return row >= 0 && row < m_rowCount && column >= 0 && column < getColumnCount();
+}
+
+
+QString CsvTable::getString(int row, int column) const
+{
+    int category = getCategory(row, column);
+    if (category < 0)
+        return "";
+    return m_columns[column].categories[category];
+}
+
+
+bool CsvTable::hasValue(int row, int column) const
+{
+    int category = getCategory(row, column);
+    if (category < 0 || category >= int(m_columns[column].categoryIsNumber.size()))
+        return false;
+    return m_columns[column].categoryIsNumber[category];
+}
+
+
+//This function returns the cell as a number, or 0.0 if it isn't one.
+double CsvTable::getValue(int row, int column) const
+{
+    if (!hasValue(row, column))
+        return 0.0;
+    return m_columns[column].categoryValues[getCategory(row, column)];
+}
+
+
+//This function returns the index of the cell's distinct value within its
+//column, or -1 for an empty cell.
+int CsvTable::getCategory(int row, int column) const
+{
+    if (!isValidCell(row, column))
+        return -1;
+    return m_columns[column].rowCategories[row];
+}
+
+
+int CsvTable::getCategoryCount(int column) const
+{
+    if (column < 0 || column >= getColumnCount())
+        return 0;
+    return m_columns[column].categories.size();
+}
+
+
+bool CsvTable::isColumnNumeric(int column) const
+{
+    if (column < 0 || column >= getColumnCount())
+        return false;
+    return m_columns[column].numeric;
+}
+
+
+//This function prepares the colours for the given column.  Numeric columns
+//are coloured with a gradient from the lowest to the highest value in the
+//column.  Other columns get a distinct hue for each distinct value.
+void CsvTable::determineColours(int column, QColor lowColour, QColor highColour,
+                                int saturation, int lightness)
+{
+    m_categoryColours.clear();
+    m_colourColumn = -1;
+    if (column < 0 || column >= getColumnCount())
+        return;
+    m_colourColumn = column;
+
+    const CsvColumn * csvColumn = &m_columns[column];
+    size_t categoryCount = csvColumn->categories.size();
+    m_categoryColours.resize(categoryCount);
+
+    if (csvColumn->numeric)
+    {
+        std::vector<CsvValueChunk> chunks;
+        size_t chunkSize = categoryCount < PARALLEL_RANGE_THRESHOLD ? categoryCount : RANGE_CHUNK_SIZE;
+        for (size_t start = 0; start < categoryCount; start += chunkSize)
+        {
+            CsvValueChunk chunk;
+            chunk.values = &csvColumn->categoryValues;
+            chunk.isNumber = &csvColumn->categoryIsNumber;
+            chunk.start = start;
+            chunk.end = qMin(start + chunkSize, categoryCount);
+            chunks.push_back(chunk);
+        }
+
+        CsvValueRange range;
+        if (chunks.size() == 1)
+            range = getChunkRange(chunks[0]);
+        else
+            range = QtConcurrent::blockingMappedReduced<CsvValueRange>(chunks, getChunkRange, combineRanges);
+        m_colourMinValue = range.min;
+        m_colourMaxValue = range.max;
+
+        double valueRange = m_colourMaxValue - m_colourMinValue;
+        for (size_t i = 0; i < categoryCount; ++i)
+        {
+            double fraction = 0.5;
+            if (valueRange > 0.0)
+                fraction = (csvColumn->categoryValues[i] - m_colourMinValue) / valueRange;
+
+            int red = int(lowColour.red() + fraction * (highColour.red() - lowColour.red()) + 0.5);
+            int green = int(lowColour.green() + fraction * (highColour.green() - lowColour.green()) + 0.5);
+            int blue = int(lowColour.blue() + fraction * (highColour.blue() - lowColour.blue()) + 0.5);
+            int alpha = int(lowColour.alpha() + fraction * (highColour.alpha() - lowColour.alpha()) + 0.5);
+            m_categoryColours[i] = QColor(red, green, blue, alpha);
+        }
+    }
+
+    //Stepping the hue by the golden angle keeps neighbouring categories
+    //well apart, however many categories there are.
+    else
+    {
+        m_colourMinValue = 0.0;
+        m_colourMaxValue = 0.0;
+        for (size_t i = 0; i < categoryCount; ++i)
+        {
+            int hue = int(i * 137.508) % 360;
+            m_categoryColours[i].setHsl(hue, saturation, lightness);
+        }
+    }
+}
+
+
+QColor CsvTable::getColour(int row, QColor noDataColour) const
+{
+    int category = getCategory(row, m_colourColumn);
+    if (category < 0 || category >= int(m_categoryColours.size()))
+        return noDataColour;
+    return m_categoryColours[category];
+}
@@ -0,0 +1,88 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CSVTABLE_H
+#define CSVTABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <vector>
+#include <QColor>
+
+//CsvTable holds the data loaded from a CSV file, stored by column.  Each
+//node with CSV data just keeps the index of its row in this table.
+//Each column stores its distinct cell values once and refers to them by
+//index, so annotation files with many repetitive columns stay small.  Cells
+//are also parsed as numbers once, when loading is finished, so a column
+//can be used as numbers without any further string parsing.
+
+class CsvTable
+{
+public:
+    CsvTable();
+
+    void clear();
+    void setColumnNames(QStringList columnNames);
+    int addRow(const QStringList & cells);
+    void finishLoading();
+
+    int getColumnCount() const {return int(m_columns.size());}
+    int getRowCount() const {return m_rowCount;}
+    QStringList getColumnNames() const;
+    QString getColumnName(int column) const;
+    bool isValidCell(int row, int column) const;
+
+    QString getString(int row, int column) const;
+    bool hasValue(int row, int column) const;
+    double getValue(int row, int column) const;
+    int getCategory(int row, int column) const;
+    int getCategoryCount(int column) const;
+    bool isColumnNumeric(int column) const;
+
+    void determineColours(int column, QColor lowColour, QColor highColour,
+                          int saturation, int lightness);
+    int getColourColumn() const {return m_colourColumn;}
+    QColor getColour(int row, QColor noDataColour) const;
+    double getColourMinValue() const {return m_colourMinValue;}
+    double getColourMaxValue() const {return m_colourMaxValue;}
+
+private:
+    struct CsvColumn
+    {
+        QString name;
+        QStringList categories;
+        QHash<QString, int> categoryLookup;
+        std::vector<int> rowCategories;
+        std::vector<double> categoryValues;
+        std::vector<bool> categoryIsNumber;
+        bool numeric;
+    };
+
+    std::vector<CsvColumn> m_columns;
+    int m_rowCount;
+
+    //Colours are worked out once for each distinct value in the colour
+    //column, so looking up a node's colour is just an index.
+    int m_colourColumn;
+    std::vector<QColor> m_categoryColours;
+    double m_colourMinValue;
+    double m_colourMaxValue;
+};
+
+#endif // CSVTABLE_H
@@ -28,6 +28,10 @@
 #include <set>
 #include <QApplication>
 
+//When node segments are capped, nodes with more segments than this have
+//their extra segments grow logarithmically in the OGDF graph.
+static const int SEGMENT_CAP = 10;
+
 DeBruijnNode::DeBruijnNode(QString name, double readDepth, QByteArray sequence) :
     m_name(name),
     m_readDepth(readDepth),
@@ -41,7 +45,7 @@ DeBruijnNode::DeBruijnNode(QString name, double readDepth, QByteArray sequence)
     m_drawn(false),
     m_highestDistanceInNeighbourSearch(0),
     m_customColour(QColor(190, 190, 190)),
-    m_csvData()
+    m_csvRow(-1)
 {
 }
 
@@ -54,6 +58,13 @@ DeBruijnNode::~DeBruijnNode()
 
 
 
+//CSV data is held in the graph's CSV table - the node only knows its row.
+QString DeBruijnNode::getCsvLine(int i) const
+{
+    return g_assemblyGraph->m_csvTable.getString(m_csvRow, i);
+}
+
+
 //This function adds an edge to the Node, but only if the edge hasn't already
 //been added.
 void DeBruijnNode::addEdge(DeBruijnEdge * edge)
@@ -85,7 +96,7 @@ void DeBruijnNode::resetNode()
 }
 
 
-void DeBruijnNode::addToOgdfGraph(ogdf::Graph * ogdfGraph)
+void DeBruijnNode::addToOgdfGraph(ogdf::Graph * ogdfGraph, ogdf::EdgeArray<double> * edgeLengths)
 {
     //If this node or its reverse complement is already in OGDF, then
     //it's not necessary to make the node.
@@ -97,11 +108,11 @@ void DeBruijnNode::addToOgdfGraph(ogdf::Graph * ogdfGraph)
 
     //Each node in the Velvet sense is made up of multiple nodes in the
     //OGDF sense.  This way, Velvet nodes appear as lines whose length
-    //corresponds to the sequence length.
-    int numberOfGraphEdges = ceil(double(getLength()) / getBasePairsPerSegment());
-    if (numberOfGraphEdges == 0)
-        numberOfGraphEdges = 1;
+    //corresponds to the sequence length.  When long nodes are capped, they
+    //get fewer but longer OGDF edges, so their laid out length is the same.
+    int numberOfGraphEdges = getOgdfSegmentCount();
     int numberOfGraphNodes = numberOfGraphEdges + 1;
+    double graphEdgeLength = double(getDrawnSegmentCount()) / numberOfGraphEdges;
 
     ogdf::node newNode = 0;
     ogdf::node previousNode = 0;
@@ -111,7 +122,10 @@ void DeBruijnNode::addToOgdfGraph(ogdf::Graph * ogdfGraph)
         m_ogdfNode->addOgdfNode(newNode);
 
         if (i > 0)
-            ogdfGraph->newEdge(previousNode, newNode);
+        {
+            ogdf::edge newEdge = ogdfGraph->newEdge(previousNode, newNode);
+            (*edgeLengths)[newEdge] = graphEdgeLength;
+        }
 
         previousNode = newNode;
     }
@@ -687,6 +701,30 @@ int DeBruijnNode::getBasePairsPerSegment() const
 
 
 
+//This function returns the number of segments the node is drawn with.
+int DeBruijnNode::getDrawnSegmentCount() const
+{
+    int segmentCount = ceil(double(getLength()) / getBasePairsPerSegment());
+    if (segmentCount == 0)
+        segmentCount = 1;
+    return segmentCount;
+}
+
+
+//This function returns the number of segments the node has in the OGDF
+//graph.  Normally this is the same as the number drawn, but if the node
+//segments are capped, nodes above the cap only grow logarithmically.  A
+//contig drawn with 10000 segments is then laid out with about 80, which is
+//enough for it to bend around its neighbours.
+int DeBruijnNode::getOgdfSegmentCount() const
+{
+    int segmentCount = getDrawnSegmentCount();
+    if (!g_settings->capNodeSegments || segmentCount <= SEGMENT_CAP)
+        return segmentCount;
+    return SEGMENT_CAP + int(ceil(SEGMENT_CAP * log(double(segmentCount) / SEGMENT_CAP)));
+}
+
+
 bool DeBruijnNode::isInReadDepthRange(double min, double max) const
 {
     return m_readDepth >= min && m_readDepth <= max;
@@ -91,10 +91,12 @@ public:
     std::vector<BlastHitPart> getBlastHitPartsForThisNodeOrReverseComplement(double scaledNodeLength) const;
     std::vector<BarcodePart> getBarcodePartsForThisNodeOrReverseComplement(double scaledNodeLength) const;
 
-    bool hasCsvData() const {return !m_csvData.isEmpty();}
-    QStringList getAllCsvData() const {return m_csvData;}
-    QString getCsvLine(int i) const {if (i < m_csvData.length()) return m_csvData[i]; else return "";}
+    bool hasCsvData() const {return m_csvRow >= 0;}
+    int getCsvRow() const {return m_csvRow;}
+    QString getCsvLine(int i) const;
     bool isInReadDepthRange(double min, double max) const;
+    int getDrawnSegmentCount() const;
+    int getOgdfSegmentCount() const;
 
     //MODIFERS
     void setReadDepthRelativeToMeanDrawnReadDepth(double newVal) {m_readDepthRelativeToMeanDrawnReadDepth = newVal;}
@@ -112,14 +114,14 @@ public:
     void resetNode();
     void addEdge(DeBruijnEdge * edge);
     void removeEdge(DeBruijnEdge * edge);
-    void addToOgdfGraph(ogdf::Graph * ogdfGraph);
+    void addToOgdfGraph(ogdf::Graph * ogdfGraph, ogdf::EdgeArray<double> * edgeLengths);
     void determineContiguity();
     void clearBlastHits() {m_blastHits.clear();}
     void addBlastHit(BlastHit * newHit) {m_blastHits.push_back(newHit);}
     void labelNeighbouringNodesAsDrawn(int nodeDistance, DeBruijnNode * callingNode);
     void addBarcode(Barcode * bc) { m_barcodes.push_back(bc) ;}
-    void setCsvData(QStringList csvData) {m_csvData = csvData;}
-    void clearCsvData() {m_csvData.clear();}
+    void setCsvRow(int csvRow) {m_csvRow = csvRow;}
+    void clearCsvData() {m_csvRow = -1;}
     void setReadDepth(double newReadDepth) {m_readDepth = newReadDepth;}
     void setName(QString newName) {m_name = newName;}
 
@@ -139,7 +141,7 @@ private:
     QColor m_customColour;
     QString m_customLabel;
     std::vector<BlastHit *> m_blastHits;
-    QStringList m_csvData;
+    int m_csvRow;
     QString getNodeNameForFasta() const;
     QByteArray getUpstreamSequence(int upstreamSequenceLength) const;
 
@@ -21,21 +21,43 @@
 #include <QPainterPathStroker>
 #include <QPainter>
 #include <QPen>
+#include <QStyleOptionGraphicsItem>
 #include "../program/globals.h"
 #include "../program/settings.h"
+#include "../program/memory.h"
 #include "debruijnnode.h"
 #include "ogdfnode.h"
 #include <QLineF>
 #include "graphicsitemnode.h"
+#include "../ui/mygraphicsscene.h"
+#include "../ui/edgebundler.h"
 
 GraphicsItemEdge::GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem * parent) :
-    QGraphicsPathItem(parent), m_deBruijnEdge(deBruijnEdge)
+    QGraphicsPathItem(parent), m_deBruijnEdge(deBruijnEdge), m_bundleLeader(0)
 
 {
     calculateAndSetPath();
 }
 
 
+//The other edges in this edge's bundle must not keep a pointer to it.  The
+//scene may be being destroyed, so this doesn't redraw anything.
+GraphicsItemEdge::~GraphicsItemEdge()
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+        graphicsScene->invalidateEdgeBundles();
+
+    if (m_bundleLeader == 0)
+        return;
+    GraphicsItemEdge * leader = m_bundleLeader;
+    for (size_t i = 0; i < leader->m_bundleMembers.size(); ++i)
+        leader->m_bundleMembers[i]->m_bundleLeader = 0;
+    leader->m_bundleMembers.clear();
+    leader->m_bundlePath = QPainterPath();
+}
+
+
 
 QPointF GraphicsItemEdge::extendLine(QPointF start, QPointF end, double extensionLength)
 {
@@ -46,6 +68,9 @@ QPointF GraphicsItemEdge::extendLine(QPointF start, QPointF end, double extensio
 }
 
 
+//When edge bundling is on and the view is zoomed out, a bundle's leader
+//draws the bundle's path in place of all its members, and edges shorter
+//than a pixel aren't drawn.  Selected edges are always drawn themselves.
 void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
     double edgeWidth = g_settings->edgeWidth;
@@ -56,6 +81,26 @@ void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem
         penColour = g_settings->edgeColour;
     QPen edgePen(QBrush(penColour), edgeWidth, Qt::SolidLine, Qt::RoundCap);
     painter->setPen(edgePen);
+
+    double zoom = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (g_settings->edgeBundling && !isSelected() && !g_memory->fullDetailPainting &&
+            EdgeBundler::isLowZoom(zoom))
+    {
+        if (m_bundleLeader == this)
+        {
+            painter->drawPath(m_bundlePath);
+            return;
+        }
+
+        //A selected leader only draws itself, so the other members must then
+        //draw themselves too.
+        if (m_bundleLeader != 0 && !m_bundleLeader->isSelected())
+            return;
+        QRectF pathRect = path().controlPointRect();
+        if (qMax(pathRect.width(), pathRect.height()) * zoom < 1.0)
+            return;
+    }
+
     painter->drawPath(path());
 }
 
@@ -72,8 +117,88 @@ QPainterPath GraphicsItemEdge::shape() const
 
 
 
+//QGraphicsPathItem's bounding rectangle allows for its own pen, not the
+//edge width setting the edge is drawn with.  The view only redraws the
+//bounding rectangles of changed items, so the whole width is included.
+QRectF GraphicsItemEdge::boundingRect() const
+{
+    double extraSize = g_settings->edgeWidth / 2.0;
+    QRectF rect = path().controlPointRect();
+    if (!m_bundlePath.isEmpty())
+        rect = rect.united(m_bundlePath.controlPointRect());
+    return rect.adjusted(-extraSize, -extraSize, extraSize, extraSize);
+}
+
+
+//The scene's index holds the edge's flattened path, so it must be made
+//again when the edge moves or is added to or removed from the scene.
+void GraphicsItemEdge::invalidateSceneIndex()
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+        graphicsScene->invalidateIndex();
+}
+
+
+//This function makes the edge the leader of a bundle, drawn with the given
+//path.  The members include the leader itself.
+void GraphicsItemEdge::setBundle(const QPainterPath & bundlePath,
+                                 const std::vector<GraphicsItemEdge *> & members)
+{
+    prepareGeometryChange();
+    m_bundlePath = bundlePath;
+    m_bundleMembers = members;
+    for (size_t i = 0; i < members.size(); ++i)
+        members[i]->m_bundleLeader = this;
+    update();
+}
+
+
+void GraphicsItemEdge::dissolveBundle()
+{
+    if (m_bundleLeader == 0)
+        return;
+
+    GraphicsItemEdge * leader = m_bundleLeader;
+    for (size_t i = 0; i < leader->m_bundleMembers.size(); ++i)
+    {
+        GraphicsItemEdge * member = leader->m_bundleMembers[i];
+        member->m_bundleLeader = 0;
+        member->update();
+    }
+    leader->prepareGeometryChange();
+    leader->m_bundleMembers.clear();
+    leader->m_bundlePath = QPainterPath();
+}
+
+
+//An edge that moves or leaves the scene breaks up its bundle straight away,
+//and the scene's bundles are found again when next needed.
+void GraphicsItemEdge::leaveBundle()
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+        graphicsScene->invalidateEdgeBundles();
+    dissolveBundle();
+}
+
+
+QVariant GraphicsItemEdge::itemChange(GraphicsItemChange change, const QVariant & value)
+{
+    if (change == ItemSceneChange || change == ItemSceneHasChanged)
+    {
+        invalidateSceneIndex();
+        leaveBundle();
+    }
+    return QGraphicsPathItem::itemChange(change, value);
+}
+
+
+
 void GraphicsItemEdge::calculateAndSetPath()
 {
+    invalidateSceneIndex();
+    leaveBundle();
     setControlPointLocations();
 
     double edgeDistance = QLineF(m_startingLocation, m_endingLocation).length();
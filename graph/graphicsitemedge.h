@@ -26,6 +26,7 @@
 #include <ogdf/basic/Graph.h>
 #include <ogdf/basic/GraphAttributes.h>
 #include <QPointF>
+#include <vector>
 
 class DeBruijnEdge;
 
@@ -33,6 +34,7 @@ class GraphicsItemEdge : public QGraphicsPathItem
 {
 public:
     GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem * parent = 0);
+    ~GraphicsItemEdge();
 
     DeBruijnEdge * m_deBruijnEdge;
     QPointF m_startingLocation;
@@ -42,8 +44,16 @@ public:
     QPointF m_controlPoint1;
     QPointF m_controlPoint2;
 
+    //When zoomed out, parallel edges may be drawn as one bundle by its first
+    //edge (the leader), which holds the bundle's members and path.
+    GraphicsItemEdge * m_bundleLeader;
+    std::vector<GraphicsItemEdge *> m_bundleMembers;
+    QPainterPath m_bundlePath;
+
     void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *);
+    QVariant itemChange(GraphicsItemChange change, const QVariant & value);
     QPainterPath shape() const;
+    QRectF boundingRect() const;
     QPointF extendLine(QPointF start, QPointF end, double extensionLength);
     void calculateAndSetPath();
     void setControlPointLocations();
@@ -51,6 +61,12 @@ public:
     void setEndingPoints(QPointF endingLocation, QPointF afterEndingLocation) {m_endingLocation = endingLocation; m_afterEndingLocation = afterEndingLocation;}
     void makeSpecialPathConnectingNodeToSelf();
     void makeSpecialPathConnectingNodeToReverseComplement();
+    void setBundle(const QPainterPath & bundlePath, const std::vector<GraphicsItemEdge *> & members);
+    void dissolveBundle();
+
+private:
+    void invalidateSceneIndex();
+    void leaveBundle();
 };
 
 #endif // GRAPHICSITEMEDGE_H
@@ -38,18 +38,29 @@
 #include "../ui/mygraphicsview.h"
 #include <QTransform>
 #include "../blast/blasthit.h"
+#include <QStyleOptionGraphicsItem>
 #include "../blast/blastquery.h"
 #include "../blast/blasthitpart.h"
 #include "assemblygraph.h"
 #include <cmath>
 #include <QFontMetrics>
 #include "../program/memory.h"
+#include "labelcache.h"
 #include <QDebug>
+#include <QHash>
+#include <map>
+#include <algorithm>
+
+//Coloured part paths are made again when the zoom changes by more than this
+//many steps per doubling of the zoom.
+static const double PART_PATH_ZOOM_STEPS_PER_DOUBLING = 4.0;
+
+int GraphicsItemNode::s_colouredPartPathsGeneration = 0;
 
 GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
                                    ogdf::GraphAttributes * graphAttributes, QGraphicsItem * parent) :
     QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
-    m_hasArrow(g_settings->doubleMode)
+    m_hasArrow(g_settings->doubleMode), m_outlineValid(false), m_simplifiedOutlineValid(false)
 
 {
     setWidth();
@@ -75,6 +86,12 @@ GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
         }
     }
 
+    //Nodes with capped segments were laid out with fewer points than they
+    //are drawn with, so the missing points are filled in along a curve.
+    int drawnSegmentCount = deBruijnNode->getDrawnSegmentCount();
+    if (int(m_linePoints.size()) - 1 < drawnSegmentCount)
+        m_linePoints = makeSmoothCurve(m_linePoints, drawnSegmentCount);
+
     //If we are in double mode and this node's complement is also drawn,
     //then we should shift the points so the two nodes are not drawn directly
     //on top of each other.
@@ -92,7 +109,8 @@ GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
                                    QGraphicsItem * parent) :
     QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
     m_hasArrow(toCopy->m_hasArrow),
-    m_linePoints(toCopy->m_linePoints)
+    m_linePoints(toCopy->m_linePoints),
+    m_outlineValid(false), m_simplifiedOutlineValid(false)
 {
     setWidth();
     remakePath();
@@ -105,7 +123,8 @@ GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
                                    QGraphicsItem * parent) :
     QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
     m_hasArrow(g_settings->doubleMode),
-    m_linePoints(linePoints)
+    m_linePoints(linePoints),
+    m_outlineValid(false), m_simplifiedOutlineValid(false)
 {
     setWidth();
     remakePath();
@@ -121,96 +140,33 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
 //    painter->setPen(QPen(Qt::black, 1.0));
 //    painter->drawRect(boundingRect());
 
-    QPainterPath outlinePath = shape();
-
-    //Fill the node's colour
-    QBrush brush(m_colour);
-    painter->fillPath(outlinePath, brush);
+    //When a node is only a few pixels wide on screen, its outline and
+    //arrowhead can't be seen, so it is drawn as a plain line instead.
+    double zoom = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    bool lowDetail = !g_memory->fullDetailPainting && m_width * zoom < g_settings->lowDetailNodeWidth;
 
-    bool nodeHasBlastHits;
-    if (g_settings->doubleMode)
-        nodeHasBlastHits = m_deBruijnNode->thisNodeHasBlastHits();
+    QPainterPath outlinePath;
+    if (lowDetail)
+        drawLowDetailNode(painter);
     else
-        nodeHasBlastHits = m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits();
-
-    //If the node contains a BLAST hit, draw that on top.
-    if (nodeHasBlastHits && (g_settings->nodeColourScheme == BLAST_HITS_RAINBOW_COLOUR ||
-            g_settings->nodeColourScheme == BLAST_HITS_SOLID_COLOUR))
     {
-        std::vector<BlastHitPart> parts;
-
-        //The scaled node length is passed to the function which makes the
-        //BlastHitPart objects, because we don't want those parts to be much
-        //less than 1 pixel in size, which isn't necessary and can cause weird
-        //visual artefacts.
-        double scaledNodeLength = getNodePathLength() * g_absoluteZoom;
-
-        if (g_settings->doubleMode)
-        {
-            if (m_deBruijnNode->thisNodeHasBlastHits())
-                parts = m_deBruijnNode->getBlastHitPartsForThisNode(scaledNodeLength);
-        }
-        else
-        {
-            if (m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits())
-                parts = m_deBruijnNode->getBlastHitPartsForThisNodeOrReverseComplement(scaledNodeLength);
-        }
-
-        QPen partPen;
-        partPen.setWidthF(m_width);
-        partPen.setCapStyle(Qt::FlatCap);
-        partPen.setJoinStyle(Qt::BevelJoin);
-
-        //If the node has an arrow, then it's necessary to use the outline
-        //as a clipping path so the colours don't extend past the edge of the
-        //node.
-        if (m_hasArrow)
-            painter->setClipPath(outlinePath);
+        outlinePath = shape();
 
-        for (size_t i = 0; i < parts.size(); ++i)
-        {
-            partPen.setColor(parts[i].m_colour);
-            painter->setPen(partPen);
-
-            painter->drawPath(makePartialPath(parts[i].m_nodeFractionStart,
-                                              parts[i].m_nodeFractionEnd));
-        }
-        painter->setClipping(false);
+        //Fill the node's colour
+        QBrush brush(m_colour);
+        painter->fillPath(outlinePath, brush);
     }
 
-    bool nodeHasBarcode;
+    bool nodeHasBlastHits;
     if (g_settings->doubleMode)
-        nodeHasBarcode = m_deBruijnNode->thisNodeHasBarcode();
+        nodeHasBlastHits = m_deBruijnNode->thisNodeHasBlastHits();
     else
-        nodeHasBarcode = m_deBruijnNode->thisNodeOrReverseComplementHasBarcode();
-    //qDebug() << nodeHasBarcode;
-    //qDebug() << "want to draw";
-    //qDebug() << g_settings->nodeColourScheme;
+        nodeHasBlastHits = m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits();
 
-    if (nodeHasBarcode && (g_settings->nodeColourScheme == BARCODE_COLOR))
+    //If the node contains BLAST hits or barcodes, draw them on top.
+    const std::vector<ColouredPartPath> & partPaths = getColouredPartPaths(zoom, lowDetail);
+    if (!partPaths.empty())
     {
-        std::vector<BarcodePart> parts;
-        //qDebug() << "has barcode";
-        //The scaled node length is passed to the function which makes the
-        //BlastHitPart objects, because we don't want those parts to be much
-        //less than 1 pixel in size, which isn't necessary and can cause weird
-        //visual artefacts.
-        double scaledNodeLength = getNodePathLength() * g_absoluteZoom;
-
-        if (g_settings->doubleMode)
-        {
-            if (m_deBruijnNode->thisNodeHasBarcode())
-                parts = m_deBruijnNode->getBarcodePartsForThisNode(scaledNodeLength);
-
-        }
-        else //single mode
-        {
-            if (m_deBruijnNode->thisNodeOrReverseComplementHasBarcode())
-                parts = m_deBruijnNode->getBarcodePartsForThisNodeOrReverseComplement(scaledNodeLength);
-        }
-
-        //qDebug()<<parts.size();
-
         QPen partPen;
         partPen.setWidthF(m_width);
         partPen.setCapStyle(Qt::FlatCap);
@@ -219,16 +175,14 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
         //If the node has an arrow, then it's necessary to use the outline
         //as a clipping path so the colours don't extend past the edge of the
         //node.
-        if (m_hasArrow)
+        if (m_hasArrow && !lowDetail)
             painter->setClipPath(outlinePath);
 
-        for (size_t i = 0; i < parts.size(); ++i)
+        for (size_t i = 0; i < partPaths.size(); ++i)
         {
-            partPen.setColor(parts[i].m_colour);
+            partPen.setColor(partPaths[i].colour);
             painter->setPen(partPen);
-
-            painter->drawPath(makePartialPath(parts[i].m_nodeFractionStart,
-                                              parts[i].m_nodeFractionEnd));
+            painter->drawPath(partPaths[i].path);
         }
         painter->setClipping(false);
     }
@@ -243,13 +197,12 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
         outlineColour = g_settings->selectionColour;
         outlineThickness = g_settings->selectionThickness;
     }
-    if (outlineThickness > 0.0)
+    if (outlineThickness > 0.0 && !lowDetail)
     {
-        outlinePath = outlinePath.simplified();
         QPen outlinePen(QBrush(outlineColour), outlineThickness, Qt::SolidLine,
                         Qt::SquareCap, Qt::RoundJoin);
         painter->setPen(outlinePen);
-        painter->drawPath(outlinePath);
+        painter->drawPath(getSimplifiedOutline());
     }
 
 
@@ -263,22 +216,14 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
         queryPathHighlightNode(painter);
 
 
+    //Labels too small to read on screen are left out.
+    bool labelsReadable = g_memory->fullDetailPainting ||
+            LabelCache::getLineHeight() * zoom >= g_settings->minimumLabelHeight;
+
     //Draw node labels if there are any to display.
-    if (anyNodeDisplayText())
+    if (labelsReadable && anyNodeDisplayText())
     {
-        QStringList nodeText = getNodeText();
-        QPainterPath textPath;
-
-        QFontMetrics metrics(g_settings->labelFont);
-        double fontHeight = metrics.ascent();
-
-        for (int i = 0; i < nodeText.size(); ++i)
-        {
-            QString text = nodeText.at(i);
-            int stepsUntilLast = nodeText.size() - 1 - i;
-            double shiftLeft = -metrics.width(text) / 2.0;
-            textPath.addText(shiftLeft, -stepsUntilLast * fontHeight, g_settings->labelFont, text);
-        }
+        LabelPaths labelPaths = LabelCache::getLabelPaths(getNodeText());
 
         std::vector<QPointF> centres;
         if (g_settings->positionTextNodeCentre)
@@ -287,11 +232,11 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
             centres = getCentres();
 
         for (size_t i = 0; i < centres.size(); ++i)
-            drawTextPathAtLocation(painter, textPath, centres[i]);
+            drawTextPathAtLocation(painter, labelPaths, centres[i]);
     }
 
     //Draw BLAST hit labels, if appropriate.
-    if (g_settings->displayBlastHits && nodeHasBlastHits)
+    if (labelsReadable && g_settings->displayBlastHits && nodeHasBlastHits)
     {
         std::vector<QString> blastHitText;
         std::vector<QPointF> blastHitLocation;
@@ -303,23 +248,61 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
 
         for (size_t i = 0; i < blastHitText.size(); ++i)
         {
-            QString text = blastHitText[i];
-            QPointF centre = blastHitLocation[i];
+            LabelPaths labelPaths = LabelCache::getLabelPaths(QStringList(blastHitText[i]));
+            drawTextPathAtLocation(painter, labelPaths, blastHitLocation[i]);
+        }
+    }
+}
+
+
+//A low detail node is just its path drawn with a pen of the node's width,
+//over a slightly wider line in the selection colour if it is selected.
+void GraphicsItemNode::drawLowDetailNode(QPainter * painter)
+{
+    if (isSelected())
+    {
+        painter->setPen(QPen(QBrush(g_settings->selectionColour), m_width + 2.0 * g_settings->selectionThickness,
+                             Qt::SolidLine, Qt::FlatCap, Qt::RoundJoin));
+        painter->drawPolyline(m_linePoints.data(), int(m_linePoints.size()));
+    }
+    painter->setPen(QPen(QBrush(m_colour), m_width, Qt::SolidLine, Qt::FlatCap, Qt::RoundJoin));
+    painter->drawPolyline(m_linePoints.data(), int(m_linePoints.size()));
+}
 
-            QPainterPath textPath;
-            QFontMetrics metrics(g_settings->labelFont);
-            double shiftLeft = -metrics.width(text) / 2.0;
-            textPath.addText(shiftLeft, 0.0, g_settings->labelFont, text);
 
-            drawTextPathAtLocation(painter, textPath, centre);
+//This function joins BLAST hit or barcode parts that follow on from each
+//other, when they have the same colour or when a part would be shorter than
+//the minimum length on screen.  A joined part takes the colour of its first
+//part.
+std::vector<BlastHitPart> GraphicsItemNode::mergeAdjacentParts(const std::vector<BlastHitPart> & parts,
+                                                               double scaledNodeLength, double minimumPartLength)
+{
+    std::vector<BlastHitPart> mergedParts;
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        if (!mergedParts.empty())
+        {
+            BlastHitPart & previous = mergedParts.back();
+            bool adjacent = fabs(previous.m_nodeFractionEnd - parts[i].m_nodeFractionStart) < 1e-9;
+            double previousLength = fabs(previous.m_nodeFractionEnd - previous.m_nodeFractionStart) * scaledNodeLength;
+            if (adjacent && (previous.m_colour == parts[i].m_colour || previousLength < minimumPartLength))
+            {
+                previous.m_nodeFractionEnd = parts[i].m_nodeFractionEnd;
+                continue;
+            }
         }
+        mergedParts.push_back(parts[i]);
     }
+    return mergedParts;
 }
 
 
-void GraphicsItemNode::drawTextPathAtLocation(QPainter * painter, QPainterPath textPath, QPointF centre)
+//Labels are drawn from cached paths, with the outline (if any) filled
+//first so the text sits on top of it.  If overlapping labels are hidden, a
+//label is left out when its screen area is already taken by another label.
+void GraphicsItemNode::drawTextPathAtLocation(QPainter * painter, const LabelPaths & labelPaths, QPointF centre)
 {
-    QRectF textBoundingRect = textPath.boundingRect();
+    QRectF textBoundingRect = labelPaths.text.boundingRect();
     double textHeight = textBoundingRect.height();
     QPointF offset(0.0, textHeight / 2.0);
 
@@ -327,23 +310,58 @@ void GraphicsItemNode::drawTextPathAtLocation(QPainter * painter, QPainterPath t
     painter->rotate(-g_graphicsView->getRotation());
     painter->translate(offset);
 
-    if (g_settings->textOutline)
+    QRectF labelRect = g_settings->textOutline ? labelPaths.outline.boundingRect() : textBoundingRect;
+    if (!g_settings->hideOverlappingLabels ||
+            LabelCache::useArea(painter->worldTransform().mapRect(labelRect)))
     {
-        painter->setPen(QPen(g_settings->textOutlineColour,
-                             g_settings->textOutlineThickness * 2.0,
-                             Qt::SolidLine,
-                             Qt::SquareCap,
-                             Qt::RoundJoin));
-        painter->drawPath(textPath);
+        if (g_settings->textOutline)
+            painter->fillPath(labelPaths.outline, QBrush(g_settings->textOutlineColour));
+        painter->fillPath(labelPaths.text, QBrush(g_settings->textColour));
     }
 
-    painter->fillPath(textPath, QBrush(g_settings->textColour));
     painter->translate(-offset);
     painter->rotate(g_graphicsView->getRotation());
     painter->translate(-centre);
 }
 
 
+//This function returns the largest width or height of the labels this node
+//draws.  Labels are centred on points of the node, so this is as far as
+//they can reach outside its bounding rectangle.
+double GraphicsItemNode::getLargestLabelSize()
+{
+    std::vector<LabelPaths> labels;
+    if (anyNodeDisplayText())
+        labels.push_back(LabelCache::getLabelPaths(getNodeText()));
+
+    bool nodeHasBlastHits;
+    if (g_settings->doubleMode)
+        nodeHasBlastHits = m_deBruijnNode->thisNodeHasBlastHits();
+    else
+        nodeHasBlastHits = m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits();
+
+    if (g_settings->displayBlastHits && nodeHasBlastHits)
+    {
+        std::vector<QString> blastHitText;
+        std::vector<QPointF> blastHitLocation;
+        if (g_settings->doubleMode)
+            getBlastHitsTextAndLocationThisNode(&blastHitText, &blastHitLocation);
+        else
+            getBlastHitsTextAndLocationThisNodeOrReverseComplement(&blastHitText, &blastHitLocation);
+        for (size_t i = 0; i < blastHitText.size(); ++i)
+            labels.push_back(LabelCache::getLabelPaths(QStringList(blastHitText[i])));
+    }
+
+    double largestSize = 0.0;
+    for (size_t i = 0; i < labels.size(); ++i)
+    {
+        QRectF labelRect = g_settings->textOutline ? labels[i].outline.boundingRect() : labels[i].text.boundingRect();
+        largestSize = qMax(largestSize, qMax(labelRect.width(), labelRect.height()));
+    }
+    return largestSize;
+}
+
+
 
 void GraphicsItemNode::setNodeColour()
 {
@@ -422,6 +440,15 @@ void GraphicsItemNode::setNodeColour()
         break;
     }
 
+    //The colours for the CSV column were already worked out by the CSV
+    //table, so this is just a lookup.
+    case CSV_COLOURS:
+    {
+        m_colour = g_assemblyGraph->m_csvTable.getColour(m_deBruijnNode->getCsvRow(),
+                                                          g_settings->noCsvDataColour);
+        break;
+    }
+
     default: //CONTIGUITY COLOUR
     {
         //For single nodes, display the colour of whichever of the
@@ -458,6 +485,59 @@ void GraphicsItemNode::setNodeColour()
 
 
 QPainterPath GraphicsItemNode::shape() const
+{
+    if (!m_outlineValid)
+    {
+        m_outline = makeOutline();
+        m_outlineValid = true;
+    }
+    return m_outline;
+}
+
+
+//The outline is simplified before it is drawn, so overlapping parts of the
+//node don't show their borders.
+QPainterPath GraphicsItemNode::getSimplifiedOutline() const
+{
+    if (!m_simplifiedOutlineValid)
+    {
+        m_simplifiedOutline = shape().simplified();
+        m_simplifiedOutlineValid = true;
+    }
+    return m_simplifiedOutline;
+}
+
+
+void GraphicsItemNode::invalidateOutline()
+{
+    prepareGeometryChange();
+    m_outlineValid = false;
+    m_simplifiedOutlineValid = false;
+    m_outline = QPainterPath();
+    m_simplifiedOutline = QPainterPath();
+    invalidateSceneIndex();
+}
+
+
+//The scene's index holds the node's segments, so it must be made again
+//when the node changes shape or is added to or removed from the scene.
+void GraphicsItemNode::invalidateSceneIndex()
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+        graphicsScene->invalidateIndex();
+}
+
+
+QVariant GraphicsItemNode::itemChange(GraphicsItemChange change, const QVariant & value)
+{
+    if (change == ItemSceneChange || change == ItemSceneHasChanged)
+        invalidateSceneIndex();
+    return QGraphicsItem::itemChange(change, value);
+}
+
+
+QPainterPath GraphicsItemNode::makeOutline() const
 {
     //If there is only one segment and it is shorter than half its
     //width, then the arrow head will not be made with 45 degree
@@ -638,6 +718,8 @@ void GraphicsItemNode::remakePath()
         path.lineTo(m_linePoints[i]);
 
     m_path = path;
+    invalidateOutline();
+    m_colouredPartPathsGeneration = -1;
 }
 
 
@@ -924,17 +1006,20 @@ void GraphicsItemNode::setWidth()
 {
     m_width = getNodeWidth(m_deBruijnNode->getReadDepthRelativeToMeanDrawnReadDepth(), g_settings->readDepthPower,
                            g_settings->readDepthEffectOnWidth, g_settings->averageNodeWidth);
+    invalidateOutline();
 }
 
 
 
 //The bounding rectangle of a node has to be a little bit bigger than
-//the node's path, because of the outline.  The selection outline is
-//the largest outline we can expect, so use that to define the bounding
-//rectangle.
+//the node's path, because of the outline.  The view only redraws the
+//bounding rectangles of changed items, so it must hold everything the node
+//draws: the normal outline, the selection outline and, for a selected low
+//detail node, the selection colour drawn a full selection thickness out
+//from the node's edge.
 QRectF GraphicsItemNode::boundingRect() const
 {
-    double extraSize = g_settings->selectionThickness / 2.0;
+    double extraSize = qMax(g_settings->selectionThickness, g_settings->outlineThickness / 2.0);
     QRectF bound = shape().boundingRect();
 
     bound.setTop(bound.top() - extraSize);
@@ -1168,6 +1253,195 @@ QPainterPath GraphicsItemNode::buildPartialHighlightPath(double startFraction,
 }
 
 
+//This function gives the coloured parts (BLAST hits or barcodes, depending
+//on the colour scheme) drawn over the node at the given zoom.  Barcode parts
+//are given as BlastHitParts, which hold the same thing.
+std::vector<BlastHitPart> GraphicsItemNode::getColouredParts(double zoom, bool lowDetail)
+{
+    std::vector<BlastHitPart> parts;
+
+    //The scaled node length is passed to the functions which make the parts,
+    //because we don't want those parts to be much less than 1 pixel in size,
+    //which isn't necessary and can cause weird visual artefacts.
+    double scaledNodeLength = getNodePathLength() * zoom;
+
+    if (g_settings->nodeColourScheme == BLAST_HITS_RAINBOW_COLOUR ||
+            g_settings->nodeColourScheme == BLAST_HITS_SOLID_COLOUR)
+    {
+        if (g_settings->doubleMode)
+        {
+            if (m_deBruijnNode->thisNodeHasBlastHits())
+                parts = m_deBruijnNode->getBlastHitPartsForThisNode(scaledNodeLength);
+        }
+        else
+        {
+            if (m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits())
+                parts = m_deBruijnNode->getBlastHitPartsForThisNodeOrReverseComplement(scaledNodeLength);
+        }
+    }
+    else if (g_settings->nodeColourScheme == BARCODE_COLOR)
+    {
+        std::vector<BarcodePart> barcodeParts;
+        if (g_settings->doubleMode)
+        {
+            if (m_deBruijnNode->thisNodeHasBarcode())
+                barcodeParts = m_deBruijnNode->getBarcodePartsForThisNode(scaledNodeLength);
+        }
+        else
+        {
+            if (m_deBruijnNode->thisNodeOrReverseComplementHasBarcode())
+                barcodeParts = m_deBruijnNode->getBarcodePartsForThisNodeOrReverseComplement(scaledNodeLength);
+        }
+        for (size_t i = 0; i < barcodeParts.size(); ++i)
+            parts.push_back(BlastHitPart(barcodeParts[i].m_colour, barcodeParts[i].m_nodeFractionStart,
+                                         barcodeParts[i].m_nodeFractionEnd));
+    }
+
+    //Parts less than a pixel long are only joined in low detail, but parts
+    //of the same colour always are, as one line draws them just the same.
+    return mergeAdjacentParts(parts, scaledNodeLength, lowDetail ? 1.0 : 0.0);
+}
+
+
+//This function sorts the parts into groups of one colour, each drawn as a
+//single path.  A part only joins an earlier group of its colour if it
+//doesn't overlap any part before it, as otherwise it must be drawn after
+//them, i.e. in the last group.
+std::vector<std::vector<BlastHitPart> > GraphicsItemNode::groupPartsByColour(const std::vector<BlastHitPart> & parts)
+{
+    std::vector<std::vector<BlastHitPart> > groups;
+    QHash<QRgb, size_t> groupsByColour;
+
+    //The node fractions covered so far, as separate ranges (start to end).
+    std::map<double, double> covered;
+
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        const BlastHitPart & part = parts[i];
+        double start = std::min(part.m_nodeFractionStart, part.m_nodeFractionEnd);
+        double end = std::max(part.m_nodeFractionStart, part.m_nodeFractionEnd);
+        QRgb colour = part.m_colour.rgba();
+
+        std::map<double, double>::iterator next = covered.lower_bound(end);
+        bool overlaps = false;
+        if (next != covered.begin())
+        {
+            std::map<double, double>::iterator previous = next;
+            --previous;
+            overlaps = previous->second > start;
+        }
+
+        QHash<QRgb, size_t>::const_iterator sameColour = groupsByColour.constFind(colour);
+        if (!overlaps && sameColour != groupsByColour.constEnd())
+            groups[sameColour.value()].push_back(part);
+        else if (!groups.empty() && groups.back().back().m_colour.rgba() == colour)
+            groups.back().push_back(part);
+        else
+        {
+            groupsByColour[colour] = groups.size();
+            groups.push_back(std::vector<BlastHitPart>(1, part));
+        }
+
+        //Add the part's range to the covered ranges, joining any it touches.
+        std::map<double, double>::iterator first = covered.lower_bound(start);
+        if (first != covered.begin())
+        {
+            std::map<double, double>::iterator previous = first;
+            --previous;
+            if (previous->second >= start)
+                first = previous;
+        }
+        std::map<double, double>::iterator last = covered.upper_bound(end);
+        if (first != last)
+        {
+            std::map<double, double>::iterator lastJoined = last;
+            --lastJoined;
+            start = std::min(start, first->first);
+            end = std::max(end, lastJoined->second);
+            covered.erase(first, last);
+        }
+        covered[start] = end;
+    }
+
+    return groups;
+}
+
+
+//This function is called when the BLAST hits or barcodes change, or how
+//they are coloured, so every node makes its part paths again.
+void GraphicsItemNode::invalidateAllColouredPartPaths()
+{
+    ++s_colouredPartPathsGeneration;
+}
+
+
+//The part paths are made at the lowest zoom of the zoom's step, so the
+//parts are never shorter on screen than they were made for.
+const std::vector<ColouredPartPath> & GraphicsItemNode::getColouredPartPaths(double zoom, bool lowDetail)
+{
+    int zoomStep = int(floor(log(qMax(zoom, 1e-9)) / log(2.0) * PART_PATH_ZOOM_STEPS_PER_DOUBLING));
+    if (m_colouredPartPathsGeneration == s_colouredPartPathsGeneration &&
+            m_colouredPartPathsZoomStep == zoomStep &&
+            m_colouredPartPathsLowDetail == lowDetail &&
+            m_colouredPartPathsScheme == int(g_settings->nodeColourScheme) &&
+            m_colouredPartPathsDoubleMode == g_settings->doubleMode)
+        return m_colouredPartPaths;
+
+    m_colouredPartPathsGeneration = s_colouredPartPathsGeneration;
+    m_colouredPartPathsZoomStep = zoomStep;
+    m_colouredPartPathsLowDetail = lowDetail;
+    m_colouredPartPathsScheme = int(g_settings->nodeColourScheme);
+    m_colouredPartPathsDoubleMode = g_settings->doubleMode;
+    m_colouredPartPaths.clear();
+
+    double stepZoom = pow(2.0, zoomStep / PART_PATH_ZOOM_STEPS_PER_DOUBLING);
+    std::vector<std::vector<BlastHitPart> > groups = groupPartsByColour(getColouredParts(stepZoom, lowDetail));
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        ColouredPartPath partPath;
+        partPath.colour = groups[i][0].m_colour;
+        for (size_t j = 0; j < groups[i].size(); ++j)
+            partPath.path.addPath(makePartialPath(groups[i][j].m_nodeFractionStart,
+                                                  groups[i][j].m_nodeFractionEnd));
+        m_colouredPartPaths.push_back(partPath);
+    }
+    return m_colouredPartPaths;
+}
+
+
+//This function returns true if painting this node would only draw its fill
+//and outline, with no BLAST hits, barcodes or labels, so the node can be
+//drawn without its item (e.g. into a tile).  Path highlighting isn't
+//checked, as tiles aren't used while the path dialogs are open.
+bool GraphicsItemNode::hasOnlyFillAndOutline()
+{
+    if (anyNodeDisplayText())
+        return false;
+
+    bool nodeHasBlastHits;
+    bool nodeHasBarcode;
+    if (g_settings->doubleMode)
+    {
+        nodeHasBlastHits = m_deBruijnNode->thisNodeHasBlastHits();
+        nodeHasBarcode = m_deBruijnNode->thisNodeHasBarcode();
+    }
+    else
+    {
+        nodeHasBlastHits = m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits();
+        nodeHasBarcode = m_deBruijnNode->thisNodeOrReverseComplementHasBarcode();
+    }
+
+    if (nodeHasBlastHits && (g_settings->displayBlastHits ||
+                             g_settings->nodeColourScheme == BLAST_HITS_RAINBOW_COLOUR ||
+                             g_settings->nodeColourScheme == BLAST_HITS_SOLID_COLOUR))
+        return false;
+    if (nodeHasBarcode && g_settings->nodeColourScheme == BARCODE_COLOR)
+        return false;
+
+    return true;
+}
+
+
 bool GraphicsItemNode::anyNodeDisplayText()
 {
     return g_settings->displayNodeCustomLabels ||
@@ -1176,3 +1450,62 @@ bool GraphicsItemNode::anyNodeDisplayText()
             g_settings->displayNodeReadDepth ||
             g_settings->displayNodeCsvData;
 }
+
+
+
+//This function makes a smooth curve through the given points, using a
+//Catmull-Rom spline, and returns it as segmentCount + 1 points evenly
+//spaced along the curve.  The first and last points are unchanged.
+std::vector<QPointF> GraphicsItemNode::makeSmoothCurve(const std::vector<QPointF> & points,
+                                                       int segmentCount)
+{
+    if (points.size() < 2 || segmentCount < 1)
+        return points;
+
+    //First the spline is sampled finely, keeping the length along the
+    //curve to each sample.
+    int samplesPerSpan = 8;
+    std::vector<QPointF> samples;
+    std::vector<double> sampleDistances;
+    samples.push_back(points[0]);
+    sampleDistances.push_back(0.0);
+    for (size_t i = 0; i < points.size() - 1; ++i)
+    {
+        QPointF p0 = points[i > 0 ? i - 1 : i];
+        QPointF p1 = points[i];
+        QPointF p2 = points[i + 1];
+        QPointF p3 = points[i + 2 < points.size() ? i + 2 : i + 1];
+        for (int j = 1; j <= samplesPerSpan; ++j)
+        {
+            double t = double(j) / samplesPerSpan;
+            double t2 = t * t;
+            double t3 = t2 * t;
+            QPointF sample = 0.5 * ((2.0 * p1) +
+                                    (p2 - p0) * t +
+                                    (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * t2 +
+                                    (3.0 * p1 - p0 - 3.0 * p2 + p3) * t3);
+            sampleDistances.push_back(sampleDistances.back() + QLineF(samples.back(), sample).length());
+            samples.push_back(sample);
+        }
+    }
+
+    //Then points are picked from the samples at even distances.
+    double totalLength = sampleDistances.back();
+    std::vector<QPointF> curve;
+    curve.push_back(points.front());
+    size_t sample = 1;
+    for (int i = 1; i < segmentCount; ++i)
+    {
+        double targetDistance = totalLength * i / segmentCount;
+        while (sample < samples.size() - 1 && sampleDistances[sample] < targetDistance)
+            ++sample;
+        double spanLength = sampleDistances[sample] - sampleDistances[sample - 1];
+        double fraction = 0.0;
+        if (spanLength > 0.0)
+            fraction = (targetDistance - sampleDistances[sample - 1]) / spanLength;
+        curve.push_back(samples[sample - 1] + (samples[sample] - samples[sample - 1]) * fraction);
+    }
+    curve.push_back(points.back());
+
+    return curve;
+}
@@ -29,9 +29,17 @@
 #include <QString>
 #include <QPainterPath>
 #include <QStringList>
+#include "../blast/blasthitpart.h"
 
 class DeBruijnNode;
 class Path;
+struct LabelPaths;
+
+struct ColouredPartPath
+{
+    QColor colour;
+    QPainterPath path;
+};
 
 class GraphicsItemNode : public QGraphicsItem
 {
@@ -57,7 +65,10 @@ public:
     void mousePressEvent(QGraphicsSceneMouseEvent * event);
     void mouseMoveEvent(QGraphicsSceneMouseEvent * event);
     void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *);
+    QVariant itemChange(GraphicsItemChange change, const QVariant & value);
     QPainterPath shape() const;
+    QPainterPath getSimplifiedOutline() const;
+    bool hasOnlyFillAndOutline();
     void shiftPoints(QPointF difference);
     void remakePath();
     double distance(QPointF p1, QPointF p2) const;
@@ -89,16 +100,49 @@ public:
                                              std::vector<QPointF> * blastHitLocation);
     void getBlastHitsTextAndLocationThisNodeOrReverseComplement(std::vector<QString> * blastHitText,
                                                                 std::vector<QPointF> * blastHitLocation);
-    void drawTextPathAtLocation(QPainter *painter, QPainterPath textPath, QPointF centre);
+    void drawTextPathAtLocation(QPainter *painter, const LabelPaths & labelPaths, QPointF centre);
+    double getLargestLabelSize();
+    std::vector<BlastHitPart> getColouredParts(double zoom, bool lowDetail);
+    static std::vector<BlastHitPart> mergeAdjacentParts(const std::vector<BlastHitPart> & parts,
+                                                        double scaledNodeLength, double minimumPartLength);
+    static std::vector<std::vector<BlastHitPart> > groupPartsByColour(const std::vector<BlastHitPart> & parts);
+    static void invalidateAllColouredPartPaths();
+    bool anyNodeDisplayText();
     void fixEdgePaths(std::vector<GraphicsItemNode *> * nodes = 0);
+    static std::vector<QPointF> makeSmoothCurve(const std::vector<QPointF> & points,
+                                                int segmentCount);
 
 private:
+    //The node's outline (its shape) and the simplified version drawn as
+    //its border take path boolean operations to make, so they are made
+    //when first needed and kept until the node's path or width changes.
+    mutable QPainterPath m_outline;
+    mutable QPainterPath m_simplifiedOutline;
+    mutable bool m_outlineValid;
+    mutable bool m_simplifiedOutlineValid;
+
+    //The coloured parts (BLAST hits or barcodes) are drawn from paths made
+    //for a step of zoom levels, one path for each colour where the drawing
+    //order allows.  They are kept until the node moves, the zoom leaves the
+    //step or the parts change anywhere (which bumps the generation).
+    std::vector<ColouredPartPath> m_colouredPartPaths;
+    int m_colouredPartPathsGeneration;
+    int m_colouredPartPathsZoomStep;
+    bool m_colouredPartPathsLowDetail;
+    int m_colouredPartPathsScheme;
+    bool m_colouredPartPathsDoubleMode;
+    static int s_colouredPartPathsGeneration;
+
+    QPainterPath makeOutline() const;
+    void invalidateOutline();
+    void invalidateSceneIndex();
+    void drawLowDetailNode(QPainter * painter);
+    const std::vector<ColouredPartPath> & getColouredPartPaths(double zoom, bool lowDetail);
     void exactPathHighlightNode(QPainter * painter);
     void queryPathHighlightNode(QPainter * painter);
     void pathHighlightNode2(QPainter * painter, DeBruijnNode * node, bool reverse, Path * path);
     void pathHighlightNode3(QPainter * painter, QPainterPath highlightPath);
     QPainterPath buildPartialHighlightPath(double startFraction, double endFraction, bool reverse);
-    bool anyNodeDisplayText();
     void shiftPointSideways(bool left);
 
 };
@@ -0,0 +1,198 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "labelcache.h"
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QFont>
+#include <QFontMetrics>
+#include <QPainterPathStroker>
+#include <math.h>
+#include "../program/globals.h"
+#include "../program/settings.h"
+
+//The cache holds labels up to this many path elements in total.
+static const int LABEL_CACHE_SIZE = 1000000;
+
+//The screen is divided into squares this many pixels wide, so a label is
+//only checked against the labels near it.
+static const double LABEL_AREA_CELL_SIZE = 64.0;
+
+static QCache<QString, LabelPaths> s_labelPaths(LABEL_CACHE_SIZE);
+static QFont s_labelFont;
+static bool s_textOutline = false;
+static double s_textOutlineThickness = 0.0;
+static double s_lineHeight = -1.0;
+static double s_ascent = 0.0;
+
+static QHash<qint64, QList<QRectF> > s_usedAreas;
+static bool s_keepUsedAreas = false;
+static QPointF s_deviceOffset;
+
+//Rectangles within this distance (in pixels) are taken to be the same label.
+static const double SAME_LABEL_TOLERANCE = 0.01;
+
+
+static bool isSameArea(const QRectF & a, const QRectF & b)
+{
+    return fabs(a.left() - b.left()) < SAME_LABEL_TOLERANCE &&
+            fabs(a.top() - b.top()) < SAME_LABEL_TOLERANCE &&
+            fabs(a.right() - b.right()) < SAME_LABEL_TOLERANCE &&
+            fabs(a.bottom() - b.bottom()) < SAME_LABEL_TOLERANCE;
+}
+
+
+//This function gives the paths for a label with one or more lines of text.
+//Each line is centred horizontally and the last line sits on y = 0.
+LabelPaths LabelCache::getLabelPaths(const QStringList & lines)
+{
+    checkSettings();
+
+    QString key = lines.join("\n");
+    LabelPaths * cachedPaths = s_labelPaths.object(key);
+    if (cachedPaths != 0)
+        return *cachedPaths;
+
+    LabelPaths paths;
+    QFontMetrics metrics(s_labelFont);
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        QString text = lines.at(i);
+        int stepsUntilLast = lines.size() - 1 - i;
+        double shiftLeft = -metrics.width(text) / 2.0;
+        paths.text.addText(shiftLeft, -stepsUntilLast * s_ascent, s_labelFont, text);
+    }
+
+    if (s_textOutline)
+    {
+        QPainterPathStroker stroker;
+        stroker.setWidth(s_textOutlineThickness * 2.0);
+        stroker.setCapStyle(Qt::SquareCap);
+        stroker.setJoinStyle(Qt::RoundJoin);
+        paths.outline = stroker.createStroke(paths.text);
+    }
+
+    int cost = qMax(1, paths.text.elementCount() + paths.outline.elementCount());
+    s_labelPaths.insert(key, new LabelPaths(paths), cost);
+    return paths;
+}
+
+
+double LabelCache::getLineHeight()
+{
+    checkSettings();
+    return s_lineHeight;
+}
+
+
+void LabelCache::clear()
+{
+    s_labelPaths.clear();
+    s_lineHeight = -1.0;
+}
+
+
+//This function is called at the start of each paint, so labels are only
+//checked against others drawn at the same time.
+void LabelCache::clearUsedAreas()
+{
+    if (s_keepUsedAreas)
+        return;
+    s_usedAreas.clear();
+}
+
+
+//This function returns false if the area (in device coordinates) overlaps
+//a label already drawn.  Otherwise it marks the area as used and returns
+//true.  An area that exactly matches one already used is the same label
+//drawn again (in another piece of the image), so it is allowed.
+bool LabelCache::useArea(const QRectF & deviceRect)
+{
+    if (deviceRect.isEmpty())
+        return true;
+
+    QRectF area = deviceRect.translated(s_deviceOffset);
+    qint64 left = qint64(floor(area.left() / LABEL_AREA_CELL_SIZE));
+    qint64 right = qint64(floor(area.right() / LABEL_AREA_CELL_SIZE));
+    qint64 top = qint64(floor(area.top() / LABEL_AREA_CELL_SIZE));
+    qint64 bottom = qint64(floor(area.bottom() / LABEL_AREA_CELL_SIZE));
+
+    for (qint64 y = top; y <= bottom; ++y)
+    {
+        for (qint64 x = left; x <= right; ++x)
+        {
+            QHash<qint64, QList<QRectF> >::const_iterator cell = s_usedAreas.constFind(getGridCellKey(x, y));
+            if (cell == s_usedAreas.constEnd())
+                continue;
+            for (int i = 0; i < cell.value().size(); ++i)
+            {
+                if (isSameArea(cell.value()[i], area))
+                    return true;
+                if (cell.value()[i].intersects(area))
+                    return false;
+            }
+        }
+    }
+
+    for (qint64 y = top; y <= bottom; ++y)
+    {
+        for (qint64 x = left; x <= right; ++x)
+            s_usedAreas[getGridCellKey(x, y)].push_back(area);
+    }
+    return true;
+}
+
+
+//Cached paths are thrown away when the settings they were made with
+//change.
+void LabelCache::checkSettings()
+{
+    if (s_lineHeight >= 0.0 &&
+            s_labelFont == g_settings->labelFont &&
+            s_textOutline == g_settings->textOutline &&
+            s_textOutlineThickness == g_settings->textOutlineThickness)
+        return;
+
+    s_labelPaths.clear();
+    s_labelFont = g_settings->labelFont;
+    s_textOutline = g_settings->textOutline;
+    s_textOutlineThickness = g_settings->textOutlineThickness;
+
+    QFontMetrics metrics(s_labelFont);
+    s_lineHeight = metrics.height();
+    s_ascent = metrics.ascent();
+}
+
+
+//While used areas are kept, clearUsedAreas does nothing.  Turning this off
+//clears them.
+void LabelCache::setKeepUsedAreas(bool keep)
+{
+    s_keepUsedAreas = keep;
+    if (!keep)
+        s_usedAreas.clear();
+}
+
+
+//This offset is added to every area given to useArea, until it is set back
+//to zero.
+void LabelCache::setDeviceOffset(QPointF offset)
+{
+    s_deviceOffset = offset;
+}
@@ -0,0 +1,61 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef LABELCACHE_H
+#define LABELCACHE_H
+
+#include <QPainterPath>
+#include <QRectF>
+#include <QStringList>
+
+//LabelCache holds the paths used to draw node and BLAST hit labels.
+//Turning text into a path is slow, so each label's path (and the outline
+//drawn around it) is made once and reused until the label font or text
+//outline settings change.  Labels are cached by their text, so nodes with
+//the same label, such as BLAST hits for the same query, share one path.
+//
+//It also keeps track of the screen area taken by the labels drawn so far in
+//the current paint, so labels that would overlap them can be left out.
+//When an image is drawn in several pieces, the used areas can be kept for
+//the whole image, so each label is shown or hidden the same way in every
+//piece it touches.  A piece drawn in its own coordinates gives its place in
+//the image as the device offset, so all areas are in image coordinates.
+
+struct LabelPaths
+{
+    QPainterPath text;
+    QPainterPath outline;
+};
+
+class LabelCache
+{
+public:
+    static LabelPaths getLabelPaths(const QStringList & lines);
+    static double getLineHeight();
+    static void clear();
+
+    static void clearUsedAreas();
+    static bool useArea(const QRectF & deviceRect);
+    static void setKeepUsedAreas(bool keep);
+    static void setDeviceOffset(QPointF offset);
+
+private:
+    static void checkSettings();
+};
+
+#endif // LABELCACHE_H
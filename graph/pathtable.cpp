@@ -0,0 +1,93 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "pathtable.h"
+#include <QList>
+
+void PathTable::clear()
+{
+    m_names.clear();
+    m_pathIndices.clear();
+    m_offsets.clear();
+    m_offsets.push_back(0);
+    m_steps.clear();
+}
+
+
+//If a path of the same name is already in the table, the name is given a
+//numbered suffix so every path can still be looked up by name.
+void PathTable::addPath(QString name, const std::vector<DeBruijnNode *> & steps)
+{
+    QString uniqueName = name;
+    int suffix = 2;
+    while (m_pathIndices.contains(uniqueName))
+        uniqueName = name + "_" + QString::number(suffix++);
+
+    m_pathIndices.insert(uniqueName, m_names.size());
+    m_names.push_back(uniqueName);
+    m_steps.insert(m_steps.end(), steps.begin(), steps.end());
+    m_offsets.push_back(int(m_steps.size()));
+}
+
+
+//This function is used when nodes are deleted from the graph, so the table
+//never points to a deleted node.  Any path passing through one of the nodes
+//is dropped.
+void PathTable::removePathsWithNodes(const QSet<DeBruijnNode *> & nodes)
+{
+    QStringList oldNames = m_names;
+    std::vector<int> oldOffsets = m_offsets;
+    std::vector<DeBruijnNode *> oldSteps = m_steps;
+    clear();
+
+    for (int i = 0; i < oldNames.size(); ++i)
+    {
+        std::vector<DeBruijnNode *> steps(oldSteps.begin() + oldOffsets[i],
+                                          oldSteps.begin() + oldOffsets[i + 1]);
+        bool usesDeletedNode = false;
+        for (size_t j = 0; j < steps.size(); ++j)
+        {
+            if (nodes.contains(steps[j]))
+            {
+                usesDeletedNode = true;
+                break;
+            }
+        }
+        if (!usesDeletedNode)
+            addPath(oldNames[i], steps);
+    }
+}
+
+
+//This function makes a Path object directly from the stored nodes, so there
+//is no need to build and parse a path string.  If consecutive nodes are not
+//joined by an edge, the returned Path will be empty.
+Path PathTable::getPath(int path, bool circular) const
+{
+    if (path < 0 || path >= getPathCount())
+        return Path();
+
+    QList<DeBruijnNode *> nodes;
+    int start = m_offsets[path];
+    int end = m_offsets[path + 1];
+    nodes.reserve(end - start);
+    for (int i = start; i < end; ++i)
+        nodes.push_back(m_steps[i]);
+
+    return Path::makeFromOrderedNodes(nodes, circular);
+}
@@ -0,0 +1,60 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef PATHTABLE_H
+#define PATHTABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <vector>
+#include "path.h"
+
+class DeBruijnNode;
+
+//PathTable holds the named paths that came with a graph file (GFA P, W and
+//O lines).  All steps are kept in one array of oriented nodes, with each
+//path's steps found between its offset and the next path's offset.  A Path
+//object is only made when a path is actually used.
+
+class PathTable
+{
+public:
+    PathTable() {m_offsets.push_back(0);}
+
+    void clear();
+    void addPath(QString name, const std::vector<DeBruijnNode *> & steps);
+    void removePathsWithNodes(const QSet<DeBruijnNode *> & nodes);
+
+    int getPathCount() const {return m_names.size();}
+    QStringList getPathNames() const {return m_names;}
+    QString getPathName(int path) const {return m_names[path];}
+    int getStepCount(int path) const {return m_offsets[path + 1] - m_offsets[path];}
+    DeBruijnNode * getStep(int path, int step) const {return m_steps[m_offsets[path] + step];}
+    int findPath(QString name) const {return m_pathIndices.value(name, -1);}
+    Path getPath(int path, bool circular = false) const;
+
+private:
+    QStringList m_names;
+    QHash<QString, int> m_pathIndices;
+    std::vector<int> m_offsets;
+    std::vector<DeBruijnNode *> m_steps;
+};
+
+#endif // PATHTABLE_H
@@ -0,0 +1,238 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "forcekernel.h"
+#include <math.h>
+#include <algorithm>
+
+//SSE2 is part of every x86-64 processor, so it needs no runtime check.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FORCE_KERNEL_SSE
+#endif
+
+//The sorted arrays have this many unused entries on the end, enough for a
+//SIMD load.
+static const int SIMD_PADDING = 4;
+
+
+ForceKernel::ForceKernel() :
+    m_gridMinX(0.0), m_gridMinY(0.0), m_cellSize(1.0), m_gridWidth(1), m_gridHeight(1)
+{
+}
+
+
+int ForceKernel::getSimdWidth()
+{
+#if defined(FORCE_KERNEL_SSE)
+    return 4;
+#else
+    return 1;
+#endif
+}
+
+
+//This function puts the nodes into a grid of cells at least as big as the
+//repulsion range, so a node's repulsion only needs the nodes in its own and
+//neighbouring cells.  A very spread out layout gets bigger cells, so the
+//grid never has many more cells than there are nodes.  The nodes are
+//counting sorted by cell, which keeps them in index order within a cell.
+void ForceKernel::buildGrid(const ForceNodes & nodes, const ForceParameters & parameters)
+{
+    int n = nodes.nodeCount;
+    double minX = 0.0;
+    double maxX = 0.0;
+    double minY = 0.0;
+    double maxY = 0.0;
+    if (n > 0)
+    {
+        minX = maxX = nodes.x[0];
+        minY = maxY = nodes.y[0];
+    }
+    for (int i = 1; i < n; ++i)
+    {
+        minX = std::min(minX, nodes.x[i]);
+        maxX = std::max(maxX, nodes.x[i]);
+        minY = std::min(minY, nodes.y[i]);
+        maxY = std::max(maxY, nodes.y[i]);
+    }
+
+    m_gridMinX = minX;
+    m_gridMinY = minY;
+    m_cellSize = parameters.repulsionRange;
+    double maxCells = 4.0 * n + 16.0;
+    while (true)
+    {
+        double gridWidth = floor((maxX - minX) / m_cellSize) + 1.0;
+        double gridHeight = floor((maxY - minY) / m_cellSize) + 1.0;
+        if (gridWidth * gridHeight <= maxCells)
+        {
+            m_gridWidth = int(gridWidth);
+            m_gridHeight = int(gridHeight);
+            break;
+        }
+        m_cellSize *= 2.0;
+    }
+
+    int cellCount = m_gridWidth * m_gridHeight;
+    m_cellStarts.assign(cellCount + 1, 0);
+    m_nodeCells.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        m_nodeCells[i] = getCellIndex(nodes.x[i], nodes.y[i]);
+        ++m_cellStarts[m_nodeCells[i] + 1];
+    }
+    for (int c = 0; c < cellCount; ++c)
+        m_cellStarts[c + 1] += m_cellStarts[c];
+
+    std::vector<int> nextInCell(m_cellStarts.begin(), m_cellStarts.end() - 1);
+    m_sortedX.assign(n + SIMD_PADDING, 0.0f);
+    m_sortedY.assign(n + SIMD_PADDING, 0.0f);
+    m_sortedWeights.assign(n + SIMD_PADDING, 0.0f);
+    for (int i = 0; i < n; ++i)
+    {
+        int sortedIndex = nextInCell[m_nodeCells[i]]++;
+        m_sortedX[sortedIndex] = float(nodes.x[i] - m_gridMinX);
+        m_sortedY[sortedIndex] = float(nodes.y[i] - m_gridMinY);
+        m_sortedWeights[sortedIndex] = float(nodes.weights[i]);
+    }
+}
+
+
+int ForceKernel::getCellIndex(double x, double y) const
+{
+    int cellX = std::min(m_gridWidth - 1, std::max(0, int((x - m_gridMinX) / m_cellSize)));
+    int cellY = std::min(m_gridHeight - 1, std::max(0, int((y - m_gridMinY) / m_cellSize)));
+    return cellY * m_gridWidth + cellX;
+}
+
+
+//This function works out the moves for a range of nodes, using the
+//positions the grid was built from.  It only writes the moves for its own
+//nodes, so ranges can run at the same time.  Nodes are pushed apart by
+//nearby nodes (more strongly by heavier nodes) and pulled together along
+//their edges, and no node moves further than the maximum move.
+void ForceKernel::getMoves(const ForceNodes & nodes, const ForceParameters & parameters,
+                           int start, int end, double * moveX, double * moveY) const
+{
+    double edgeLengthSquared = parameters.edgeLength * parameters.edgeLength;
+    float rangeSquared = float(parameters.repulsionRange * parameters.repulsionRange);
+    float minDistanceSquared = float(edgeLengthSquared * 1e-6);
+    float strength = float(edgeLengthSquared);
+
+    for (int i = start; i < end; ++i)
+    {
+        int cell = m_nodeCells[i];
+        int cellX = cell % m_gridWidth;
+        int cellY = cell / m_gridWidth;
+        int firstX = std::max(0, cellX - 1);
+        int lastX = std::min(m_gridWidth - 1, cellX + 1);
+
+        //Each row of three cells is one run of the sorted arrays.
+        float repulsionX = 0.0f;
+        float repulsionY = 0.0f;
+        float x = float(nodes.x[i] - m_gridMinX);
+        float y = float(nodes.y[i] - m_gridMinY);
+        for (int gridY = std::max(0, cellY - 1); gridY <= std::min(m_gridHeight - 1, cellY + 1); ++gridY)
+        {
+            int rowStart = gridY * m_gridWidth;
+            addRepulsion(m_cellStarts[rowStart + firstX], m_cellStarts[rowStart + lastX + 1],
+                         x, y, rangeSquared, minDistanceSquared, strength,
+                         &repulsionX, &repulsionY);
+        }
+        double dx = repulsionX;
+        double dy = repulsionY;
+
+        for (int e = nodes.edgeStarts[i]; e < nodes.edgeStarts[i + 1]; ++e)
+        {
+            int j = nodes.edgeTargets[e];
+            double towardX = nodes.x[j] - nodes.x[i];
+            double towardY = nodes.y[j] - nodes.y[i];
+            double distance = sqrt(towardX * towardX + towardY * towardY);
+            double idealLength = nodes.edgeLengths[e] * parameters.edgeLengthUnit;
+            dx += towardX * distance / idealLength;
+            dy += towardY * distance / idealLength;
+        }
+
+        double move = sqrt(dx * dx + dy * dy);
+        if (move > parameters.maxMove)
+        {
+            dx *= parameters.maxMove / move;
+            dy *= parameters.maxMove / move;
+        }
+        moveX[i] = dx;
+        moveY[i] = dy;
+    }
+}
+
+
+//This function adds the repulsion on a point from the sorted nodes first to
+//last - 1.  Nodes out of range are skipped, as are nodes on top of the
+//point, which includes the node itself.  The SIMD version masks out the
+//lanes past the end of the run, which read from the next cells or the
+//padding.
+void ForceKernel::addRepulsion(int first, int last, float x, float y, float rangeSquared,
+                               float minDistanceSquared, float strength,
+                               float * dx, float * dy) const
+{
+#if defined(FORCE_KERNEL_SSE)
+    __m128 pointX = _mm_set1_ps(x);
+    __m128 pointY = _mm_set1_ps(y);
+    __m128 range = _mm_set1_ps(rangeSquared);
+    __m128 minimum = _mm_set1_ps(minDistanceSquared);
+    __m128 strengths = _mm_set1_ps(strength);
+    __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 sumX = _mm_setzero_ps();
+    __m128 sumY = _mm_setzero_ps();
+    for (int k = first; k < last; k += 4)
+    {
+        __m128 awayX = _mm_sub_ps(pointX, _mm_loadu_ps(&m_sortedX[k]));
+        __m128 awayY = _mm_sub_ps(pointY, _mm_loadu_ps(&m_sortedY[k]));
+        __m128 distanceSquared = _mm_add_ps(_mm_mul_ps(awayX, awayX), _mm_mul_ps(awayY, awayY));
+        __m128 mask = _mm_and_ps(_mm_cmplt_ps(distanceSquared, range),
+                                 _mm_cmpgt_ps(distanceSquared, minimum));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(lanes, _mm_set1_ps(float(last - k))));
+        __m128 force = _mm_div_ps(_mm_mul_ps(_mm_loadu_ps(&m_sortedWeights[k]), strengths), distanceSquared);
+        force = _mm_and_ps(force, mask);
+        sumX = _mm_add_ps(sumX, _mm_mul_ps(awayX, force));
+        sumY = _mm_add_ps(sumY, _mm_mul_ps(awayY, force));
+    }
+    float sumsX[4];
+    float sumsY[4];
+    _mm_storeu_ps(sumsX, sumX);
+    _mm_storeu_ps(sumsY, sumY);
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        *dx += sumsX[lane];
+        *dy += sumsY[lane];
+    }
+
+#else
+    for (int k = first; k < last; ++k)
+    {
+        float awayX = x - m_sortedX[k];
+        float awayY = y - m_sortedY[k];
+        float distanceSquared = awayX * awayX + awayY * awayY;
+        if (distanceSquared >= rangeSquared || distanceSquared <= minDistanceSquared)
+            continue;
+        float force = m_sortedWeights[k] * strength / distanceSquared;
+        *dx += awayX * force;
+        *dy += awayY * force;
+    }
+#endif
+}
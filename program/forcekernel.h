@@ -0,0 +1,92 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef FORCEKERNEL_H
+#define FORCEKERNEL_H
+
+#include <vector>
+
+//ForceKernel works out the moves of a force-directed layout iteration for
+//nodes stored as structure-of-arrays.  Repulsion only acts between nodes
+//closer than the repulsion range, so the nodes are first sorted into a grid
+//of cells at least that big.  The sorted copy keeps each cell's nodes next
+//to each other in single precision arrays, so the three neighbouring cells
+//in a row of the grid are one contiguous run that can be processed with
+//SSE instructions, four nodes at a time.  Attraction along edges stays in
+//double precision, as nodes only have a few edges each.
+
+struct ForceNodes
+{
+    int nodeCount;
+    const double * x;
+    const double * y;
+
+    //Heavier nodes repel more strongly.
+    const double * weights;
+
+    //The edges of node i are edgeStarts[i] to edgeStarts[i+1] - 1.  Their
+    //lengths are multiples of ForceParameters::edgeLengthUnit.
+    const int * edgeStarts;
+    const int * edgeTargets;
+    const double * edgeLengths;
+};
+
+struct ForceParameters
+{
+    double edgeLength;
+    double edgeLengthUnit;
+    double repulsionRange;
+    double maxMove;
+};
+
+class ForceKernel
+{
+public:
+    ForceKernel();
+
+    void buildGrid(const ForceNodes & nodes, const ForceParameters & parameters);
+    void getMoves(const ForceNodes & nodes, const ForceParameters & parameters,
+                  int start, int end, double * moveX, double * moveY) const;
+
+    int getCellCount() const {return m_gridWidth * m_gridHeight;}
+    static int getSimdWidth();
+
+private:
+    double m_gridMinX;
+    double m_gridMinY;
+    double m_cellSize;
+    int m_gridWidth;
+    int m_gridHeight;
+
+    //The nodes in cell c are m_cellStarts[c] to m_cellStarts[c+1] - 1 in the
+    //sorted arrays.  Sorted positions are relative to the grid's corner, so
+    //single precision keeps its accuracy in big layouts.  The sorted arrays
+    //are padded so a SIMD load past the last node stays in bounds.
+    std::vector<int> m_cellStarts;
+    std::vector<int> m_nodeCells;
+    std::vector<float> m_sortedX;
+    std::vector<float> m_sortedY;
+    std::vector<float> m_sortedWeights;
+
+    int getCellIndex(double x, double y) const;
+    void addRepulsion(int first, int last, float x, float y, float rangeSquared,
+                      float minDistanceSquared, float strength,
+                      float * dx, float * dy) const;
+};
+
+#endif // FORCEKERNEL_H
@@ -77,3 +77,11 @@ QString formatDoubleForDisplay(double num, int decimalPlacesToDisplay)
     }
     return final;
 }
+
+
+//The coordinates may be negative, so they are shifted as unsigned values.
+//Each keeps its low 32 bits, which is plenty for any grid in the scene.
+qint64 getGridCellKey(qint64 x, qint64 y)
+{
+    return qint64((quint64(y) << 32) ^ (quint64(x) & 0xffffffff));
+}
@@ -34,7 +34,8 @@ class AssemblyGraph;
 
 enum NodeColourScheme {UNIFORM_COLOURS, RANDOM_COLOURS, READ_DEPTH_COLOUR,
                        BLAST_HITS_RAINBOW_COLOUR, BLAST_HITS_SOLID_COLOUR,
-                       CONTIGUITY_COLOUR, BARCODE_COLOR, CUSTOM_COLOURS};
+                       CONTIGUITY_COLOUR, BARCODE_COLOR, CUSTOM_COLOURS,
+                       CSV_COLOURS};
 
 enum GraphScope {WHOLE_GRAPH, AROUND_NODE, AROUND_BLAST_HITS, READ_DEPTH_RANGE};
 
@@ -45,6 +46,7 @@ enum NodeDragging {ONE_PIECE, NEARBY_PIECES, ALL_PIECES};
 enum ZoomSource {MOUSE_WHEEL, SPIN_BOX, KEYBOARD, GESTURE};
 enum UiState {NO_GRAPH_LOADED, GRAPH_LOADED, GRAPH_DRAWN};
 enum NodeLengthMode {AUTO_NODE_LENGTH, MANUAL_NODE_LENGTH};
+enum LayoutAlgorithm {FMMM_LAYOUT, GRID_LAYOUT};
 enum GraphFileType {LAST_GRAPH, FASTG, GFA, TRINITY, FASTG_BC, ANY_FILE_TYPE,
                     UNKNOWN_FILE_TYPE};
 enum SequenceType {NUCLEOTIDE, PROTEIN, EITHER_NUCLEOTIDE_OR_PROTEIN};
@@ -78,5 +80,9 @@ QString formatIntForDisplay(int num);
 QString formatIntForDisplay(long long num);
 QString formatDoubleForDisplay(double num, int decimalPlacesToDisplay);
 
+//Spatial hashes made of grid cells use this to combine a cell's coordinates
+//into one key.
+qint64 getGridCellKey(qint64 x, qint64 y);
+
 
 #endif // GLOBALS_H
@@ -17,54 +17,563 @@
 
 
 #include "graphlayoutworker.h"
+#include "incrementallayout.h"
+#include "layoutcoarsener.h"
+#include "gridlayout.h"
 #include <time.h>
+#include <stdlib.h>
+#include <limits>
+#include <algorithm>
+#include <math.h>
+#include <QList>
+#include <QFuture>
+#include <QtConcurrentRun>
+#include <ogdf/basic/simple_graph_alg.h>
+
+//Progress is reported as a count out of this total.
+static const int PROGRESS_TOTAL = 1000;
+
+//FMMM takes its random numbers from rand(), whose state is shared by the
+//whole process, so only one FMMM layout may run at a time.
+static QMutex s_fmmmMutex;
+
+//FMMM layouts are run in steps of at most this many iterations.
+static const int FMMM_ITERATIONS_PER_STEP = 10;
+
+//A connected component of the OGDF graph, copied into a graph of its own
+//so it can be laid out independently of (and at the same time as) the
+//other components.
+struct LayoutComponent
+{
+    LayoutComponent() : graphAttributes(0), edgeLengths(0), seed(0), minX(0.0), minY(0.0),
+        width(0.0), height(0.0), offsetX(0.0), offsetY(0.0) {}
+    ~LayoutComponent() {delete edgeLengths; delete graphAttributes;}
+
+    ogdf::Graph graph;
+    ogdf::GraphAttributes * graphAttributes;
+    ogdf::EdgeArray<double> * edgeLengths;
+
+    //The nodes of the full graph and their copies in this component's
+    //graph, in the same order.
+    std::vector<ogdf::node> originalNodes;
+    std::vector<ogdf::node> nodes;
+
+    //Each component's layout has a seed of its own, so no two components
+    //are laid out from the same random numbers.
+    unsigned int seed;
+
+    //The component's bounding box after layout and where packing put it.
+    double minX;
+    double minY;
+    double width;
+    double height;
+    double offsetX;
+    double offsetY;
+};
+
+static bool componentHasMoreNodes(const LayoutComponent * a, const LayoutComponent * b)
+{
+    return a->nodes.size() > b->nodes.size();
+}
+
+static bool componentIsTaller(const LayoutComponent * a, const LayoutComponent * b)
+{
+    return a->height > b->height;
+}
+
+//The component seeds are spread out from the layout's seed, so they depend
+//only on the seed and on the component's place in the graph.
+static unsigned int getComponentSeed(unsigned int seed, int componentIndex)
+{
+    return seed + unsigned(componentIndex) * 2654435761u;
+}
+
+
 
 GraphLayoutWorker::GraphLayoutWorker(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
-                                     int graphLayoutQuality, int segmentLength) :
-    m_fmmm(fmmm), m_graphAttributes(graphAttributes),
-    m_graphLayoutQuality(graphLayoutQuality), m_segmentLength(segmentLength)
+                                     const ogdf::EdgeArray<double> * edgeLengths,
+                                     int graphLayoutQuality, int segmentLength, bool componentLayout,
+                                     bool coarsenChains, int randomSeed, LayoutAlgorithm layoutAlgorithm) :
+    m_fmmm(fmmm), m_graphAttributes(graphAttributes), m_edgeLengths(edgeLengths),
+    m_graphLayoutQuality(graphLayoutQuality), m_segmentLength(segmentLength),
+    m_componentLayout(componentLayout), m_coarsenChains(coarsenChains),
+    m_randomSeed(randomSeed), m_layoutAlgorithm(layoutAlgorithm), m_fixedNodes(0), m_cancelled(false),
+    m_totalWork(0.0), m_completedWork(0.0), m_reportedProgress(0)
 {
 }
 
 
 void GraphLayoutWorker::layoutGraph()
 {
-    m_fmmm->randSeed(clock());
-    m_fmmm->useHighLevelOptions(false);
-    m_fmmm->initialPlacementForces(ogdf::FMMMLayout::ipfRandomRandIterNr);
-    m_fmmm->unitEdgeLength(m_segmentLength);
-    m_fmmm->allowedPositions(ogdf::FMMMLayout::apAll);
+    m_totalWork = m_graphAttributes->constGraph().numberOfNodes();
+    emit setLayoutTotalCount(PROGRESS_TOTAL);
+    emit setLayoutCompletedCount(0);
+
+    if (m_fixedNodes != 0)
+        layoutIncrementally();
+    else if (m_componentLayout)
+        layoutComponents();
+    else
+        runCoarsenedLayout(m_fmmm, m_graphAttributes, *m_edgeLengths, m_totalWork, getRandomSeed());
+
+    emit finishedLayout();
+}
+
+
+void GraphLayoutWorker::setLayoutOptions(ogdf::FMMMLayout * fmmm, unsigned int seed)
+{
+    fmmm->randSeed(seed);
+    fmmm->useHighLevelOptions(false);
+    fmmm->initialPlacementForces(ogdf::FMMMLayout::ipfRandomRandIterNr);
+    fmmm->unitEdgeLength(m_segmentLength);
+    fmmm->allowedPositions(ogdf::FMMMLayout::apAll);
 
     switch (m_graphLayoutQuality)
     {
     case 0:
-        m_fmmm->fixedIterations(3);
-        m_fmmm->fineTuningIterations(1);
-        m_fmmm->nmPrecision(2);
+        fmmm->fixedIterations(3);
+        fmmm->fineTuningIterations(1);
+        fmmm->nmPrecision(2);
         break;
     case 1:
-        m_fmmm->fixedIterations(12);
-        m_fmmm->fineTuningIterations(8);
-        m_fmmm->nmPrecision(2);
+        fmmm->fixedIterations(12);
+        fmmm->fineTuningIterations(8);
+        fmmm->nmPrecision(2);
         break;
     case 2:
-        m_fmmm->fixedIterations(30);
-        m_fmmm->fineTuningIterations(20);
-        m_fmmm->nmPrecision(4);
+        fmmm->fixedIterations(30);
+        fmmm->fineTuningIterations(20);
+        fmmm->nmPrecision(4);
         break;
     case 3:
-        m_fmmm->fixedIterations(60);
-        m_fmmm->fineTuningIterations(40);
-        m_fmmm->nmPrecision(6);
+        fmmm->fixedIterations(60);
+        fmmm->fineTuningIterations(40);
+        fmmm->nmPrecision(6);
         break;
     case 4:
-        m_fmmm->fixedIterations(120);
-        m_fmmm->fineTuningIterations(80);
-        m_fmmm->nmPrecision(8);
+        fmmm->fixedIterations(120);
+        fmmm->fineTuningIterations(80);
+        fmmm->nmPrecision(8);
         break;
     }
+}
 
-    m_fmmm->call(*m_graphAttributes);
 
-    emit finishedLayout();
+//A refinement layout carries on from the nodes' current positions.  It has
+//much less to do than a full layout, so it needs fewer iterations.
+void GraphLayoutWorker::setRefinementOptions(ogdf::FMMMLayout * fmmm)
+{
+    setKeepPositionsOptions(fmmm);
+    fmmm->fixedIterations(std::max(1, fmmm->fixedIterations() / 4));
+    fmmm->fineTuningIterations(std::max(1, fmmm->fineTuningIterations() / 4));
+}
+
+
+//These options make FMMM start from the nodes' current positions and only
+//run on the full graph, without its own coarsening.
+void GraphLayoutWorker::setKeepPositionsOptions(ogdf::FMMMLayout * fmmm)
+{
+    fmmm->initialPlacementForces(ogdf::FMMMLayout::ipfKeepPositions);
+    fmmm->minGraphSize(std::numeric_limits<int>::max());
+}
+
+
+//This function runs one FMMM layout.  FMMM has no way to report its
+//progress or to be stopped part way through, so the layout is driven here
+//in steps of at most FMMM_ITERATIONS_PER_STEP iterations.  The first step
+//is an ordinary FMMM call, with its coarsening, but only the first of the
+//fixed iterations.  Each later step carries on from the positions the last
+//one left, on the full graph, and the fine tuning iterations come last.
+//So only layouts with few iterations (quality 0) are the same as one FMMM
+//call.  After each step the work done so far is reported, and a cancelled
+//layout stops, leaving the graph in its current state.  FMMM's options are
+//only changed here, between steps, on the thread running the layout.
+//FMMM draws random numbers from rand(), so each step is seeded just before
+//it starts and no other FMMM layout runs until it is done.  A seeded layout
+//then depends only on its seed, even when components are laid out on
+//several threads.
+void GraphLayoutWorker::runLayout(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
+                                  const ogdf::EdgeArray<double> & edgeLengths, bool refinement,
+                                  double work, unsigned int seed)
+{
+    if (m_layoutAlgorithm == GRID_LAYOUT)
+    {
+        runGridLayout(graphAttributes, edgeLengths, work, seed);
+        return;
+    }
+
+    setLayoutOptions(fmmm, seed);
+    if (refinement)
+        setRefinementOptions(fmmm);
+    int fixedIterations = fmmm->fixedIterations();
+    int fineTuningIterations = fmmm->fineTuningIterations();
+    int totalIterations = fixedIterations + fineTuningIterations;
+
+    int fixedDone = 0;
+    int fineTuningDone = 0;
+    for (int step = 0; ; ++step)
+    {
+        if (step > 0 && (fixedDone + fineTuningDone >= totalIterations || isCancelled()))
+            break;
+
+        int stepFixed = fixedIterations;
+        int stepFineTuning = fineTuningIterations;
+        if (totalIterations > FMMM_ITERATIONS_PER_STEP)
+        {
+            stepFixed = std::min(FMMM_ITERATIONS_PER_STEP, fixedIterations - fixedDone);
+            stepFineTuning = 0;
+            if (stepFixed == 0)
+                stepFineTuning = std::min(FMMM_ITERATIONS_PER_STEP, fineTuningIterations - fineTuningDone);
+        }
+
+        //A layout cancelled before it starts still places its nodes, so the
+        //graph can be drawn.
+        if (step == 0 && isCancelled())
+        {
+            stepFixed = 0;
+            stepFineTuning = 0;
+        }
+
+        if (step > 0)
+            setKeepPositionsOptions(fmmm);
+        fmmm->fixedIterations(stepFixed);
+        fmmm->fineTuningIterations(stepFineTuning);
+
+        s_fmmmMutex.lock();
+        srand(seed + unsigned(step));
+        fmmm->call(*graphAttributes, edgeLengths);
+        s_fmmmMutex.unlock();
+
+        fixedDone += stepFixed;
+        fineTuningDone += stepFineTuning;
+        addProgress(work * (stepFixed + stepFineTuning) / std::max(1, totalIterations));
+    }
+}
+
+
+//This function can be called from any thread.  The progress signal is only
+//sent when the reported count changes, so many small layouts don't flood
+//the receiver with signals.
+void GraphLayoutWorker::addProgress(double work)
+{
+    int progress;
+    {
+        QMutexLocker locker(&m_progressMutex);
+        m_completedWork += work;
+        if (m_totalWork <= 0.0)
+            return;
+        progress = std::min(PROGRESS_TOTAL, int(PROGRESS_TOTAL * m_completedWork / m_totalWork));
+        if (progress <= m_reportedProgress)
+            return;
+        m_reportedProgress = progress;
+    }
+    emit setLayoutCompletedCount(progress);
+}
+
+
+//This function runs the grid layout, which does its own coarsening and
+//can be stopped after any iteration.
+void GraphLayoutWorker::runGridLayout(ogdf::GraphAttributes * graphAttributes,
+                                      const ogdf::EdgeArray<double> & edgeLengths, double work,
+                                      unsigned int seed)
+{
+    int iterationsPerLevel = 0;
+    switch (m_graphLayoutQuality)
+    {
+    case 0:
+        iterationsPerLevel = 10;
+        break;
+    case 1:
+        iterationsPerLevel = 20;
+        break;
+    case 2:
+        iterationsPerLevel = 40;
+        break;
+    case 3:
+        iterationsPerLevel = 70;
+        break;
+    case 4:
+        iterationsPerLevel = 120;
+        break;
+    }
+
+    GridLayout gridLayout(graphAttributes, &edgeLengths, m_segmentLength, iterationsPerLevel, seed);
+    while (!gridLayout.isFinished() && !isCancelled())
+    {
+        double progressBefore = gridLayout.getProgress();
+        gridLayout.iterate();
+        addProgress(work * (gridLayout.getProgress() - progressBefore));
+    }
+    gridLayout.savePositions();
+}
+
+
+//This function lays out a graph by first laying out a coarse copy of it,
+//with its unbranched chains each replaced by a single node, and then
+//refining the expanded layout.  If there are no chains worth replacing,
+//the graph is just laid out as it is.  The grid layout merges chains as
+//part of its own coarsening, so it doesn't need this.
+void GraphLayoutWorker::runCoarsenedLayout(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
+                                           const ogdf::EdgeArray<double> & edgeLengths, double work,
+                                           unsigned int seed)
+{
+    if (!m_coarsenChains || m_layoutAlgorithm == GRID_LAYOUT)
+    {
+        runLayout(fmmm, graphAttributes, edgeLengths, false, work, seed);
+        return;
+    }
+
+    LayoutCoarsener coarsener(graphAttributes, &edgeLengths);
+    if (coarsener.getChainCount() == 0)
+    {
+        runLayout(fmmm, graphAttributes, edgeLengths, false, work, seed);
+        return;
+    }
+
+    //The refinement is on the full graph but has few iterations, so it is
+    //counted as a fifth of the work.
+    runLayout(fmmm, coarsener.m_coarseGraphAttributes, *coarsener.m_coarseEdgeLengths, false, work * 0.8, seed);
+    coarsener.expand(graphAttributes);
+    if (!isCancelled())
+        runLayout(fmmm, graphAttributes, edgeLengths, true, work * 0.2, seed);
+}
+
+
+//This function can be called from any thread.  Running layouts stop after
+//their current step or iteration and layouts that haven't started yet will
+//skip their iterations, so the graph is shown in its current, incomplete
+//state.
+void GraphLayoutWorker::cancelLayout()
+{
+    QMutexLocker locker(&m_cancelMutex);
+    m_cancelled = true;
+}
+
+
+bool GraphLayoutWorker::isCancelled()
+{
+    QMutexLocker locker(&m_cancelMutex);
+    return m_cancelled;
+}
+
+
+unsigned int GraphLayoutWorker::getRandomSeed() const
+{
+    if (m_randomSeed < 0)
+        return clock();
+    return m_randomSeed;
+}
+
+
+//This function splits the graph into its connected components and lays
+//them out concurrently on the global thread pool.  FMMM layouts still run
+//one at a time (see runLayout), but grid layouts, coarsening and the rest
+//of each component's work overlap.  The finished components are then
+//packed together and their positions copied back to the graph.
+void GraphLayoutWorker::layoutComponents()
+{
+    const ogdf::Graph & graph = m_graphAttributes->constGraph();
+    ogdf::NodeArray<int> componentIndices(graph);
+    int componentCount = ogdf::connectedComponents(graph, componentIndices);
+
+    //A graph in one piece gains nothing from being copied.
+    unsigned int seed = getRandomSeed();
+    if (componentCount < 2)
+    {
+        runCoarsenedLayout(m_fmmm, m_graphAttributes, *m_edgeLengths, m_totalWork, seed);
+        return;
+    }
+
+    std::vector<LayoutComponent *> components;
+    for (int i = 0; i < componentCount; ++i)
+    {
+        components.push_back(new LayoutComponent());
+        components.back()->seed = getComponentSeed(seed, i);
+    }
+
+    ogdf::NodeArray<ogdf::node> componentNodes(graph);
+    ogdf::node v;
+    forall_nodes(v, graph)
+    {
+        LayoutComponent * component = components[componentIndices[v]];
+        ogdf::node componentNode = component->graph.newNode();
+        componentNodes[v] = componentNode;
+        component->originalNodes.push_back(v);
+        component->nodes.push_back(componentNode);
+    }
+
+    ogdf::EdgeArray<ogdf::edge> componentEdges(graph);
+    ogdf::edge e;
+    forall_edges(e, graph)
+    {
+        LayoutComponent * component = components[componentIndices[e->source()]];
+        componentEdges[e] = component->graph.newEdge(componentNodes[e->source()], componentNodes[e->target()]);
+    }
+
+    //Node sizes and edge lengths affect the layout, so they are carried
+    //over to the copies.
+    for (size_t i = 0; i < components.size(); ++i)
+    {
+        LayoutComponent * component = components[i];
+        component->graphAttributes = new ogdf::GraphAttributes(component->graph,
+                                                               ogdf::GraphAttributes::nodeGraphics |
+                                                               ogdf::GraphAttributes::edgeGraphics);
+        component->edgeLengths = new ogdf::EdgeArray<double>(component->graph, 1.0);
+        for (size_t j = 0; j < component->nodes.size(); ++j)
+        {
+            component->graphAttributes->width(component->nodes[j]) = m_graphAttributes->width(component->originalNodes[j]);
+            component->graphAttributes->height(component->nodes[j]) = m_graphAttributes->height(component->originalNodes[j]);
+        }
+    }
+
+    forall_edges(e, graph)
+    {
+        LayoutComponent * component = components[componentIndices[e->source()]];
+        (*component->edgeLengths)[componentEdges[e]] = (*m_edgeLengths)[e];
+    }
+
+    //The biggest components are queued first, so the slowest layouts start
+    //straight away and the many small ones fill in around them.  Each
+    //component has its own seed and random numbers, so a seeded layout comes
+    //out the same whichever order the components run in.
+    std::stable_sort(components.begin(), components.end(), componentHasMoreNodes);
+    QList<QFuture<void> > layouts;
+    for (size_t i = 0; i < components.size(); ++i)
+        layouts.push_back(QtConcurrent::run(this, &GraphLayoutWorker::layoutComponent, components[i]));
+    for (int i = 0; i < layouts.size(); ++i)
+        layouts[i].waitForFinished();
+
+    packComponents(&components);
+
+    for (size_t i = 0; i < components.size(); ++i)
+    {
+        LayoutComponent * component = components[i];
+        for (size_t j = 0; j < component->nodes.size(); ++j)
+        {
+            ogdf::node componentNode = component->nodes[j];
+            ogdf::node originalNode = component->originalNodes[j];
+            m_graphAttributes->x(originalNode) = component->graphAttributes->x(componentNode) + component->offsetX;
+            m_graphAttributes->y(originalNode) = component->graphAttributes->y(componentNode) + component->offsetY;
+        }
+        delete component;
+    }
+}
+
+
+//This function lays out one component and then finds its bounding box.
+//It runs on the thread pool, so it only touches its own component.
+void GraphLayoutWorker::layoutComponent(LayoutComponent * component)
+{
+    //A lone node needs no layout - it just stays at the origin.
+    if (component->nodes.size() > 1)
+    {
+        ogdf::FMMMLayout fmmm;
+        runCoarsenedLayout(&fmmm, component->graphAttributes, *component->edgeLengths,
+                           double(component->nodes.size()), component->seed);
+    }
+    else
+        addProgress(double(component->nodes.size()));
+
+    double minX = std::numeric_limits<double>::max();
+    double minY = std::numeric_limits<double>::max();
+    double maxX = std::numeric_limits<double>::lowest();
+    double maxY = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < component->nodes.size(); ++i)
+    {
+        ogdf::node node = component->nodes[i];
+        double x = component->graphAttributes->x(node);
+        double y = component->graphAttributes->y(node);
+        double halfWidth = component->graphAttributes->width(node) / 2.0;
+        double halfHeight = component->graphAttributes->height(node) / 2.0;
+        minX = std::min(minX, x - halfWidth);
+        minY = std::min(minY, y - halfHeight);
+        maxX = std::max(maxX, x + halfWidth);
+        maxY = std::max(maxY, y + halfHeight);
+    }
+
+    component->minX = minX;
+    component->minY = minY;
+    component->width = maxX - minX;
+    component->height = maxY - minY;
+}
+
+
+//This function arranges the laid out components in rows, tallest first.
+//The row width is chosen so the packed graph has roughly the same page
+//ratio that FMMM would have used for the whole graph.
+void GraphLayoutWorker::packComponents(std::vector<LayoutComponent *> * components)
+{
+    double spacing = m_fmmm->minDistCC();
+
+    std::vector<LayoutComponent *> sortedComponents = *components;
+    std::stable_sort(sortedComponents.begin(), sortedComponents.end(), componentIsTaller);
+
+    double totalArea = 0.0;
+    double widestComponent = 0.0;
+    for (size_t i = 0; i < sortedComponents.size(); ++i)
+    {
+        LayoutComponent * component = sortedComponents[i];
+        totalArea += (component->width + spacing) * (component->height + spacing);
+        widestComponent = std::max(widestComponent, component->width);
+    }
+    double rowWidth = std::max(widestComponent, sqrt(totalArea * m_fmmm->pageRatio()));
+
+    double x = 0.0;
+    double y = 0.0;
+    double rowHeight = 0.0;
+    for (size_t i = 0; i < sortedComponents.size(); ++i)
+    {
+        LayoutComponent * component = sortedComponents[i];
+        if (x > 0.0 && x + component->width > rowWidth)
+        {
+            x = 0.0;
+            y += rowHeight + spacing;
+            rowHeight = 0.0;
+        }
+
+        component->offsetX = x - component->minX;
+        component->offsetY = y - component->minY;
+        x += component->width + spacing;
+        rowHeight = std::max(rowHeight, component->height);
+    }
+}
+
+
+//This function lays out only the nodes that aren't fixed, leaving the rest
+//of the layout as it was.  The number of iterations follows the layout
+//quality setting, and nodes may move less each iteration as they settle.
+//The same incremental layout is used whichever layout algorithm is set.
+void GraphLayoutWorker::layoutIncrementally()
+{
+    IncrementalLayout incrementalLayout(m_graphAttributes, m_fixedNodes, m_edgeLengths, m_segmentLength, getRandomSeed());
+    incrementalLayout.placeFreeNodes();
+
+    int iterations = 0;
+    switch (m_graphLayoutQuality)
+    {
+    case 0:
+        iterations = 10;
+        break;
+    case 1:
+        iterations = 25;
+        break;
+    case 2:
+        iterations = 50;
+        break;
+    case 3:
+        iterations = 100;
+        break;
+    case 4:
+        iterations = 200;
+        break;
+    }
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        if (isCancelled())
+            break;
+        double maxMove = m_segmentLength * (1.0 - double(i) / iterations);
+        incrementalLayout.iterate(maxMove);
+        addProgress(m_totalWork / iterations);
+    }
 }
@@ -20,9 +20,13 @@
 #define GRAPHLAYOUTWORKER_H
 
 #include <QObject>
+#include <QMutex>
+#include <vector>
 #include <ogdf/energybased/FMMMLayout.h>
 #include "ogdf/basic/GraphAttributes.h"
+#include "globals.h"
 
+struct LayoutComponent;
 
 class GraphLayoutWorker : public QObject
 {
@@ -30,18 +34,67 @@ class GraphLayoutWorker : public QObject
 
 public:
     GraphLayoutWorker(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
-                      int graphLayoutQuality, int segmentLength);
+                      const ogdf::EdgeArray<double> * edgeLengths,
+                      int graphLayoutQuality, int segmentLength, bool componentLayout,
+                      bool coarsenChains, int randomSeed, LayoutAlgorithm layoutAlgorithm);
 
     ogdf::FMMMLayout * m_fmmm;
     ogdf::GraphAttributes * m_graphAttributes;
+
+    //Each edge's desired length, as a multiple of the segment length.
+    const ogdf::EdgeArray<double> * m_edgeLengths;
+
     int m_graphLayoutQuality;
     int m_segmentLength;
+    bool m_componentLayout;
+    bool m_coarsenChains;
+
+    //If this is negative, layouts are seeded from the clock.
+    int m_randomSeed;
+
+    LayoutAlgorithm m_layoutAlgorithm;
+
+    //If this is set, the nodes marked in it keep their positions and only
+    //the other nodes are laid out.
+    const ogdf::NodeArray<bool> * m_fixedNodes;
+
+    void setLayoutOptions(ogdf::FMMMLayout * fmmm, unsigned int seed);
 
 public slots:
     void layoutGraph();
+    void cancelLayout();
 
 signals:
     void finishedLayout();
+    void setLayoutTotalCount(int totalCount);
+    void setLayoutCompletedCount(int completedCount);
+
+private:
+    QMutex m_cancelMutex;
+    bool m_cancelled;
+
+    //Work is counted in nodes laid out, across all components.
+    QMutex m_progressMutex;
+    double m_totalWork;
+    double m_completedWork;
+    int m_reportedProgress;
+
+    bool isCancelled();
+    unsigned int getRandomSeed() const;
+    void setKeepPositionsOptions(ogdf::FMMMLayout * fmmm);
+    void setRefinementOptions(ogdf::FMMMLayout * fmmm);
+    void runLayout(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
+                   const ogdf::EdgeArray<double> & edgeLengths, bool refinement, double work,
+                   unsigned int seed);
+    void runCoarsenedLayout(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
+                            const ogdf::EdgeArray<double> & edgeLengths, double work, unsigned int seed);
+    void runGridLayout(ogdf::GraphAttributes * graphAttributes,
+                       const ogdf::EdgeArray<double> & edgeLengths, double work, unsigned int seed);
+    void addProgress(double work);
+    void layoutComponents();
+    void layoutComponent(LayoutComponent * component);
+    void packComponents(std::vector<LayoutComponent *> * components);
+    void layoutIncrementally();
 };
 
 #endif // GRAPHLAYOUTWORKER_H
@@ -0,0 +1,372 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gridlayout.h"
+#include <math.h>
+#include <algorithm>
+#include <QtConcurrentMap>
+
+static const double TWO_PI = 6.283185307179586;
+
+//Coarsening stops when a level is this small, when a level has this many
+//levels above it, or when merging fails to shrink a level by at least 10%.
+static const int MIN_COARSE_NODES = 50;
+static const size_t MAX_LEVELS = 40;
+static const double MAX_COARSENING_RATIO = 0.9;
+
+//Each iteration moves the nodes in chunks of this size.
+static const int CHUNK_SIZE = 4096;
+
+struct GridLayoutChunk
+{
+    GridLayout * layout;
+    int start;
+    int end;
+};
+
+static void moveGridLayoutChunk(GridLayoutChunk & chunk)
+{
+    chunk.layout->moveChunk(chunk.start, chunk.end);
+}
+
+
+
+GridLayout::GridLayout(ogdf::GraphAttributes * graphAttributes, const ogdf::EdgeArray<double> * edgeLengths,
+                       double edgeLength, int iterationsPerLevel, unsigned int seed) :
+    m_graphAttributes(graphAttributes), m_edgeLength(edgeLength),
+    m_iterationsPerLevel(std::max(1, iterationsPerLevel)), m_randomState(seed),
+    m_currentLevel(0), m_levelIteration(0), m_totalWork(0.0), m_completedWork(0.0)
+{
+    buildFinestLevel(*edgeLengths);
+    while (m_levels.size() < MAX_LEVELS && m_levels.back().nodeCount > MIN_COARSE_NODES)
+    {
+        if (!buildCoarserLevel())
+            break;
+    }
+
+    for (size_t i = 0; i < m_levels.size(); ++i)
+        m_totalWork += double(m_levels[i].nodeCount) * m_iterationsPerLevel;
+
+    m_currentLevel = int(m_levels.size()) - 1;
+    placeCoarsestLevel();
+
+    //An empty graph has nothing to do.
+    if (m_levels[0].nodeCount == 0)
+    {
+        m_currentLevel = 0;
+        m_levelIteration = m_iterationsPerLevel;
+    }
+}
+
+
+bool GridLayout::isFinished() const
+{
+    return m_currentLevel == 0 && m_levelIteration >= m_iterationsPerLevel;
+}
+
+
+//Progress is the share of node moves done so far, so the big finer levels
+//count for more than the small coarse ones.
+double GridLayout::getProgress() const
+{
+    if (m_totalWork <= 0.0)
+        return 1.0;
+    return std::min(1.0, m_completedWork / m_totalWork);
+}
+
+
+//This returns a number from 0 to 1, using its own simple generator so the
+//layout is reproducible from its seed.
+double GridLayout::getRandomFraction()
+{
+    m_randomState = m_randomState * 1103515245 + 12345;
+    return double((m_randomState >> 8) & 0xFFFFFF) / double(0x1000000);
+}
+
+
+//This function stores each node's edges, with parallel edges merged into
+//the shortest of them.
+void GridLayout::setLevelEdges(Level * level, std::vector<std::vector<std::pair<int, double> > > * adjacency)
+{
+    level->edgeStarts.assign(level->nodeCount + 1, 0);
+    level->edgeTargets.clear();
+    level->edgeLengths.clear();
+
+    double totalLength = 0.0;
+    for (int i = 0; i < level->nodeCount; ++i)
+    {
+        std::vector<std::pair<int, double> > & edges = (*adjacency)[i];
+        std::sort(edges.begin(), edges.end());
+        for (size_t j = 0; j < edges.size(); ++j)
+        {
+            if (j > 0 && edges[j].first == edges[j - 1].first)
+                continue;
+            level->edgeTargets.push_back(edges[j].first);
+            level->edgeLengths.push_back(edges[j].second);
+            totalLength += edges[j].second;
+        }
+        level->edgeStarts[i + 1] = int(level->edgeTargets.size());
+    }
+
+    if (level->edgeLengths.empty())
+        level->meanEdgeLength = 1.0;
+    else
+        level->meanEdgeLength = totalLength / level->edgeLengths.size();
+}
+
+
+void GridLayout::buildFinestLevel(const ogdf::EdgeArray<double> & edgeLengths)
+{
+    const ogdf::Graph & graph = m_graphAttributes->constGraph();
+    ogdf::NodeArray<int> indices(graph);
+    ogdf::node v;
+    forall_nodes(v, graph)
+    {
+        indices[v] = int(m_ogdfNodes.size());
+        m_ogdfNodes.push_back(v);
+    }
+
+    Level level;
+    level.nodeCount = int(m_ogdfNodes.size());
+    level.weights.assign(level.nodeCount, 1.0);
+    level.internalLengths.assign(level.nodeCount, 0.0);
+
+    std::vector<std::vector<std::pair<int, double> > > adjacency(level.nodeCount);
+    ogdf::edge e;
+    forall_edges(e, graph)
+    {
+        int source = indices[e->source()];
+        int target = indices[e->target()];
+        if (source == target)
+            continue;
+        adjacency[source].push_back(std::make_pair(target, edgeLengths[e]));
+        adjacency[target].push_back(std::make_pair(source, edgeLengths[e]));
+    }
+    setLevelEdges(&level, &adjacency);
+
+    m_levels.push_back(level);
+}
+
+
+//This function makes the next coarser level by visiting the nodes in a
+//random order and merging each unmerged node with its lightest unmerged
+//neighbour.  Preferring light neighbours keeps the merged nodes similar in
+//size, so chains are halved evenly.  The length of a coarse edge includes
+//half of the length already merged inside each of its two nodes, so a
+//coarse chain keeps the length of the chain it came from.  It returns
+//false if the level didn't shrink enough to be worth making.
+bool GridLayout::buildCoarserLevel()
+{
+    const Level & fine = m_levels.back();
+    int n = fine.nodeCount;
+
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i)
+        order[i] = i;
+    for (int i = n - 1; i > 0; --i)
+    {
+        int j = std::min(i, int(getRandomFraction() * (i + 1)));
+        std::swap(order[i], order[j]);
+    }
+
+    Level coarse;
+    coarse.nodeCount = 0;
+    std::vector<int> parents(n, -1);
+    for (int k = 0; k < n; ++k)
+    {
+        int node = order[k];
+        if (parents[node] >= 0)
+            continue;
+
+        int partner = -1;
+        double partnerEdgeLength = 0.0;
+        for (int e = fine.edgeStarts[node]; e < fine.edgeStarts[node + 1]; ++e)
+        {
+            int neighbour = fine.edgeTargets[e];
+            if (parents[neighbour] >= 0)
+                continue;
+            if (partner < 0 || fine.weights[neighbour] < fine.weights[partner])
+            {
+                partner = neighbour;
+                partnerEdgeLength = fine.edgeLengths[e];
+            }
+        }
+
+        parents[node] = coarse.nodeCount;
+        double weight = fine.weights[node];
+        double internalLength = fine.internalLengths[node];
+        if (partner >= 0)
+        {
+            parents[partner] = coarse.nodeCount;
+            weight += fine.weights[partner];
+            internalLength += fine.internalLengths[partner] + partnerEdgeLength;
+        }
+        coarse.weights.push_back(weight);
+        coarse.internalLengths.push_back(internalLength);
+        ++coarse.nodeCount;
+    }
+
+    if (coarse.nodeCount > n * MAX_COARSENING_RATIO)
+        return false;
+
+    std::vector<std::vector<std::pair<int, double> > > adjacency(coarse.nodeCount);
+    for (int i = 0; i < n; ++i)
+    {
+        int coarseSource = parents[i];
+        for (int e = fine.edgeStarts[i]; e < fine.edgeStarts[i + 1]; ++e)
+        {
+            int coarseTarget = parents[fine.edgeTargets[e]];
+            if (coarseSource == coarseTarget)
+                continue;
+            double length = fine.edgeLengths[e] + (coarse.internalLengths[coarseSource] +
+                                                   coarse.internalLengths[coarseTarget]) / 2.0;
+            adjacency[coarseSource].push_back(std::make_pair(coarseTarget, length));
+        }
+    }
+    setLevelEdges(&coarse, &adjacency);
+
+    m_levels.back().parents = parents;
+    m_levels.push_back(coarse);
+    return true;
+}
+
+
+//The coarsest level starts with its nodes scattered at random over a
+//square big enough to hold them.
+void GridLayout::placeCoarsestLevel()
+{
+    const Level & level = m_levels.back();
+    double side = sqrt(double(level.nodeCount)) * level.meanEdgeLength * m_edgeLength;
+    m_x.resize(level.nodeCount);
+    m_y.resize(level.nodeCount);
+    for (int i = 0; i < level.nodeCount; ++i)
+    {
+        m_x[i] = getRandomFraction() * side;
+        m_y[i] = getRandomFraction() * side;
+    }
+}
+
+
+//This function moves down to the next finer level.  Each node starts near
+//the position of the coarse node it was merged into, offset a little in a
+//random direction so merged nodes don't start on top of each other.
+void GridLayout::prolong()
+{
+    const Level & fine = m_levels[m_currentLevel - 1];
+    double offset = fine.meanEdgeLength * m_edgeLength * 0.5;
+
+    std::vector<double> x(fine.nodeCount);
+    std::vector<double> y(fine.nodeCount);
+    for (int i = 0; i < fine.nodeCount; ++i)
+    {
+        int parent = fine.parents[i];
+        double angle = getRandomFraction() * TWO_PI;
+        x[i] = m_x[parent] + cos(angle) * offset;
+        y[i] = m_y[parent] + sin(angle) * offset;
+    }
+    m_x.swap(x);
+    m_y.swap(y);
+
+    --m_currentLevel;
+    m_levelIteration = 0;
+}
+
+
+//This function runs one iteration on the current level, moving to the next
+//finer level first if the current one is done.  The coarsest level starts
+//from random positions, so its nodes may move further at first.
+void GridLayout::iterate()
+{
+    if (isFinished())
+        return;
+    if (m_levelIteration >= m_iterationsPerLevel)
+        prolong();
+
+    const Level & level = m_levels[m_currentLevel];
+    double edgeLength = level.meanEdgeLength * m_edgeLength;
+    double startMove = edgeLength;
+    if (m_currentLevel == int(m_levels.size()) - 1)
+        startMove *= 5.0;
+    double fraction = double(m_levelIteration) / m_iterationsPerLevel;
+
+    m_forceParameters.edgeLength = edgeLength;
+    m_forceParameters.edgeLengthUnit = m_edgeLength;
+    m_forceParameters.repulsionRange = edgeLength * 2.0;
+    m_forceParameters.maxMove = startMove * (1.0 - fraction) + edgeLength * 0.05;
+
+    m_forceNodes.nodeCount = level.nodeCount;
+    m_forceNodes.x = m_x.data();
+    m_forceNodes.y = m_y.data();
+    m_forceNodes.weights = level.weights.data();
+    m_forceNodes.edgeStarts = level.edgeStarts.data();
+    m_forceNodes.edgeTargets = level.edgeTargets.data();
+    m_forceNodes.edgeLengths = level.edgeLengths.data();
+
+    m_forceKernel.buildGrid(m_forceNodes, m_forceParameters);
+    m_moveX.assign(level.nodeCount, 0.0);
+    m_moveY.assign(level.nodeCount, 0.0);
+
+    std::vector<GridLayoutChunk> chunks;
+    for (int start = 0; start < level.nodeCount; start += CHUNK_SIZE)
+    {
+        GridLayoutChunk chunk;
+        chunk.layout = this;
+        chunk.start = start;
+        chunk.end = std::min(start + CHUNK_SIZE, level.nodeCount);
+        chunks.push_back(chunk);
+    }
+    if (chunks.size() == 1)
+        moveChunk(chunks[0].start, chunks[0].end);
+    else if (chunks.size() > 1)
+        QtConcurrent::blockingMap(chunks, moveGridLayoutChunk);
+
+    for (int i = 0; i < level.nodeCount; ++i)
+    {
+        m_x[i] += m_moveX[i];
+        m_y[i] += m_moveY[i];
+    }
+
+    m_completedWork += level.nodeCount;
+    ++m_levelIteration;
+}
+
+
+//This function works out the moves for a range of nodes.  It only reads
+//positions and only writes the moves for its own nodes, so chunks can run
+//at the same time.
+void GridLayout::moveChunk(int start, int end)
+{
+    m_forceKernel.getMoves(m_forceNodes, m_forceParameters, start, end,
+                           m_moveX.data(), m_moveY.data());
+}
+
+
+//This function copies the positions to the graph.  If the layout was
+//stopped early, the remaining levels are expanded without any more
+//iterations, so every node still gets a position.
+void GridLayout::savePositions()
+{
+    while (m_currentLevel > 0)
+        prolong();
+
+    for (size_t i = 0; i < m_ogdfNodes.size(); ++i)
+    {
+        m_graphAttributes->x(m_ogdfNodes[i]) = m_x[i];
+        m_graphAttributes->y(m_ogdfNodes[i]) = m_y[i];
+    }
+}
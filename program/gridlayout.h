@@ -0,0 +1,97 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GRIDLAYOUT_H
+#define GRIDLAYOUT_H
+
+#include <vector>
+#include <utility>
+#include <ogdf/basic/Graph.h>
+#include <ogdf/basic/GraphAttributes.h>
+#include "forcekernel.h"
+
+//GridLayout is a multilevel force-directed layout, meant for graphs too big
+//for FMMM.  The graph is repeatedly coarsened by merging nodes with one of
+//their neighbours, which halves long chains at each level.  The coarsest
+//graph is laid out from random positions, and then each finer level starts
+//from the level above it.  Repulsion only acts between nearby nodes, found
+//with ForceKernel's grid, so each iteration takes time in proportion to the
+//number of nodes.  Within an iteration the nodes are moved in parallel
+//chunks on the global thread pool.  Every node's move only depends on the
+//positions from the previous iteration, so the result doesn't depend on
+//the thread count.
+
+class GridLayout
+{
+public:
+    GridLayout(ogdf::GraphAttributes * graphAttributes, const ogdf::EdgeArray<double> * edgeLengths,
+               double edgeLength, int iterationsPerLevel, unsigned int seed);
+
+    int getLevelCount() const {return int(m_levels.size());}
+    bool isFinished() const;
+    double getProgress() const;
+    void iterate();
+    void moveChunk(int start, int end);
+    void savePositions();
+
+private:
+    //One level of the multilevel graph, with its edges stored as arrays:
+    //the edges of node i are edgeStarts[i] to edgeStarts[i+1] - 1.  Edge
+    //lengths are multiples of the layout's edge length.
+    struct Level
+    {
+        int nodeCount;
+        std::vector<int> edgeStarts;
+        std::vector<int> edgeTargets;
+        std::vector<double> edgeLengths;
+        std::vector<double> weights;
+        std::vector<double> internalLengths;
+        std::vector<int> parents;
+        double meanEdgeLength;
+    };
+
+    ogdf::GraphAttributes * m_graphAttributes;
+    std::vector<ogdf::node> m_ogdfNodes;
+    double m_edgeLength;
+    int m_iterationsPerLevel;
+    unsigned int m_randomState;
+
+    std::vector<Level> m_levels;
+    int m_currentLevel;
+    int m_levelIteration;
+    double m_totalWork;
+    double m_completedWork;
+
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<double> m_moveX;
+    std::vector<double> m_moveY;
+
+    ForceKernel m_forceKernel;
+    ForceNodes m_forceNodes;
+    ForceParameters m_forceParameters;
+
+    double getRandomFraction();
+    static void setLevelEdges(Level * level, std::vector<std::vector<std::pair<int, double> > > * adjacency);
+    void buildFinestLevel(const ogdf::EdgeArray<double> & edgeLengths);
+    bool buildCoarserLevel();
+    void placeCoarsestLevel();
+    void prolong();
+};
+
+#endif // GRIDLAYOUT_H
@@ -0,0 +1,382 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gzipfile.h"
+#include <QThread>
+#include <QtConcurrentRun>
+#include <string.h>
+
+//Plain gzip files are read and inflated in chunks of this size.
+static const int GZIP_CHUNK_SIZE = 65536;
+
+//A BGZF block never holds more than this much uncompressed data.
+static const unsigned int BGZF_MAX_BLOCK_SIZE = 65536;
+
+
+//This function reads the uncompressed size (ISIZE) from the last four bytes
+//of a gzip member.
+static unsigned int getUncompressedSize(const QByteArray & block)
+{
+    const unsigned char * isize = reinterpret_cast<const unsigned char *>(block.constData()) + block.size() - 4;
+    return isize[0] | (isize[1] << 8) | (isize[2] << 16) | (unsigned(isize[3]) << 24);
+}
+
+
+//This function inflates one complete BGZF block.  It runs on the thread
+//pool, so it only touches the block it was given.
+static BgzfBlock inflateBgzfBlock(QByteArray block)
+{
+    BgzfBlock result;
+    result.ok = false;
+
+    int blockSize = block.size();
+    if (blockSize < 26)
+        return result;
+    unsigned int uncompressedSize = getUncompressedSize(block);
+    if (uncompressedSize > BGZF_MAX_BLOCK_SIZE)
+        return result;
+
+    result.data.resize(uncompressedSize);
+    if (uncompressedSize == 0)
+    {
+        result.ok = true;
+        return result;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+        return result;
+
+    stream.next_in = reinterpret_cast<Bytef *>(block.data());
+    stream.avail_in = blockSize;
+    stream.next_out = reinterpret_cast<Bytef *>(result.data.data());
+    stream.avail_out = uncompressedSize;
+
+    int inflateResult = inflate(&stream, Z_FINISH);
+    result.ok = (inflateResult == Z_STREAM_END && stream.total_out == uncompressedSize);
+    inflateEnd(&stream);
+
+    return result;
+}
+
+
+
+GzipFile::GzipFile(QString fullFileName) :
+    m_file(fullFileName), m_format(PLAIN_FILE), m_streamInitialised(false),
+    m_outPosition(0), m_finished(true), m_error(false), m_memberComplete(false)
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+    m_maxPendingBlocks = qMax(4, QThread::idealThreadCount() * 4);
+}
+
+GzipFile::~GzipFile()
+{
+    if (isOpen())
+        close();
+}
+
+
+bool GzipFile::open(OpenMode mode)
+{
+    if (mode & QIODevice::WriteOnly)
+        return false;
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    m_format = getFormatFromHeader(m_file.peek(18));
+    m_error = false;
+    m_memberComplete = false;
+
+    if (m_format == GZIP_FILE)
+    {
+        memset(&m_stream, 0, sizeof(m_stream));
+        if (inflateInit2(&m_stream, 16 + MAX_WBITS) != Z_OK)
+        {
+            m_file.close();
+            return false;
+        }
+        m_streamInitialised = true;
+    }
+
+    QIODevice::open(mode);
+
+    m_finished = (m_format == PLAIN_FILE);
+    fillOutputBuffer();
+    return true;
+}
+
+
+void GzipFile::close()
+{
+    //Any blocks still being inflated must finish before their futures go.
+    for (int i = 0; i < m_pendingBlocks.size(); ++i)
+        m_pendingBlocks[i].waitForFinished();
+    m_pendingBlocks.clear();
+
+    if (m_streamInitialised)
+        inflateEnd(&m_stream);
+    m_streamInitialised = false;
+
+    m_inBuffer.clear();
+    m_outBuffer.clear();
+    m_outPosition = 0;
+    m_finished = true;
+    m_file.close();
+    QIODevice::close();
+}
+
+
+qint64 GzipFile::bytesAvailable() const
+{
+    if (m_format == PLAIN_FILE)
+        return m_file.bytesAvailable() + QIODevice::bytesAvailable();
+
+    //fillOutputBuffer always leaves unread data in the output buffer unless
+    //the whole file has been read, so this is only zero at the end.
+    return (m_outBuffer.size() - m_outPosition) + QIODevice::bytesAvailable();
+}
+
+
+qint64 GzipFile::readData(char * data, qint64 maxSize)
+{
+    if (m_format == PLAIN_FILE)
+        return m_file.read(data, maxSize);
+
+    qint64 copied = 0;
+    while (copied < maxSize && m_outPosition < m_outBuffer.size())
+    {
+        qint64 count = qMin(maxSize - copied, qint64(m_outBuffer.size() - m_outPosition));
+        memcpy(data + copied, m_outBuffer.constData() + m_outPosition, count);
+        copied += count;
+        m_outPosition += count;
+
+        if (m_outPosition >= m_outBuffer.size())
+            fillOutputBuffer();
+    }
+
+    if (copied == 0 && m_error)
+        return -1;
+    return copied;
+}
+
+
+qint64 GzipFile::writeData(const char * /*data*/, qint64 /*maxSize*/)
+{
+    return -1;
+}
+
+
+//This function replaces the output buffer with the next piece of
+//decompressed data.  It only leaves the buffer empty when there is nothing
+//more to read.
+void GzipFile::fillOutputBuffer()
+{
+    m_outBuffer.clear();
+    m_outPosition = 0;
+
+    while (m_outBuffer.isEmpty() && !m_finished)
+    {
+        if (m_format == GZIP_FILE)
+        {
+            if (!inflateGzipChunk())
+                m_finished = true;
+        }
+        else if (m_format == BGZF_FILE)
+        {
+            queueBgzfBlocks();
+            if (m_pendingBlocks.isEmpty())
+            {
+                m_finished = true;
+                break;
+            }
+
+            BgzfBlock block = m_pendingBlocks.takeFirst().result();
+            if (!block.ok)
+            {
+                m_error = true;
+                m_finished = true;
+                setErrorString("Corrupt BGZF block");
+                break;
+            }
+            m_outBuffer = block.data;
+
+            //Keep the thread pool busy while the caller parses this block.
+            queueBgzfBlocks();
+        }
+        else
+            m_finished = true;
+    }
+}
+
+
+//This function inflates the next chunk of a plain gzip file into the output
+//buffer.  It returns false when the file is exhausted or an error occurs.
+//Gzip files made of several concatenated members are read as one stream.
+bool GzipFile::inflateGzipChunk()
+{
+    if (m_stream.avail_in == 0)
+    {
+        m_inBuffer = m_file.read(GZIP_CHUNK_SIZE);
+        if (m_inBuffer.isEmpty())
+        {
+            //A file that ends part way through a member is truncated.
+            if (!m_memberComplete)
+            {
+                m_error = true;
+                setErrorString("Unexpected end of gzip file");
+            }
+            return false;
+        }
+        m_stream.next_in = reinterpret_cast<Bytef *>(m_inBuffer.data());
+        m_stream.avail_in = m_inBuffer.size();
+    }
+
+    m_outBuffer.resize(GZIP_CHUNK_SIZE * 4);
+    m_stream.next_out = reinterpret_cast<Bytef *>(m_outBuffer.data());
+    m_stream.avail_out = m_outBuffer.size();
+
+    int result = inflate(&m_stream, Z_NO_FLUSH);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+    {
+        m_outBuffer.clear();
+        m_error = true;
+        setErrorString("Corrupt gzip data");
+        return false;
+    }
+    m_outBuffer.resize(m_outBuffer.size() - m_stream.avail_out);
+
+    m_memberComplete = (result == Z_STREAM_END);
+    if (m_memberComplete)
+        inflateReset(&m_stream);
+
+    return true;
+}
+
+
+//This function reads compressed BGZF blocks from the file and hands them to
+//the thread pool, until the maximum number of blocks are in flight.
+bool GzipFile::queueBgzfBlocks()
+{
+    bool queuedAny = false;
+    while (m_pendingBlocks.size() < m_maxPendingBlocks)
+    {
+        QByteArray block;
+        if (!readBgzfBlock(&block))
+            break;
+        m_pendingBlocks.push_back(QtConcurrent::run(inflateBgzfBlock, block));
+        queuedAny = true;
+    }
+    return queuedAny;
+}
+
+
+//This function reads one whole BGZF block (still compressed).  The block
+//size is stored in the 'BC' subfield of the gzip header's extra field.
+bool GzipFile::readBgzfBlock(QByteArray * block)
+{
+    if (m_error)
+        return false;
+
+    QByteArray header = m_file.read(12);
+    if (header.isEmpty())
+        return false;
+
+    const unsigned char * h = reinterpret_cast<const unsigned char *>(header.constData());
+    if (header.size() < 12 || h[0] != 0x1f || h[1] != 0x8b || !(h[3] & 4))
+    {
+        m_error = true;
+        setErrorString("Invalid BGZF block header");
+        return false;
+    }
+
+    int extraLength = h[10] | (h[11] << 8);
+    QByteArray extra = m_file.read(extraLength);
+    if (extra.size() < extraLength)
+    {
+        m_error = true;
+        setErrorString("Unexpected end of BGZF file");
+        return false;
+    }
+
+    int blockSize = -1;
+    const unsigned char * e = reinterpret_cast<const unsigned char *>(extra.constData());
+    for (int i = 0; i + 4 <= extraLength; )
+    {
+        int subfieldLength = e[i + 2] | (e[i + 3] << 8);
+        if (e[i] == 'B' && e[i + 1] == 'C' && subfieldLength == 2 && i + 6 <= extraLength)
+        {
+            blockSize = (e[i + 4] | (e[i + 5] << 8)) + 1;
+            break;
+        }
+        i += 4 + subfieldLength;
+    }
+
+    int remainingLength = blockSize - 12 - extraLength;
+    if (blockSize < 0 || remainingLength < 8)
+    {
+        m_error = true;
+        setErrorString("Invalid BGZF block header");
+        return false;
+    }
+
+    QByteArray remainder = m_file.read(remainingLength);
+    if (remainder.size() < remainingLength)
+    {
+        m_error = true;
+        setErrorString("Unexpected end of BGZF file");
+        return false;
+    }
+
+    *block = header + extra + remainder;
+
+    //The output buffer is sized from the block's own ISIZE field, so a
+    //corrupt block mustn't be allowed to ask for more than BGZF ever uses.
+    if (getUncompressedSize(*block) > BGZF_MAX_BLOCK_SIZE)
+    {
+        m_error = true;
+        setErrorString("Invalid BGZF block size");
+        return false;
+    }
+    return true;
+}
+
+
+GzipFileFormat GzipFile::getFileFormat(QString fullFileName)
+{
+    QFile file(fullFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return PLAIN_FILE;
+    return getFormatFromHeader(file.read(18));
+}
+
+
+//Gzip files start with the bytes 1f 8b.  BGZF files are gzip files whose
+//header has an extra field (flag 4) starting with the 'BC' subfield.
+GzipFileFormat GzipFile::getFormatFromHeader(const QByteArray & header)
+{
+    const unsigned char * h = reinterpret_cast<const unsigned char *>(header.constData());
+    if (header.size() < 10 || h[0] != 0x1f || h[1] != 0x8b)
+        return PLAIN_FILE;
+    if (header.size() >= 18 && (h[3] & 4) && h[12] == 'B' && h[13] == 'C')
+        return BGZF_FILE;
+    return GZIP_FILE;
+}
@@ -0,0 +1,88 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GZIPFILE_H
+#define GZIPFILE_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+#include <QFuture>
+#include <zlib.h>
+
+//GzipFile is a read-only device that can be used in place of a QFile when
+//reading input files.  Plain files are read as they are, gzip files are
+//decompressed on the fly and BGZF files (blocked gzip, as made by bgzip)
+//have their blocks decompressed in parallel on the global thread pool.
+//Decompressed data is handed out in file order as soon as each block is
+//ready, so parsing can begin before the whole file is decompressed.
+
+enum GzipFileFormat {PLAIN_FILE, GZIP_FILE, BGZF_FILE};
+
+struct BgzfBlock
+{
+    QByteArray data;
+    bool ok;
+};
+
+class GzipFile : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit GzipFile(QString fullFileName);
+    ~GzipFile();
+
+    bool open(OpenMode mode);
+    void close();
+    bool isSequential() const {return true;}
+    qint64 bytesAvailable() const;
+
+    GzipFileFormat getFormat() const {return m_format;}
+    bool hasError() const {return m_error;}
+
+    static GzipFileFormat getFileFormat(QString fullFileName);
+    static bool isCompressed(QString fullFileName) {return getFileFormat(fullFileName) != PLAIN_FILE;}
+    static GzipFileFormat getFormatFromHeader(const QByteArray & header);
+
+protected:
+    qint64 readData(char * data, qint64 maxSize);
+    qint64 writeData(const char * data, qint64 maxSize);
+
+private:
+    QFile m_file;
+    GzipFileFormat m_format;
+    z_stream m_stream;
+    bool m_streamInitialised;
+    QByteArray m_inBuffer;
+    QByteArray m_outBuffer;
+    int m_outPosition;
+    bool m_finished;
+    bool m_error;
+    bool m_memberComplete;
+    QList<QFuture<BgzfBlock> > m_pendingBlocks;
+    int m_maxPendingBlocks;
+
+    void fillOutputBuffer();
+    bool inflateGzipChunk();
+    bool queueBgzfBlocks();
+    bool readBgzfBlock(QByteArray * block);
+};
+
+#endif // GZIPFILE_H
@@ -0,0 +1,326 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "incrementallayout.h"
+#include <math.h>
+#include <deque>
+#include <algorithm>
+
+static const double TWO_PI = 6.283185307179586;
+
+IncrementalLayout::IncrementalLayout(ogdf::GraphAttributes * graphAttributes,
+                                     const ogdf::NodeArray<bool> * fixedNodes,
+                                     const ogdf::EdgeArray<double> * edgeLengths,
+                                     double edgeLength, unsigned int seed) :
+    m_graphAttributes(graphAttributes), m_graph(&graphAttributes->constGraph()),
+    m_fixedNodes(fixedNodes), m_edgeLengths(edgeLengths), m_edgeLength(edgeLength),
+    m_randomState(seed)
+{
+    ogdf::node v;
+    forall_nodes(v, *m_graph)
+    {
+        if (!(*m_fixedNodes)[v])
+            m_freeNodes.push_back(v);
+    }
+}
+
+
+//This function gives each free node a starting position.  Free nodes next
+//to fixed nodes are placed first, then their free neighbours and so on
+//outwards, so new parts of the graph grow out of the existing layout.
+//Components with no fixed nodes at all are started off to the right of the
+//existing layout.
+void IncrementalLayout::placeFreeNodes()
+{
+    ogdf::NodeArray<bool> placed(*m_graph);
+    ogdf::node v;
+    forall_nodes(v, *m_graph)
+        placed[v] = (*m_fixedNodes)[v];
+
+    std::deque<ogdf::node> queue;
+    ogdf::adjEntry adj;
+    for (size_t i = 0; i < m_freeNodes.size(); ++i)
+    {
+        ogdf::node freeNode = m_freeNodes[i];
+        forall_adj(adj, freeNode)
+        {
+            ogdf::node neighbour = adj->twinNode();
+            if ((*m_fixedNodes)[neighbour])
+            {
+                placeNextTo(freeNode, neighbour, getEdgeLength(adj->theEdge()), placed);
+                placed[freeNode] = true;
+                queue.push_back(freeNode);
+                break;
+            }
+        }
+    }
+
+    bool haveNewComponentPosition = false;
+    double newComponentX = 0.0;
+    double newComponentY = 0.0;
+    size_t nextFreeNode = 0;
+    while (true)
+    {
+        int placedCount = 0;
+        while (!queue.empty())
+        {
+            ogdf::node node = queue.front();
+            queue.pop_front();
+            forall_adj(adj, node)
+            {
+                ogdf::node neighbour = adj->twinNode();
+                if (!placed[neighbour])
+                {
+                    placeNextTo(neighbour, node, getEdgeLength(adj->theEdge()), placed);
+                    placed[neighbour] = true;
+                    queue.push_back(neighbour);
+                    ++placedCount;
+                }
+            }
+        }
+
+        //The previous new component (if there was one) gets room below it,
+        //roughly in proportion to its size.
+        newComponentY += sqrt(double(placedCount)) * m_edgeLength * 2.0;
+
+        while (nextFreeNode < m_freeNodes.size() && placed[m_freeNodes[nextFreeNode]])
+            ++nextFreeNode;
+        if (nextFreeNode == m_freeNodes.size())
+            break;
+
+        if (!haveNewComponentPosition)
+        {
+            double maxX = 0.0;
+            double minY = 0.0;
+            bool first = true;
+            forall_nodes(v, *m_graph)
+            {
+                if (!placed[v])
+                    continue;
+                if (first || m_graphAttributes->x(v) > maxX)
+                    maxX = m_graphAttributes->x(v);
+                if (first || m_graphAttributes->y(v) < minY)
+                    minY = m_graphAttributes->y(v);
+                first = false;
+            }
+            newComponentX = maxX + m_edgeLength * 5.0;
+            newComponentY = minY;
+            haveNewComponentPosition = true;
+        }
+
+        ogdf::node seedNode = m_freeNodes[nextFreeNode];
+        m_graphAttributes->x(seedNode) = newComponentX;
+        m_graphAttributes->y(seedNode) = newComponentY;
+        placed[seedNode] = true;
+        queue.push_back(seedNode);
+    }
+
+    buildFixedGrid();
+}
+
+
+//This function puts a node the given distance away from a placed
+//neighbour, heading away from that neighbour's other placed neighbours so
+//new branches point outwards instead of back into the layout.
+void IncrementalLayout::placeNextTo(ogdf::node node, ogdf::node placedNeighbour, double distance,
+                                    const ogdf::NodeArray<bool> & placed)
+{
+    double neighbourX = m_graphAttributes->x(placedNeighbour);
+    double neighbourY = m_graphAttributes->y(placedNeighbour);
+
+    double awayX = 0.0;
+    double awayY = 0.0;
+    ogdf::adjEntry adj;
+    forall_adj(adj, placedNeighbour)
+    {
+        ogdf::node other = adj->twinNode();
+        if (other != node && placed[other])
+        {
+            awayX += neighbourX - m_graphAttributes->x(other);
+            awayY += neighbourY - m_graphAttributes->y(other);
+        }
+    }
+
+    double angle;
+    if (awayX * awayX + awayY * awayY < 1e-12)
+        angle = getRandomFraction() * TWO_PI;
+    else
+        angle = atan2(awayY, awayX);
+
+    //A little jitter stops siblings from landing on top of each other.
+    angle += getRandomFraction() - 0.5;
+
+    m_graphAttributes->x(node) = neighbourX + cos(angle) * distance;
+    m_graphAttributes->y(node) = neighbourY + sin(angle) * distance;
+}
+
+
+//Fixed nodes never move, so they are put in a grid once.  Only those near
+//the free nodes are needed.
+void IncrementalLayout::buildFixedGrid()
+{
+    m_fixedGrid.clear();
+    if (m_freeNodes.empty())
+        return;
+
+    double margin = m_edgeLength * 5.0;
+    double minX = m_graphAttributes->x(m_freeNodes[0]);
+    double maxX = minX;
+    double minY = m_graphAttributes->y(m_freeNodes[0]);
+    double maxY = minY;
+    for (size_t i = 1; i < m_freeNodes.size(); ++i)
+    {
+        minX = std::min(minX, m_graphAttributes->x(m_freeNodes[i]));
+        maxX = std::max(maxX, m_graphAttributes->x(m_freeNodes[i]));
+        minY = std::min(minY, m_graphAttributes->y(m_freeNodes[i]));
+        maxY = std::max(maxY, m_graphAttributes->y(m_freeNodes[i]));
+    }
+    minX -= margin;
+    maxX += margin;
+    minY -= margin;
+    maxY += margin;
+
+    ogdf::node v;
+    forall_nodes(v, *m_graph)
+    {
+        if (!(*m_fixedNodes)[v])
+            continue;
+        double x = m_graphAttributes->x(v);
+        double y = m_graphAttributes->y(v);
+        if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+            m_fixedGrid[getGridCell(x, y)].push_back(v);
+    }
+}
+
+
+//This function moves each free node once, using spring forces along its
+//edges and repulsion from nearby nodes.  No node moves further than
+//maxMove.
+void IncrementalLayout::iterate(double maxMove)
+{
+    //Free nodes move, so they are put in a new grid each iteration.
+    QHash<QPair<int, int>, std::vector<ogdf::node> > freeGrid;
+    for (size_t i = 0; i < m_freeNodes.size(); ++i)
+    {
+        ogdf::node v = m_freeNodes[i];
+        freeGrid[getGridCell(m_graphAttributes->x(v), m_graphAttributes->y(v))].push_back(v);
+    }
+
+    std::vector<double> moveX(m_freeNodes.size(), 0.0);
+    std::vector<double> moveY(m_freeNodes.size(), 0.0);
+    for (size_t i = 0; i < m_freeNodes.size(); ++i)
+    {
+        ogdf::node v = m_freeNodes[i];
+        double x = m_graphAttributes->x(v);
+        double y = m_graphAttributes->y(v);
+        QPair<int, int> cell = getGridCell(x, y);
+
+        double dx = 0.0;
+        double dy = 0.0;
+        for (int cellX = cell.first - 1; cellX <= cell.first + 1; ++cellX)
+        {
+            for (int cellY = cell.second - 1; cellY <= cell.second + 1; ++cellY)
+            {
+                QPair<int, int> neighbourCell(cellX, cellY);
+                QHash<QPair<int, int>, std::vector<ogdf::node> >::const_iterator fixedCell = m_fixedGrid.constFind(neighbourCell);
+                if (fixedCell != m_fixedGrid.constEnd())
+                {
+                    for (size_t j = 0; j < fixedCell->size(); ++j)
+                        addRepulsion(v, (*fixedCell)[j], &dx, &dy);
+                }
+                QHash<QPair<int, int>, std::vector<ogdf::node> >::const_iterator freeCell = freeGrid.constFind(neighbourCell);
+                if (freeCell != freeGrid.constEnd())
+                {
+                    for (size_t j = 0; j < freeCell->size(); ++j)
+                    {
+                        if ((*freeCell)[j] != v)
+                            addRepulsion(v, (*freeCell)[j], &dx, &dy);
+                    }
+                }
+            }
+        }
+
+        ogdf::adjEntry adj;
+        forall_adj(adj, v)
+        {
+            ogdf::node other = adj->twinNode();
+            double edgeX = m_graphAttributes->x(other) - x;
+            double edgeY = m_graphAttributes->y(other) - y;
+            double distance = sqrt(edgeX * edgeX + edgeY * edgeY);
+            double edgeLength = getEdgeLength(adj->theEdge());
+            dx += edgeX * distance / edgeLength;
+            dy += edgeY * distance / edgeLength;
+        }
+
+        moveX[i] = dx;
+        moveY[i] = dy;
+    }
+
+    for (size_t i = 0; i < m_freeNodes.size(); ++i)
+    {
+        double distance = sqrt(moveX[i] * moveX[i] + moveY[i] * moveY[i]);
+        if (distance > maxMove)
+        {
+            moveX[i] *= maxMove / distance;
+            moveY[i] *= maxMove / distance;
+        }
+        m_graphAttributes->x(m_freeNodes[i]) += moveX[i];
+        m_graphAttributes->y(m_freeNodes[i]) += moveY[i];
+    }
+}
+
+
+//Nodes repel each other more strongly the closer they are, but only
+//within two edge lengths.
+void IncrementalLayout::addRepulsion(ogdf::node node, ogdf::node other, double * dx, double * dy) const
+{
+    double awayX = m_graphAttributes->x(node) - m_graphAttributes->x(other);
+    double awayY = m_graphAttributes->y(node) - m_graphAttributes->y(other);
+    double distanceSquared = awayX * awayX + awayY * awayY;
+
+    double range = m_edgeLength * 2.0;
+    if (distanceSquared > range * range)
+        return;
+
+    //Nodes in the same place are pushed apart in an arbitrary direction.
+    if (distanceSquared < 1e-6)
+    {
+        awayX = 0.01 * m_edgeLength;
+        awayY = 0.0;
+        distanceSquared = awayX * awayX;
+    }
+
+    *dx += awayX * m_edgeLength * m_edgeLength / distanceSquared;
+    *dy += awayY * m_edgeLength * m_edgeLength / distanceSquared;
+}
+
+
+QPair<int, int> IncrementalLayout::getGridCell(double x, double y) const
+{
+    double cellSize = m_edgeLength * 2.0;
+    return QPair<int, int>(int(floor(x / cellSize)), int(floor(y / cellSize)));
+}
+
+
+//A small linear congruential generator, so layouts don't depend on (or
+//disturb) the state of rand().
+double IncrementalLayout::getRandomFraction()
+{
+    m_randomState = m_randomState * 1103515245u + 12345u;
+    return ((m_randomState >> 16) & 0x7fff) / 32768.0;
+}
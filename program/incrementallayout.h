@@ -0,0 +1,66 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef INCREMENTALLAYOUT_H
+#define INCREMENTALLAYOUT_H
+
+#include <vector>
+#include <QHash>
+#include <QPair>
+#include <ogdf/basic/Graph.h>
+#include <ogdf/basic/GraphAttributes.h>
+
+//IncrementalLayout places new nodes into an existing layout.  Nodes that
+//are fixed keep their positions.  The free nodes are first placed next to
+//their placed neighbours and then moved with a simple spring embedder in
+//which only they move.  Each iteration only looks at the free nodes and
+//what is near them, so adding a few nodes to a big layout is quick.
+
+class IncrementalLayout
+{
+public:
+    IncrementalLayout(ogdf::GraphAttributes * graphAttributes,
+                      const ogdf::NodeArray<bool> * fixedNodes,
+                      const ogdf::EdgeArray<double> * edgeLengths,
+                      double edgeLength, unsigned int seed);
+
+    int getFreeNodeCount() const {return int(m_freeNodes.size());}
+    void placeFreeNodes();
+    void iterate(double maxMove);
+
+private:
+    ogdf::GraphAttributes * m_graphAttributes;
+    const ogdf::Graph * m_graph;
+    const ogdf::NodeArray<bool> * m_fixedNodes;
+    const ogdf::EdgeArray<double> * m_edgeLengths;
+    double m_edgeLength;
+    unsigned int m_randomState;
+
+    std::vector<ogdf::node> m_freeNodes;
+    QHash<QPair<int, int>, std::vector<ogdf::node> > m_fixedGrid;
+
+    double getRandomFraction();
+    QPair<int, int> getGridCell(double x, double y) const;
+    double getEdgeLength(ogdf::edge edge) const {return m_edgeLength * (*m_edgeLengths)[edge];}
+    void placeNextTo(ogdf::node node, ogdf::node placedNeighbour, double distance,
+                     const ogdf::NodeArray<bool> & placed);
+    void buildFixedGrid();
+    void addRepulsion(ogdf::node node, ogdf::node other, double * dx, double * dy) const;
+};
+
+#endif // INCREMENTALLAYOUT_H
@@ -0,0 +1,127 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "layoutcache.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+
+//Files start with these so old or foreign files are never read as layouts.
+static const quint32 LAYOUT_CACHE_MAGIC = 0x42444c43;
+static const qint32 LAYOUT_CACHE_VERSION = 1;
+
+//Only this many layouts are kept.  When there are more, the oldest ones
+//are removed.
+static const int MAX_CACHED_LAYOUTS = 50;
+
+
+//This function gives the positions stored for the given key.  It returns
+//false if there are none.
+bool LayoutCache::loadLayout(QString key, std::vector<double> * positions)
+{
+    QString fileName = getLayoutFileName(key);
+    if (fileName == "")
+        return false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic;
+    qint32 version;
+    QString storedKey;
+    qint32 positionCount;
+    in >> magic >> version;
+    if (magic != LAYOUT_CACHE_MAGIC || version != LAYOUT_CACHE_VERSION)
+        return false;
+    in >> storedKey >> positionCount;
+    if (storedKey != key || positionCount < 0)
+        return false;
+
+    positions->resize(positionCount);
+    for (qint32 i = 0; i < positionCount; ++i)
+        in >> (*positions)[i];
+    if (in.status() != QDataStream::Ok)
+    {
+        positions->clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+void LayoutCache::saveLayout(QString key, const std::vector<double> & positions)
+{
+    QString fileName = getLayoutFileName(key);
+    if (fileName == "")
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out << LAYOUT_CACHE_MAGIC << LAYOUT_CACHE_VERSION << key << qint32(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+        out << positions[i];
+    file.close();
+
+    if (out.status() != QDataStream::Ok)
+    {
+        QFile::remove(fileName);
+        return;
+    }
+
+    removeOldLayouts(QFileInfo(fileName).absolutePath());
+}
+
+
+//This function returns the directory for cached layouts, making it if
+//necessary, or an empty string if there is nowhere to put them.
+QString LayoutCache::getCacheDirectory()
+{
+    QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation == "")
+        return "";
+
+    QString directory = cacheLocation + "/layouts";
+    if (!QDir().mkpath(directory))
+        return "";
+    return directory;
+}
+
+
+QString LayoutCache::getLayoutFileName(QString key)
+{
+    QString directory = getCacheDirectory();
+    if (directory == "")
+        return "";
+    return directory + "/" + key + ".layout";
+}
+
+
+void LayoutCache::removeOldLayouts(QString directory)
+{
+    QFileInfoList layoutFiles = QDir(directory).entryInfoList(QStringList("*.layout"), QDir::Files, QDir::Time);
+    for (int i = MAX_CACHED_LAYOUTS; i < layoutFiles.size(); ++i)
+        QFile::remove(layoutFiles[i].absoluteFilePath());
+}
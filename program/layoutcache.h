@@ -0,0 +1,42 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef LAYOUTCACHE_H
+#define LAYOUTCACHE_H
+
+#include <QString>
+#include <vector>
+
+//LayoutCache stores finished graph layouts on disk, so drawing a graph that
+//was laid out before (in this session or an earlier one) is instant.  Each
+//layout is a list of OGDF node coordinates, stored in a file named after a
+//key that describes the drawn graph and the layout settings.
+
+class LayoutCache
+{
+public:
+    static bool loadLayout(QString key, std::vector<double> * positions);
+    static void saveLayout(QString key, const std::vector<double> & positions);
+
+private:
+    static QString getCacheDirectory();
+    static QString getLayoutFileName(QString key);
+    static void removeOldLayouts(QString directory);
+};
+
+#endif // LAYOUTCACHE_H
@@ -0,0 +1,228 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "layoutcoarsener.h"
+#include <QLineF>
+
+//Chains shorter than this are left as they are, as replacing them saves
+//too little to be worth the loss of detail.
+static const size_t MIN_CHAIN_NODES = 3;
+
+
+LayoutCoarsener::LayoutCoarsener(const ogdf::GraphAttributes * graphAttributes,
+                                 const ogdf::EdgeArray<double> * edgeLengths) :
+    m_coarseGraphAttributes(0), m_coarseEdgeLengths(0),
+    m_graph(&graphAttributes->constGraph()), m_coarseNodes(*m_graph, 0)
+{
+    findChains(*edgeLengths);
+    buildCoarseGraph(*graphAttributes, *edgeLengths);
+}
+
+LayoutCoarsener::~LayoutCoarsener()
+{
+    delete m_coarseEdgeLengths;
+    delete m_coarseGraphAttributes;
+}
+
+
+//A node is in the middle of a chain if it has exactly two edges, neither
+//of which loops back to itself.
+bool LayoutCoarsener::isChainNode(ogdf::node v) const
+{
+    if (v->degree() != 2)
+        return false;
+    ogdf::adjEntry adj;
+    forall_adj(adj, v)
+    {
+        if (adj->twinNode() == v)
+            return false;
+    }
+    return true;
+}
+
+
+//This function walks out from each node that isn't in the middle of a
+//chain, along each of its edges, collecting the chain nodes it passes.
+//Chains that form a closed loop with no other node are never reached, so
+//they are left as they are.
+void LayoutCoarsener::findChains(const ogdf::EdgeArray<double> & edgeLengths)
+{
+    ogdf::NodeArray<bool> inChain(*m_graph, false);
+
+    ogdf::node v;
+    forall_nodes(v, *m_graph)
+    {
+        if (isChainNode(v))
+            continue;
+
+        ogdf::adjEntry startAdj;
+        forall_adj(startAdj, v)
+        {
+            ogdf::node next = startAdj->twinNode();
+            if (!isChainNode(next) || inChain[next])
+                continue;
+
+            Chain chain;
+            chain.start = v;
+            chain.coarseNode = 0;
+            ogdf::edge previousEdge = startAdj->theEdge();
+            chain.edgeLengths.push_back(edgeLengths[previousEdge]);
+            while (isChainNode(next))
+            {
+                chain.nodes.push_back(next);
+                inChain[next] = true;
+
+                ogdf::adjEntry adj;
+                forall_adj(adj, next)
+                {
+                    if (adj->theEdge() != previousEdge)
+                        break;
+                }
+                previousEdge = adj->theEdge();
+                chain.edgeLengths.push_back(edgeLengths[previousEdge]);
+                next = adj->twinNode();
+            }
+            chain.end = next;
+
+            if (chain.nodes.size() >= MIN_CHAIN_NODES)
+                m_chains.push_back(chain);
+        }
+    }
+}
+
+
+//This function makes the coarse graph.  Nodes that aren't in a chain are
+//copied over with their edges.  Each chain becomes one node joined to the
+//chain's start and end, and half of the chain's length goes to each of
+//those two edges.
+void LayoutCoarsener::buildCoarseGraph(const ogdf::GraphAttributes & graphAttributes,
+                                       const ogdf::EdgeArray<double> & edgeLengths)
+{
+    ogdf::NodeArray<bool> inChain(*m_graph, false);
+    for (size_t i = 0; i < m_chains.size(); ++i)
+    {
+        for (size_t j = 0; j < m_chains[i].nodes.size(); ++j)
+            inChain[m_chains[i].nodes[j]] = true;
+    }
+
+    ogdf::node v;
+    forall_nodes(v, *m_graph)
+    {
+        if (!inChain[v])
+            m_coarseNodes[v] = m_coarseGraph.newNode();
+    }
+    for (size_t i = 0; i < m_chains.size(); ++i)
+        m_chains[i].coarseNode = m_coarseGraph.newNode();
+
+    m_coarseGraphAttributes = new ogdf::GraphAttributes(m_coarseGraph,
+                                                        ogdf::GraphAttributes::nodeGraphics |
+                                                        ogdf::GraphAttributes::edgeGraphics);
+    m_coarseEdgeLengths = new ogdf::EdgeArray<double>(m_coarseGraph, 1.0);
+
+    forall_nodes(v, *m_graph)
+    {
+        ogdf::node coarseNode = m_coarseNodes[v];
+        if (coarseNode == 0)
+            continue;
+        m_coarseGraphAttributes->width(coarseNode) = graphAttributes.width(v);
+        m_coarseGraphAttributes->height(coarseNode) = graphAttributes.height(v);
+    }
+
+    ogdf::edge e;
+    forall_edges(e, *m_graph)
+    {
+        ogdf::node source = m_coarseNodes[e->source()];
+        ogdf::node target = m_coarseNodes[e->target()];
+        if (source != 0 && target != 0)
+        {
+            ogdf::edge coarseEdge = m_coarseGraph.newEdge(source, target);
+            (*m_coarseEdgeLengths)[coarseEdge] = edgeLengths[e];
+        }
+    }
+
+    for (size_t i = 0; i < m_chains.size(); ++i)
+    {
+        const Chain & chain = m_chains[i];
+        double chainLength = 0.0;
+        for (size_t j = 0; j < chain.edgeLengths.size(); ++j)
+            chainLength += chain.edgeLengths[j];
+
+        ogdf::node firstChainNode = chain.nodes.front();
+        m_coarseGraphAttributes->width(chain.coarseNode) = graphAttributes.width(firstChainNode);
+        m_coarseGraphAttributes->height(chain.coarseNode) = graphAttributes.height(firstChainNode);
+
+        ogdf::edge startEdge = m_coarseGraph.newEdge(m_coarseNodes[chain.start], chain.coarseNode);
+        ogdf::edge endEdge = m_coarseGraph.newEdge(chain.coarseNode, m_coarseNodes[chain.end]);
+        (*m_coarseEdgeLengths)[startEdge] = chainLength / 2.0;
+        (*m_coarseEdgeLengths)[endEdge] = chainLength / 2.0;
+    }
+}
+
+
+//This function copies the coarse layout back to the full graph.  Nodes
+//that weren't in a chain take their coarse node's position.  Chain nodes
+//are spread along the path from the chain's start, through its coarse
+//node, to its end, spaced in proportion to their edge lengths.
+void LayoutCoarsener::expand(ogdf::GraphAttributes * graphAttributes) const
+{
+    ogdf::node v;
+    forall_nodes(v, *m_graph)
+    {
+        ogdf::node coarseNode = m_coarseNodes[v];
+        if (coarseNode == 0)
+            continue;
+        graphAttributes->x(v) = m_coarseGraphAttributes->x(coarseNode);
+        graphAttributes->y(v) = m_coarseGraphAttributes->y(coarseNode);
+    }
+
+    for (size_t i = 0; i < m_chains.size(); ++i)
+    {
+        const Chain & chain = m_chains[i];
+        QPointF start(m_coarseGraphAttributes->x(m_coarseNodes[chain.start]),
+                      m_coarseGraphAttributes->y(m_coarseNodes[chain.start]));
+        QPointF middle(m_coarseGraphAttributes->x(chain.coarseNode),
+                       m_coarseGraphAttributes->y(chain.coarseNode));
+        QPointF end(m_coarseGraphAttributes->x(m_coarseNodes[chain.end]),
+                    m_coarseGraphAttributes->y(m_coarseNodes[chain.end]));
+        double firstHalf = QLineF(start, middle).length();
+        double secondHalf = QLineF(middle, end).length();
+        double pathLength = firstHalf + secondHalf;
+
+        double chainLength = 0.0;
+        for (size_t j = 0; j < chain.edgeLengths.size(); ++j)
+            chainLength += chain.edgeLengths[j];
+
+        double distanceAlongChain = 0.0;
+        for (size_t j = 0; j < chain.nodes.size(); ++j)
+        {
+            distanceAlongChain += chain.edgeLengths[j];
+            double distanceAlongPath = pathLength * distanceAlongChain / chainLength;
+
+            QPointF position;
+            if (distanceAlongPath <= firstHalf && firstHalf > 0.0)
+                position = start + (middle - start) * (distanceAlongPath / firstHalf);
+            else if (secondHalf > 0.0)
+                position = middle + (end - middle) * ((distanceAlongPath - firstHalf) / secondHalf);
+            else
+                position = middle;
+
+            graphAttributes->x(chain.nodes[j]) = position.x();
+            graphAttributes->y(chain.nodes[j]) = position.y();
+        }
+    }
+}
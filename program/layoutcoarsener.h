@@ -0,0 +1,71 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef LAYOUTCOARSENER_H
+#define LAYOUTCOARSENER_H
+
+#include <vector>
+#include <ogdf/basic/Graph.h>
+#include <ogdf/basic/GraphAttributes.h>
+
+//LayoutCoarsener makes a smaller copy of an OGDF graph for layout, in which
+//each long unbranched chain of OGDF nodes is replaced by a single node.
+//Most of the OGDF graph is made of such chains (every drawn node is one),
+//so the coarse graph can be much quicker to lay out.  After the coarse
+//graph is laid out, the chains are expanded again along the path through
+//their coarse node.  Only the layout is affected - the OGDF graph itself
+//is left as it is.
+
+class LayoutCoarsener
+{
+public:
+    LayoutCoarsener(const ogdf::GraphAttributes * graphAttributes,
+                    const ogdf::EdgeArray<double> * edgeLengths);
+    ~LayoutCoarsener();
+
+    ogdf::Graph m_coarseGraph;
+    ogdf::GraphAttributes * m_coarseGraphAttributes;
+    ogdf::EdgeArray<double> * m_coarseEdgeLengths;
+
+    int getChainCount() const {return int(m_chains.size());}
+    void expand(ogdf::GraphAttributes * graphAttributes) const;
+
+private:
+    //A chain of OGDF nodes with two edges each, running between two other
+    //nodes.  Each edge length is for the edge leading to the node at the
+    //same index, so there is one more edge length than there are nodes.
+    struct Chain
+    {
+        ogdf::node start;
+        ogdf::node end;
+        std::vector<ogdf::node> nodes;
+        std::vector<double> edgeLengths;
+        ogdf::node coarseNode;
+    };
+
+    const ogdf::Graph * m_graph;
+    ogdf::NodeArray<ogdf::node> m_coarseNodes;
+    std::vector<Chain> m_chains;
+
+    bool isChainNode(ogdf::node v) const;
+    void findChains(const ogdf::EdgeArray<double> & edgeLengths);
+    void buildCoarseGraph(const ogdf::GraphAttributes & graphAttributes,
+                          const ogdf::EdgeArray<double> & edgeLengths);
+};
+
+#endif // LAYOUTCOARSENER_H
@@ -29,6 +29,7 @@ Memory::Memory()
 
     pathDialogIsVisible = false;
     queryPathDialogIsVisible = false;
+    fullDetailPainting = false;
 
     userSpecifiedPath = Path();
     userSpecifiedPathString = "";
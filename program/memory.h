@@ -37,6 +37,11 @@ public:
     bool pathDialogIsVisible;
     bool queryPathDialogIsVisible;
 
+    //This is set while an image is saved, so items are painted in full
+    //detail however small they are in the image.  On screen, details too
+    //small to see are left out to save time.
+    bool fullDetailPainting;
+
     //These store the user input in the 'Specify exact path...' dialog so it is
     //retained between uses.
     Path userSpecifiedPath;
@@ -0,0 +1,202 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "pngwriter.h"
+#include <string.h>
+
+static const char PNG_SIGNATURE[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+
+//A zlib header for a 32 kB window and the default compression level.
+static const char ZLIB_HEADER[2] = {'\x78', '\x9c'};
+
+//Each row is stored with the 'Sub' filter, which keeps flat areas of colour
+//(most of a graph image) compressing well without needing the row above.
+static const char PNG_SUB_FILTER = 1;
+
+
+static void appendUInt32(QByteArray * data, quint32 value)
+{
+    data->append(char((value >> 24) & 0xff));
+    data->append(char((value >> 16) & 0xff));
+    data->append(char((value >> 8) & 0xff));
+    data->append(char(value & 0xff));
+}
+
+
+//This function filters and compresses the rows of one band.  It runs on the
+//thread pool.  All bands but the last end with a sync flush, which leaves
+//the compressed data on a byte boundary so the next band can follow it.
+PngBand PngWriter::compressBand(const QImage & image, bool lastBand)
+{
+    PngBand band;
+    band.adler = adler32(0L, Z_NULL, 0);
+    band.length = 0;
+    band.rowCount = image.height();
+    band.ok = false;
+
+    QImage rgbImage = image.convertToFormat(QImage::Format_RGB888);
+    int width = rgbImage.width();
+    int rowLength = 1 + width * 3;
+    QByteArray row(rowLength, '\0');
+    row[0] = PNG_SUB_FILTER;
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return band;
+
+    QByteArray buffer(int(deflateBound(&stream, uLong(rowLength))) + 64, '\0');
+    for (int y = 0; y <= band.rowCount; ++y)
+    {
+        int flush = Z_NO_FLUSH;
+        if (y < band.rowCount)
+        {
+            const unsigned char * pixels = rgbImage.constScanLine(y);
+            unsigned char * filtered = reinterpret_cast<unsigned char *>(row.data()) + 1;
+            for (int i = 0; i < 3 && i < width * 3; ++i)
+                filtered[i] = pixels[i];
+            for (int i = 3; i < width * 3; ++i)
+                filtered[i] = (unsigned char)(pixels[i] - pixels[i - 3]);
+
+            band.adler = adler32(band.adler, reinterpret_cast<const Bytef *>(row.constData()), rowLength);
+            band.length += rowLength;
+            stream.next_in = reinterpret_cast<Bytef *>(row.data());
+            stream.avail_in = rowLength;
+        }
+        else
+            flush = lastBand ? Z_FINISH : Z_SYNC_FLUSH;
+
+        do
+        {
+            stream.next_out = reinterpret_cast<Bytef *>(buffer.data());
+            stream.avail_out = buffer.size();
+            int result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR)
+            {
+                deflateEnd(&stream);
+                return band;
+            }
+            band.data.append(buffer.constData(), buffer.size() - stream.avail_out);
+        }
+        while (stream.avail_out == 0 || stream.avail_in > 0);
+    }
+
+    deflateEnd(&stream);
+    band.ok = true;
+    return band;
+}
+
+
+
+PngWriter::PngWriter(QString fullFileName) :
+    m_file(fullFileName), m_width(0), m_height(0), m_rowsWritten(0), m_adler(adler32(0L, Z_NULL, 0))
+{
+}
+
+
+bool PngWriter::open(int width, int height)
+{
+    if (width < 1 || height < 1)
+        return fail("Invalid image size");
+    if (!m_file.open(QIODevice::WriteOnly))
+        return fail(m_file.errorString());
+
+    m_width = width;
+    m_height = height;
+    m_rowsWritten = 0;
+    m_adler = adler32(0L, Z_NULL, 0);
+
+    if (m_file.write(PNG_SIGNATURE, 8) != 8)
+        return fail(m_file.errorString());
+
+    //8 bits per channel, RGB, no interlacing.
+    QByteArray header;
+    appendUInt32(&header, quint32(width));
+    appendUInt32(&header, quint32(height));
+    header.append(char(8));
+    header.append(char(2));
+    header.append(char(0));
+    header.append(char(0));
+    header.append(char(0));
+    return writeChunk("IHDR", header);
+}
+
+
+//Bands must be written in order, top to bottom.
+bool PngWriter::writeBand(const PngBand & band)
+{
+    if (!m_file.isOpen())
+        return false;
+    if (!band.ok)
+        return fail("Could not compress image data");
+    if (m_rowsWritten + band.rowCount > m_height)
+        return fail("Too many image rows");
+
+    QByteArray data;
+    if (m_rowsWritten == 0)
+        data.append(ZLIB_HEADER, 2);
+    data.append(band.data);
+
+    m_adler = adler32_combine(m_adler, band.adler, z_off_t(band.length));
+    m_rowsWritten += band.rowCount;
+    return writeChunk("IDAT", data);
+}
+
+
+//This function finishes the file, which is only valid once every row has
+//been written.
+bool PngWriter::close()
+{
+    if (!m_file.isOpen())
+        return false;
+    if (m_rowsWritten != m_height)
+        return fail("Missing image rows");
+
+    QByteArray trailer;
+    appendUInt32(&trailer, quint32(m_adler));
+    bool success = writeChunk("IDAT", trailer) && writeChunk("IEND", QByteArray());
+    m_file.close();
+    return success;
+}
+
+
+//A chunk is its data length, its type, its data and a CRC of the type and
+//data.
+bool PngWriter::writeChunk(const char * type, const QByteArray & data)
+{
+    QByteArray chunk;
+    appendUInt32(&chunk, quint32(data.size()));
+    chunk.append(type, 4);
+    chunk.append(data);
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(chunk.constData()) + 4, uInt(chunk.size() - 4));
+    appendUInt32(&chunk, quint32(crc));
+
+    if (m_file.write(chunk) != chunk.size())
+        return fail(m_file.errorString());
+    return true;
+}
+
+
+bool PngWriter::fail(QString error)
+{
+    m_errorString = error;
+    if (m_file.isOpen())
+        m_file.close();
+    return false;
+}
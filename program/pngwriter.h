@@ -0,0 +1,69 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+#include <QImage>
+#include <zlib.h>
+
+//PngWriter saves a PNG file one band of rows at a time, so an image never
+//has to be held in memory all at once and isn't limited to the 32767 pixels
+//a side of a QImage.  Each band is filtered and compressed on its own by
+//compressBand, which only touches the image it is given so it can run on
+//the thread pool.  The compressed bands are then written in order.  They
+//join into one zlib stream, as the checksum of each band is combined with
+//those before it.
+
+struct PngBand
+{
+    QByteArray data;
+    uLong adler;
+    uLong length;
+    int rowCount;
+    bool ok;
+};
+
+class PngWriter
+{
+public:
+    explicit PngWriter(QString fullFileName);
+
+    bool open(int width, int height);
+    bool writeBand(const PngBand & band);
+    bool close();
+    QString errorString() const {return m_errorString;}
+
+    static PngBand compressBand(const QImage & image, bool lastBand);
+
+private:
+    QFile m_file;
+    int m_width;
+    int m_height;
+    int m_rowsWritten;
+    uLong m_adler;
+    QString m_errorString;
+
+    bool writeChunk(const char * type, const QByteArray & data);
+    bool fail(QString error);
+};
+
+#endif // PNGWRITER_H
@@ -29,6 +29,17 @@ Settings::Settings()
     meanSegmentsPerNode = 3;
     segmentLength = 15.0;
     graphLayoutQuality = 2;
+    layoutAlgorithm = FMMM_LAYOUT;
+    componentLayout = false;
+    incrementalLayout = true;
+    capNodeSegments = false;
+    coarsenChains = false;
+
+    //A negative seed means the layout is seeded from the clock.
+    layoutSeed = -1;
+
+    //If a layout file is given, the graph is drawn from it without a layout.
+    layoutFilename = "";
 
     averageNodeWidth = 5.0;
     readDepthEffectOnWidth = 0.5;
@@ -40,6 +51,19 @@ Settings::Settings()
     arrowheadSize = 0.01;
     textOutlineThickness = 0.3;
 
+    //Nodes narrower than this on screen are drawn as simple lines, and
+    //labels shorter than this on screen are not drawn at all.
+    lowDetailNodeWidth = 3.0;
+    minimumLabelHeight = 4.0;
+
+    //Scenes with at least this many nodes are drawn from prerendered tiles
+    //(zero turns tiles off).
+    tiledRenderingNodeCount = 50000;
+
+    //When zoomed out, parallel edges are drawn as one curve and edges
+    //shorter than a pixel are left out.
+    edgeBundling = false;
+
     blastRainbowPartsPerQuery = 100;
 
     graphScope = WHOLE_GRAPH;
@@ -66,6 +90,7 @@ Settings::Settings()
     textOutline = true;
     antialiasing = true;
     positionTextNodeCentre = false;
+    hideOverlappingLabels = true;
 
     nodeDragging = NEARBY_PIECES;
 
@@ -96,6 +121,8 @@ Settings::Settings()
 
     noBlastHitsColour = QColor(220, 220, 220);
 
+    noCsvDataColour = QColor(220, 220, 220);
+
     autoReadDepthValue = true;
     lowReadDepthValue = 5.0;
     lowReadDepthColour = QColor(0, 0, 0);
@@ -41,6 +41,13 @@ public:
     int meanSegmentsPerNode;
     double segmentLength;
     int graphLayoutQuality;
+    LayoutAlgorithm layoutAlgorithm;
+    bool componentLayout;
+    bool incrementalLayout;
+    bool capNodeSegments;
+    bool coarsenChains;
+    int layoutSeed;
+    QString layoutFilename;
 
     double averageNodeWidth;
     double readDepthEffectOnWidth;
@@ -52,6 +59,13 @@ public:
     double arrowheadSize;
     double textOutlineThickness;
 
+    //These are in screen pixels, so they apply at any zoom.
+    double lowDetailNodeWidth;
+    double minimumLabelHeight;
+
+    int tiledRenderingNodeCount;
+    bool edgeBundling;
+
     int blastRainbowPartsPerQuery;
 
     GraphScope graphScope;
@@ -78,6 +92,7 @@ public:
     bool textOutline;
     bool antialiasing;
     bool positionTextNodeCentre;
+    bool hideOverlappingLabels;
 
     NodeDragging nodeDragging;
 
@@ -108,6 +123,10 @@ public:
 
     QColor noBlastHitsColour;
 
+    //The CSV colour scheme uses the read depth gradient colours for numeric
+    //columns and this colour for nodes without CSV data.
+    QColor noCsvDataColour;
+
     bool autoReadDepthValue;
     double lowReadDepthValue;
     QColor lowReadDepthColour;
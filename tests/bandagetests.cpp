@@ -20,6 +20,7 @@
 
 #include "ogdf/basic/Graph.h"
 #include "ogdf/basic/GraphAttributes.h"
+#include "ogdf/basic/simple_graph_alg.h"
 #include "../graph/assemblygraph.h"
 #include "../program/settings.h"
 #include "../blast/blastsearch.h"
@@ -27,8 +28,32 @@
 #include "../program/memory.h"
 #include "../graph/debruijnnode.h"
 #include "../graph/debruijnedge.h"
+#include "../graph/graphicsitemnode.h"
+#include "../graph/ogdfnode.h"
 #include "../program/globals.h"
 #include "../command_line/commoncommandlinefunctions.h"
+#include "../program/gzipfile.h"
+#include "../program/layoutcoarsener.h"
+#include "../program/forcekernel.h"
+#include "../program/graphlayoutworker.h"
+#include "../program/layoutcache.h"
+#include "../ui/tilerenderer.h"
+#include "../ui/mygraphicsscene.h"
+#include "../graph/labelcache.h"
+#include "../ui/sceneindex.h"
+#include "../graph/graphicsitemedge.h"
+#include "../program/pngwriter.h"
+#include "../ui/sceneimageexporter.h"
+#include "../ui/svgwriter.h"
+#include "../ui/edgebundler.h"
+#include <QSvgGenerator>
+#include <QSvgRenderer>
+#include <QPicture>
+#include <QXmlStreamReader>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <deque>
+#include <algorithm>
 
 class BandageTests : public QObject
 {
@@ -38,14 +63,40 @@ private slots:
     void loadFastg();
     void loadLastGraph();
     void loadTrinity();
+    void loadCompressedGraphs();
+    void loadGfaPaths();
+    void loadGfa2();
     void pathFunctionsOnLastGraph();
     void pathFunctionsOnFastg();
     void graphLocationFunctions();
     void loadCsvData();
     void loadCsvDataTrinity();
+    void csvTableColumns();
+    void csvColumnColours();
     void blastSearch();
     void blastSearchFilters();
     void graphScope();
+    void layoutCacheKey();
+    void cappedNodeSegments();
+    void layoutCoarsening();
+    void componentPacking();
+    void seededLayouts();
+    void layoutProgress();
+    void layoutAlgorithmStress();
+    void forceKernel();
+    void layoutFile();
+    void incrementalRedraw();
+    void nodeOutlineCache();
+    void tiledRendering();
+    void labelCache();
+    void sceneIndex();
+    void itemBoundingRects();
+    void bandedImageExport();
+    void svgExport();
+    void edgeBundling();
+    void colouredPartGroups();
+    void blastQueryColourChange();
+    void mergeAdjacentParts();
     void commandLineSettings();
     void sciNotComparisons();
     void graphEdits();
@@ -64,6 +115,11 @@ private:
     DeBruijnEdge * getEdgeFromNodeNames(QString startingNodeName,
                                         QString endingNodeName);
     bool doCircularSequencesMatch(QByteArray s1, QByteArray s2);
+    double getLayoutStress();
+    void addChainsToGraph(ogdf::Graph * graph, ogdf::GraphAttributes * graphAttributes);
+    QImage renderSvg(QString filename, QSize size);
+    QImage renderScene(QGraphicsScene * scene, QSize size);
+    int countDifferentPixels(const QImage & a, const QImage & b, int tolerance);
 };
 
 
@@ -130,6 +186,141 @@ void BandageTests::loadTrinity()
 }
 
 
+//test.fastg.gz is an ordinary gzip file and test.LastGraph.gz is a BGZF file
+//made of several blocks.  Both should load the same as the uncompressed files.
+void BandageTests::loadCompressedGraphs()
+{
+    QCOMPARE(GzipFile::getFileFormat(getTestDirectory() + "test.fastg"), PLAIN_FILE);
+    QCOMPARE(GzipFile::getFileFormat(getTestDirectory() + "test.fastg.gz"), GZIP_FILE);
+    QCOMPARE(GzipFile::getFileFormat(getTestDirectory() + "test.LastGraph.gz"), BGZF_FILE);
+
+    //A gzip header that hasn't been decompressed is binary, not a graph.
+    QCOMPARE(AssemblyGraph::getGraphFileTypeFromFileStart(QByteArray("\x1f\x8b\x08\x00\x00", 5)), UNKNOWN_FILE_TYPE);
+    QCOMPARE(AssemblyGraph::getGraphFileTypeFromFileStart("H\tVN:Z:1.0\nS\t1\tACGT\n"), GFA);
+
+    createGlobals();
+    QCOMPARE(g_assemblyGraph->getGraphFileTypeFromFile(getTestDirectory() + "test.fastg.gz"), FASTG);
+    bool fastgGraphLoaded = g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg.gz");
+    QCOMPARE(fastgGraphLoaded, true);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 88);
+    QCOMPARE(int(g_assemblyGraph->m_deBruijnGraphEdges.size()), 118);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getLength(), 6070);
+
+    createGlobals();
+    QCOMPARE(g_assemblyGraph->getGraphFileTypeFromFile(getTestDirectory() + "test.LastGraph.gz"), LAST_GRAPH);
+    bool lastGraphLoaded = g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.LastGraph.gz");
+    QCOMPARE(lastGraphLoaded, true);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 34);
+    QCOMPARE(int(g_assemblyGraph->m_deBruijnGraphEdges.size()), 32);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes["14-"]->getLength(), 60);
+
+    //A block claiming to hold more than BGZF allows is rejected before any
+    //memory is set aside for it.
+    QFile bgzfFile(getTestDirectory() + "test.LastGraph.gz");
+    QVERIFY(bgzfFile.open(QIODevice::ReadOnly));
+    QByteArray bgzfData = bgzfFile.readAll();
+    bgzfFile.close();
+    int firstBlockSize = (static_cast<unsigned char>(bgzfData[16]) | (static_cast<unsigned char>(bgzfData[17]) << 8)) + 1;
+    bgzfData[firstBlockSize - 2] = char(0xff);
+    bgzfData[firstBlockSize - 1] = char(0xff);
+    QString corruptFilename = getTestDirectory() + "corrupt_temp.gz";
+    QFile corruptFile(corruptFilename);
+    QVERIFY(corruptFile.open(QIODevice::WriteOnly));
+    corruptFile.write(bgzfData);
+    corruptFile.close();
+    GzipFile corruptGzipFile(corruptFilename);
+    QVERIFY(corruptGzipFile.open(QIODevice::ReadOnly));
+    corruptGzipFile.readAll();
+    QVERIFY(corruptGzipFile.hasError());
+    QCOMPARE(corruptGzipFile.errorString(), QString("Invalid BGZF block size"));
+    corruptGzipFile.close();
+    QFile::remove(corruptFilename);
+
+    //The file opened to find its type is the one loaded, even after the old
+    //graph is cleaned up, so it still loads once the file itself is gone.
+    QString copyFilename = getTestDirectory() + "sniffed_temp.fastg.gz";
+    QFile::remove(copyFilename);
+    QVERIFY(QFile::copy(getTestDirectory() + "test.fastg.gz", copyFilename));
+    createGlobals();
+    QCOMPARE(g_assemblyGraph->getGraphFileTypeFromFile(copyFilename), FASTG);
+    g_assemblyGraph->cleanUp();
+    QFile::remove(copyFilename);
+    g_assemblyGraph->buildDeBruijnGraphFromFastg(copyFilename);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 88);
+}
+
+
+void BandageTests::loadGfaPaths()
+{
+    createGlobals();
+    bool gfaLoaded = g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_paths.gfa");
+    QCOMPARE(gfaLoaded, true);
+
+    //The path through a missing node (4) is left out.
+    PathTable * pathTable = &g_assemblyGraph->m_pathTable;
+    QCOMPARE(pathTable->getPathCount(), 2);
+    QCOMPARE(pathTable->findPath("pathB"), -1);
+
+    int pathA = pathTable->findPath("pathA");
+    QCOMPARE(pathA, 0);
+    QCOMPARE(pathTable->getStepCount(pathA), 3);
+    QCOMPARE(pathTable->getStep(pathA, 2), g_assemblyGraph->m_deBruijnGraphNodes["3-"]);
+    QCOMPARE(pathTable->getPath(pathA).getLength(), 30);
+
+    int walk = pathTable->findPath("sample#1#chr1:0-30");
+    QCOMPARE(walk, 1);
+    QCOMPARE(pathTable->getStepCount(walk), 3);
+    QCOMPARE(pathTable->getStep(walk, 0), g_assemblyGraph->m_deBruijnGraphNodes["1+"]);
+    QCOMPARE(pathTable->getStep(walk, 2), g_assemblyGraph->m_deBruijnGraphNodes["3-"]);
+
+    //Deleting a node drops the paths that use it.
+    std::vector<DeBruijnNode *> nodesToDelete;
+    nodesToDelete.push_back(g_assemblyGraph->m_deBruijnGraphNodes["2+"]);
+    g_assemblyGraph->deleteNodes(&nodesToDelete);
+    QCOMPARE(pathTable->getPathCount(), 0);
+}
+
+
+void BandageTests::loadGfa2()
+{
+    createGlobals();
+    bool gfaLoaded = g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_gfa2.gfa");
+    QCOMPARE(gfaLoaded, true);
+
+    //GFA 2 segment lines have a length before the sequence.
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 8);
+    DeBruijnNode * node1Plus = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    QCOMPARE(node1Plus->getSequence(), QByteArray("ACGTACGTAC"));
+    QCOMPARE(node1Plus->getReadDepth(), 10.0);
+
+    //The three dovetail overlaps make edges (each with its reverse
+    //complement), but the internal alignment doesn't.
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), 6);
+    DeBruijnEdge * edge1 = getEdgeFromNodeNames("1+", "2+");
+    DeBruijnEdge * edge2 = getEdgeFromNodeNames("2+", "3-");
+    DeBruijnEdge * edge3 = getEdgeFromNodeNames("4-", "1+");
+    QVERIFY(edge1 != 0);
+    QVERIFY(edge2 != 0);
+    QVERIFY(edge3 != 0);
+    QVERIFY(getEdgeFromNodeNames("3+", "2-") != 0);
+    QVERIFY(getEdgeFromNodeNames("1-", "4+") != 0);
+    QVERIFY(getEdgeFromNodeNames("1+", "3+") == 0);
+    QCOMPARE(edge1->getOverlap(), 3);
+    QCOMPARE(edge2->getOverlap(), 2);
+    QCOMPARE(edge3->getOverlap(), 4);
+
+    //Ordered groups skip over their edges and any unknown segments.
+    PathTable * pathTable = &g_assemblyGraph->m_pathTable;
+    QCOMPARE(pathTable->getPathCount(), 2);
+    int groupA = pathTable->findPath("groupA");
+    QCOMPARE(pathTable->getStepCount(groupA), 3);
+    QCOMPARE(pathTable->getStep(groupA, 0), node1Plus);
+    QCOMPARE(pathTable->getStep(groupA, 2), g_assemblyGraph->m_deBruijnGraphNodes["3-"]);
+    int groupB = pathTable->findPath("groupB");
+    QCOMPARE(pathTable->getStepCount(groupB), 1);
+}
+
+
 //LastGraph files have no overlap in the edges, so these tests look at paths
 //where the connections are simple.
 void BandageTests::pathFunctionsOnLastGraph()
@@ -350,6 +541,117 @@ void BandageTests::loadCsvDataTrinity()
     QCOMPARE(node3940Plus->getCsvLine(0), QString("3940PLUS"));
 }
 
+
+void BandageTests::csvTableColumns()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QString errormsg;
+    QStringList columns;
+    QVERIFY(g_assemblyGraph->loadCSV(getTestDirectory() + "test_columns.csv", &columns, &errormsg));
+    QCOMPARE(columns, QStringList() << "Depth" << "Group");
+    QCOMPARE(errormsg, QString(""));
+
+    const CsvTable & table = g_assemblyGraph->m_csvTable;
+    QCOMPARE(table.getColumnCount(), 2);
+    QCOMPARE(table.getRowCount(), 5);
+    QCOMPARE(table.isColumnNumeric(0), true);
+    QCOMPARE(table.isColumnNumeric(1), false);
+
+    //Each distinct value is stored once, so rows with the same value share
+    //a category.
+    int row1 = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getCsvRow();
+    int row2 = g_assemblyGraph->m_deBruijnGraphNodes["2+"]->getCsvRow();
+    int row3 = g_assemblyGraph->m_deBruijnGraphNodes["3+"]->getCsvRow();
+    int row4 = g_assemblyGraph->m_deBruijnGraphNodes["4+"]->getCsvRow();
+    int row6 = g_assemblyGraph->m_deBruijnGraphNodes["6-"]->getCsvRow();
+    QCOMPARE(table.getCategoryCount(1), 3);
+    QCOMPARE(table.getCategory(row1, 1), table.getCategory(row3, 1));
+    QVERIFY(table.getCategory(row1, 1) != table.getCategory(row2, 1));
+    QCOMPARE(table.getString(row3, 1), QString("alpha"));
+
+    QCOMPARE(table.getValue(row6, 0), 25.5);
+    QCOMPARE(table.hasValue(row4, 0), false);
+    QCOMPARE(table.getString(row4, 0), QString(""));
+    QCOMPARE(table.getCategory(row4, 0), -1);
+    QCOMPARE(table.getValue(row4, 0), 0.0);
+    QCOMPARE(table.isValidCell(row1, 2), false);
+
+    //A single value which isn't a number makes the whole column non-numeric,
+    //but the cells which are numbers can still be read as numbers.
+    CsvTable mixedTable;
+    mixedTable.setColumnNames(QStringList() << "Mixed");
+    mixedTable.addRow(QStringList() << " 1.5 ");
+    mixedTable.addRow(QStringList() << "abc");
+    mixedTable.addRow(QStringList());
+    mixedTable.finishLoading();
+    QCOMPARE(mixedTable.getRowCount(), 3);
+    QCOMPARE(mixedTable.isColumnNumeric(0), false);
+    QCOMPARE(mixedTable.getValue(0, 0), 1.5);
+    QCOMPARE(mixedTable.hasValue(1, 0), false);
+    QCOMPARE(mixedTable.getCategory(2, 0), -1);
+
+    //Values which aren't finite aren't numbers either.
+    CsvTable nanTable;
+    nanTable.setColumnNames(QStringList() << "NaN" << "Inf");
+    nanTable.addRow(QStringList() << "2" << "3");
+    nanTable.addRow(QStringList() << "nan" << "inf");
+    nanTable.finishLoading();
+    QCOMPARE(nanTable.isColumnNumeric(0), false);
+    QCOMPARE(nanTable.isColumnNumeric(1), false);
+    QCOMPARE(nanTable.hasValue(1, 0), false);
+    QCOMPARE(nanTable.hasValue(1, 1), false);
+    QCOMPARE(nanTable.getValue(0, 0), 2.0);
+}
+
+
+void BandageTests::csvColumnColours()
+{
+    createGlobals();
+    g_settings->doubleMode = true;
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    QString errormsg;
+    QStringList columns;
+    QVERIFY(g_assemblyGraph->loadCSV(getTestDirectory() + "test_columns.csv", &columns, &errormsg));
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+
+    GraphicsItemNode * node1Plus = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getGraphicsItemNode();
+    GraphicsItemNode * node2Plus = g_assemblyGraph->m_deBruijnGraphNodes["2+"]->getGraphicsItemNode();
+    GraphicsItemNode * node3Plus = g_assemblyGraph->m_deBruijnGraphNodes["3+"]->getGraphicsItemNode();
+    GraphicsItemNode * node4Plus = g_assemblyGraph->m_deBruijnGraphNodes["4+"]->getGraphicsItemNode();
+    GraphicsItemNode * node6Minus = g_assemblyGraph->m_deBruijnGraphNodes["6-"]->getGraphicsItemNode();
+    GraphicsItemNode * node7Plus = g_assemblyGraph->m_deBruijnGraphNodes["7+"]->getGraphicsItemNode();
+
+    //A numeric column is coloured with a gradient from its lowest value
+    //(10) to its highest (30).  Nodes without a value get the no data colour.
+    g_settings->nodeColourScheme = CSV_COLOURS;
+    g_settings->displayNodeCsvDataCol = 0;
+    g_settings->lowReadDepthColour = QColor(0, 0, 0);
+    g_settings->highReadDepthColour = QColor(255, 0, 0);
+    g_assemblyGraph->resetAllNodeColours();
+    QCOMPARE(g_assemblyGraph->m_csvTable.getColourMinValue(), 10.0);
+    QCOMPARE(g_assemblyGraph->m_csvTable.getColourMaxValue(), 30.0);
+    QCOMPARE(node1Plus->m_colour, QColor(0, 0, 0));
+    QCOMPARE(node2Plus->m_colour, QColor(128, 0, 0));
+    QCOMPARE(node3Plus->m_colour, QColor(255, 0, 0));
+    QCOMPARE(node6Minus->m_colour, QColor(198, 0, 0));
+    QCOMPARE(node4Plus->m_colour, g_settings->noCsvDataColour);
+    QCOMPARE(node7Plus->m_colour, g_settings->noCsvDataColour);
+
+    //Other columns give each distinct value its own colour.
+    g_settings->displayNodeCsvDataCol = 1;
+    g_assemblyGraph->resetAllNodeColours();
+    QCOMPARE(node1Plus->m_colour, node3Plus->m_colour);
+    QCOMPARE(node2Plus->m_colour, node4Plus->m_colour);
+    QVERIFY(node1Plus->m_colour != node2Plus->m_colour);
+    QVERIFY(node1Plus->m_colour != node6Minus->m_colour);
+    QCOMPARE(node7Plus->m_colour, g_settings->noCsvDataColour);
+}
+
 void BandageTests::blastSearch()
 {
     createGlobals();
@@ -597,6 +899,1187 @@ void BandageTests::graphScope()
     deleteBlastTempDirectory();
 }
 
+void BandageTests::layoutCacheKey()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = WHOLE_GRAPH;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+
+    //The key depends only on the drawn graph and the layout settings.
+    QString key = g_assemblyGraph->getLayoutCacheKey();
+    QCOMPARE(g_assemblyGraph->getLayoutCacheKey(), key);
+    g_settings->graphLayoutQuality = 0;
+    QVERIFY(g_assemblyGraph->getLayoutCacheKey() != key);
+
+    std::vector<double> positions;
+    g_assemblyGraph->getOgdfNodePositions(&positions);
+    QCOMPARE(int(positions.size()), g_assemblyGraph->m_ogdfGraph->numberOfNodes() * 2);
+    QCOMPARE(g_assemblyGraph->setOgdfNodePositions(positions), true);
+    positions.pop_back();
+    QCOMPARE(g_assemblyGraph->setOgdfNodePositions(positions), false);
+
+    //A saved layout loads back under its own key, but not under another.
+    QStandardPaths::setTestModeEnabled(true);
+    QString otherKey = key + "_other";
+    LayoutCache::saveLayout(key, positions);
+    std::vector<double> loadedPositions;
+    QCOMPARE(LayoutCache::loadLayout(key, &loadedPositions), true);
+    QVERIFY(loadedPositions == positions);
+    QCOMPARE(LayoutCache::loadLayout(otherKey, &loadedPositions), false);
+
+    //A file stored under one key isn't read as the layout for another.
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/layouts/";
+    QFile::remove(directory + otherKey + ".layout");
+    QVERIFY(QFile::copy(directory + key + ".layout", directory + otherKey + ".layout"));
+    QCOMPARE(LayoutCache::loadLayout(otherKey, &loadedPositions), false);
+    QFile::remove(directory + key + ".layout");
+    QFile::remove(directory + otherKey + ".layout");
+    QStandardPaths::setTestModeEnabled(false);
+}
+
+
+void BandageTests::cappedNodeSegments()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_settings->nodeLengthMode = MANUAL_NODE_LENGTH;
+    g_settings->manualBasePairsPerSegment = 10;
+    DeBruijnNode * node1 = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+
+    //Without the cap, nodes are laid out with every segment they are drawn with.
+    int drawnSegmentCount = node1->getDrawnSegmentCount();
+    QVERIFY(drawnSegmentCount > 10);
+    QCOMPARE(node1->getOgdfSegmentCount(), drawnSegmentCount);
+
+    g_settings->capNodeSegments = true;
+    int ogdfSegmentCount = node1->getOgdfSegmentCount();
+    QVERIFY(ogdfSegmentCount >= 10);
+    QVERIFY(ogdfSegmentCount < drawnSegmentCount);
+
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = WHOLE_GRAPH;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    OgdfNode * ogdfNode = node1->getOgdfNode();
+    if (ogdfNode == 0)
+        ogdfNode = node1->getReverseComplement()->getOgdfNode();
+    QCOMPARE(int(ogdfNode->m_ogdfNodes.size()), ogdfSegmentCount + 1);
+
+    //A smoothed curve keeps its end points and has evenly spaced points.
+    std::vector<QPointF> points;
+    points.push_back(QPointF(0.0, 0.0));
+    points.push_back(QPointF(10.0, 10.0));
+    points.push_back(QPointF(20.0, 0.0));
+    std::vector<QPointF> curve = GraphicsItemNode::makeSmoothCurve(points, 20);
+    QCOMPARE(int(curve.size()), 21);
+    QCOMPARE(curve.front(), points.front());
+    QCOMPARE(curve.back(), points.back());
+    double firstSpacing = QLineF(curve[0], curve[1]).length();
+    for (size_t i = 1; i < curve.size() - 1; ++i)
+        QVERIFY(fabs(QLineF(curve[i], curve[i + 1]).length() - firstSpacing) < firstSpacing * 0.1);
+}
+
+
+void BandageTests::layoutCoarsening()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = WHOLE_GRAPH;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    int nodeCount = g_assemblyGraph->m_ogdfGraph->numberOfNodes();
+
+    //Each long node is a chain, so the coarse graph is much smaller.
+    LayoutCoarsener coarsener(g_assemblyGraph->m_graphAttributes, g_assemblyGraph->m_ogdfEdgeLengths);
+    QVERIFY(coarsener.getChainCount() > 0);
+    QVERIFY(coarsener.m_coarseGraph.numberOfNodes() < nodeCount / 2);
+
+    //Expanding puts every chain node between its chain's ends.
+    ogdf::node v;
+    forall_nodes(v, coarsener.m_coarseGraph)
+    {
+        coarsener.m_coarseGraphAttributes->x(v) = 10.0;
+        coarsener.m_coarseGraphAttributes->y(v) = 20.0;
+    }
+    coarsener.expand(g_assemblyGraph->m_graphAttributes);
+    forall_nodes(v, *g_assemblyGraph->m_ogdfGraph)
+    {
+        QCOMPARE(g_assemblyGraph->m_graphAttributes->x(v), 10.0);
+        QCOMPARE(g_assemblyGraph->m_graphAttributes->y(v), 20.0);
+    }
+
+    //The graph itself is unchanged.
+    QCOMPARE(g_assemblyGraph->m_ogdfGraph->numberOfNodes(), nodeCount);
+}
+
+
+void BandageTests::componentPacking()
+{
+    ogdf::Graph graph;
+    ogdf::GraphAttributes graphAttributes(graph, ogdf::GraphAttributes::nodeGraphics |
+                                          ogdf::GraphAttributes::edgeGraphics);
+    addChainsToGraph(&graph, &graphAttributes);
+    ogdf::EdgeArray<double> edgeLengths(graph, 1.0);
+
+    ogdf::FMMMLayout fmmm;
+    GraphLayoutWorker worker(&fmmm, &graphAttributes, &edgeLengths, 1, 10, true, false, 1, FMMM_LAYOUT);
+    worker.layoutGraph();
+
+    ogdf::NodeArray<int> componentIndices(graph);
+    int componentCount = ogdf::connectedComponents(graph, componentIndices);
+    QCOMPARE(componentCount, 4);
+
+    //The packed components' bounding boxes must not overlap.
+    std::vector<QRectF> boxes(componentCount);
+    ogdf::node v;
+    forall_nodes(v, graph)
+    {
+        QRectF nodeBox(graphAttributes.x(v) - graphAttributes.width(v) / 2.0,
+                       graphAttributes.y(v) - graphAttributes.height(v) / 2.0,
+                       graphAttributes.width(v), graphAttributes.height(v));
+        QRectF & box = boxes[componentIndices[v]];
+        box = box.isNull() ? nodeBox : box.united(nodeBox);
+    }
+    for (int i = 0; i < componentCount; ++i)
+    {
+        for (int j = i + 1; j < componentCount; ++j)
+            QVERIFY(!boxes[i].intersects(boxes[j]));
+    }
+}
+
+
+void BandageTests::seededLayouts()
+{
+    //Two layouts of the same graph with the same seed must put every node in
+    //the same place, whether the components are laid out in parallel or
+    //the graph is laid out whole.
+    for (int componentLayout = 0; componentLayout < 2; ++componentLayout)
+    {
+        std::vector<double> positions[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            ogdf::Graph graph;
+            ogdf::GraphAttributes graphAttributes(graph, ogdf::GraphAttributes::nodeGraphics |
+                                                  ogdf::GraphAttributes::edgeGraphics);
+            addChainsToGraph(&graph, &graphAttributes);
+            ogdf::EdgeArray<double> edgeLengths(graph, 1.0);
+
+            ogdf::FMMMLayout fmmm;
+            GraphLayoutWorker worker(&fmmm, &graphAttributes, &edgeLengths, 1, 10,
+                                     componentLayout == 1, true, 7, FMMM_LAYOUT);
+            worker.layoutGraph();
+
+            ogdf::node v;
+            forall_nodes(v, graph)
+            {
+                positions[i].push_back(graphAttributes.x(v));
+                positions[i].push_back(graphAttributes.y(v));
+            }
+        }
+        QVERIFY(positions[0] == positions[1]);
+    }
+}
+
+
+void BandageTests::layoutProgress()
+{
+    //FMMM layouts are run in steps of ten iterations, with progress after
+    //each step (and a 0 at the start), so only the lowest quality is a
+    //single step.  Qualities 1 to 4 have 12+8, 30+20, 60+40 and 120+80
+    //fixed and fine tuning iterations.
+    int stepCounts[] = {1, 3, 5, 10, 20};
+    for (int quality = 0; quality <= 4; ++quality)
+    {
+        ogdf::Graph graph;
+        ogdf::GraphAttributes graphAttributes(graph, ogdf::GraphAttributes::nodeGraphics |
+                                              ogdf::GraphAttributes::edgeGraphics);
+        addChainsToGraph(&graph, &graphAttributes);
+        ogdf::EdgeArray<double> edgeLengths(graph, 1.0);
+
+        ogdf::FMMMLayout fmmm;
+        GraphLayoutWorker worker(&fmmm, &graphAttributes, &edgeLengths, quality, 10, false, false, 3, FMMM_LAYOUT);
+        QSignalSpy progressSpy(&worker, SIGNAL(setLayoutCompletedCount(int)));
+        worker.layoutGraph();
+        QCOMPARE(progressSpy.size(), stepCounts[quality] + 1);
+        for (int i = 1; i < progressSpy.size(); ++i)
+            QVERIFY(progressSpy[i].at(0).toInt() > progressSpy[i - 1].at(0).toInt());
+        QCOMPARE(progressSpy.last().at(0).toInt(), 1000);
+
+        //A seeded layout comes out the same every time.
+        ogdf::Graph repeatGraph;
+        ogdf::GraphAttributes repeatGraphAttributes(repeatGraph, ogdf::GraphAttributes::nodeGraphics |
+                                                    ogdf::GraphAttributes::edgeGraphics);
+        addChainsToGraph(&repeatGraph, &repeatGraphAttributes);
+        ogdf::EdgeArray<double> repeatEdgeLengths(repeatGraph, 1.0);
+        ogdf::FMMMLayout repeatFmmm;
+        GraphLayoutWorker repeatWorker(&repeatFmmm, &repeatGraphAttributes, &repeatEdgeLengths, quality, 10, false, false, 3, FMMM_LAYOUT);
+        repeatWorker.layoutGraph();
+        ogdf::node v = graph.firstNode();
+        ogdf::node repeatV = repeatGraph.firstNode();
+        for (; v != 0; v = v->succ(), repeatV = repeatV->succ())
+        {
+            QCOMPARE(graphAttributes.x(v), repeatGraphAttributes.x(repeatV));
+            QCOMPARE(graphAttributes.y(v), repeatGraphAttributes.y(repeatV));
+        }
+    }
+
+    //A layout cancelled before it starts only places its nodes, so the
+    //graph can still be drawn.
+    ogdf::Graph graph;
+    ogdf::GraphAttributes graphAttributes(graph, ogdf::GraphAttributes::nodeGraphics |
+                                          ogdf::GraphAttributes::edgeGraphics);
+    addChainsToGraph(&graph, &graphAttributes);
+    ogdf::EdgeArray<double> edgeLengths(graph, 1.0);
+    ogdf::FMMMLayout fmmm;
+    GraphLayoutWorker worker(&fmmm, &graphAttributes, &edgeLengths, 4, 10, false, false, 3, FMMM_LAYOUT);
+    worker.cancelLayout();
+    QSignalSpy progressSpy(&worker, SIGNAL(setLayoutCompletedCount(int)));
+    QSignalSpy finishedSpy(&worker, SIGNAL(finishedLayout()));
+    worker.layoutGraph();
+    QCOMPARE(finishedSpy.size(), 1);
+    QCOMPARE(progressSpy.size(), 1);
+    QCOMPARE(progressSpy[0].at(0).toInt(), 0);
+    ogdf::node first = graph.firstNode();
+    ogdf::node v;
+    bool nodesPlaced = false;
+    forall_nodes(v, graph)
+    {
+        if (graphAttributes.x(v) != graphAttributes.x(first) || graphAttributes.y(v) != graphAttributes.y(first))
+            nodesPlaced = true;
+    }
+    QVERIFY(nodesPlaced);
+}
+
+
+//This test lays out each sample graph with both layout algorithms and
+//checks that the grid layout's stress is close to FMMM's.  If
+//BANDAGE_BENCHMARK is set, their times and stress are printed too, so they
+//can be compared.
+void BandageTests::layoutAlgorithmStress()
+{
+    bool printTimes = !qgetenv("BANDAGE_BENCHMARK").isEmpty();
+
+    QStringList graphFiles;
+    graphFiles << "test.fastg" << "test.LastGraph" << "test_plasmids.gfa";
+    for (int i = 0; i < graphFiles.size(); ++i)
+    {
+        createGlobals();
+        g_assemblyGraph->loadGraphFromFile(getTestDirectory() + graphFiles[i]);
+        g_settings->graphScope = WHOLE_GRAPH;
+        g_settings->layoutSeed = 1;
+        QString errorTitle;
+        QString errorMessage;
+        std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+        g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+
+        QElapsedTimer timer;
+        g_settings->layoutAlgorithm = FMMM_LAYOUT;
+        timer.start();
+        g_assemblyGraph->layoutGraph();
+        qint64 fmmmTime = timer.elapsed();
+        double fmmmStress = getLayoutStress();
+
+        g_settings->layoutAlgorithm = GRID_LAYOUT;
+        timer.start();
+        g_assemblyGraph->layoutGraph();
+        qint64 gridTime = timer.elapsed();
+        double gridStress = getLayoutStress();
+
+        if (printTimes)
+            qDebug() << graphFiles[i] << g_assemblyGraph->m_ogdfGraph->numberOfNodes() << "OGDF nodes:"
+                     << "FMMM" << fmmmTime << "ms, stress" << fmmmStress << "/"
+                     << "grid" << gridTime << "ms, stress" << gridStress;
+
+        QVERIFY(gridStress < fmmmStress * 1.5 + 0.05);
+    }
+}
+
+
+//This test runs the force kernel on a synthetic chain graph: a random walk
+//with one node per step.  It checks the SIMD moves against a simple double
+//precision sum over every pair of nodes.
+//If BANDAGE_BENCHMARK is set, it also runs on chains of ten thousand up to
+//one million nodes (or up to BANDAGE_BENCHMARK_MAX_NODES if that is set,
+//e.g. to 10000000) and prints how long a grid build and a pass over all
+//nodes take at each size.
+void BandageTests::forceKernel()
+{
+    bool benchmark = !qgetenv("BANDAGE_BENCHMARK").isEmpty();
+    int maxNodeCount = 1000000;
+    QByteArray maxNodeCountSetting = qgetenv("BANDAGE_BENCHMARK_MAX_NODES");
+    if (!maxNodeCountSetting.isEmpty())
+        maxNodeCount = maxNodeCountSetting.toInt();
+
+    std::vector<int> nodeCounts;
+    nodeCounts.push_back(2000);
+    if (benchmark)
+    {
+        for (int n = 10000; n <= maxNodeCount; n *= 10)
+            nodeCounts.push_back(n);
+    }
+
+    double edgeLength = 10.0;
+    for (size_t c = 0; c < nodeCounts.size(); ++c)
+    {
+        int n = nodeCounts[c];
+        std::vector<double> x(n);
+        std::vector<double> y(n);
+        std::vector<double> weights(n, 1.0);
+        std::vector<int> edgeStarts(n + 1, 0);
+        std::vector<int> edgeTargets;
+        std::vector<double> edgeLengths;
+        double angle = 0.0;
+        srand(1);
+        for (int i = 0; i < n; ++i)
+        {
+            angle += double(rand()) / RAND_MAX - 0.5;
+            x[i] = (i == 0) ? 0.0 : x[i - 1] + edgeLength * cos(angle);
+            y[i] = (i == 0) ? 0.0 : y[i - 1] + edgeLength * sin(angle);
+            if (i > 0)
+            {
+                edgeTargets.push_back(i - 1);
+                edgeLengths.push_back(1.0);
+            }
+            if (i < n - 1)
+            {
+                edgeTargets.push_back(i + 1);
+                edgeLengths.push_back(1.0);
+            }
+            edgeStarts[i + 1] = int(edgeTargets.size());
+        }
+
+        ForceNodes nodes;
+        nodes.nodeCount = n;
+        nodes.x = x.data();
+        nodes.y = y.data();
+        nodes.weights = weights.data();
+        nodes.edgeStarts = edgeStarts.data();
+        nodes.edgeTargets = edgeTargets.data();
+        nodes.edgeLengths = edgeLengths.data();
+
+        ForceParameters parameters;
+        parameters.edgeLength = edgeLength;
+        parameters.edgeLengthUnit = edgeLength;
+        parameters.repulsionRange = edgeLength * 2.0;
+        parameters.maxMove = 1e9;
+
+        ForceKernel kernel;
+        std::vector<double> moveX(n);
+        std::vector<double> moveY(n);
+        QElapsedTimer timer;
+        timer.start();
+        kernel.buildGrid(nodes, parameters);
+        qint64 gridTime = timer.elapsed();
+        timer.start();
+        kernel.getMoves(nodes, parameters, 0, n, moveX.data(), moveY.data());
+        qint64 moveTime = timer.elapsed();
+
+        if (benchmark)
+            qDebug() << n << "nodes, SIMD width" << ForceKernel::getSimdWidth() << ":"
+                     << "grid" << gridTime << "ms, moves" << moveTime << "ms";
+
+        //Nodes right on the edge of the repulsion range are left out of the
+        //check, as single and double precision can disagree on them.
+        if (n > 10000)
+            continue;
+        double rangeSquared = parameters.repulsionRange * parameters.repulsionRange;
+        for (int i = 0; i < n; i += 7)
+        {
+            double dx = 0.0;
+            double dy = 0.0;
+            bool nearRangeEdge = false;
+            for (int j = 0; j < n; ++j)
+            {
+                double awayX = x[i] - x[j];
+                double awayY = y[i] - y[j];
+                double distanceSquared = awayX * awayX + awayY * awayY;
+                if (fabs(distanceSquared - rangeSquared) < rangeSquared * 0.001)
+                    nearRangeEdge = true;
+                if (distanceSquared >= rangeSquared || distanceSquared <= edgeLength * edgeLength * 1e-6)
+                    continue;
+                double force = edgeLength * edgeLength / distanceSquared;
+                dx += awayX * force;
+                dy += awayY * force;
+            }
+            for (int e = edgeStarts[i]; e < edgeStarts[i + 1]; ++e)
+            {
+                int j = edgeTargets[e];
+                double distance = sqrt((x[j] - x[i]) * (x[j] - x[i]) + (y[j] - y[i]) * (y[j] - y[i]));
+                dx += (x[j] - x[i]) * distance / edgeLength;
+                dy += (y[j] - y[i]) * distance / edgeLength;
+            }
+            if (nearRangeEdge)
+                continue;
+            double error = sqrt((dx - moveX[i]) * (dx - moveX[i]) + (dy - moveY[i]) * (dy - moveY[i]));
+            QVERIFY(error < 0.01 * std::max(1.0, sqrt(dx * dx + dy * dy)));
+        }
+    }
+}
+
+
+void BandageTests::layoutFile()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = AROUND_NODE;
+    g_settings->startingNodes = "6";
+    g_settings->nodeDistance = 2;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, true, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+
+    QHash<QString, std::vector<QPointF> > drawnPoints;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        if (i.value()->getGraphicsItemNode() != 0)
+            drawnPoints.insert(i.key(), i.value()->getGraphicsItemNode()->m_linePoints);
+    }
+    QVERIFY(drawnPoints.size() > 1);
+
+    QString layoutFilename = getTestDirectory() + "test_temp.layout";
+    QVERIFY(g_assemblyGraph->saveLayout(layoutFilename));
+
+    //Loading the layout into a fresh graph draws the same nodes in the same
+    //places (to the precision of the file), with no layout done.
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    QHash<QString, std::vector<QPointF> > loadedPoints;
+    bool doubleMode = false;
+    QString errormsg;
+    QVERIFY(g_assemblyGraph->loadLayout(layoutFilename, &loadedPoints, &doubleMode, &errormsg));
+    QCOMPARE(doubleMode, true);
+    QCOMPARE(loadedPoints.size(), drawnPoints.size());
+
+    g_assemblyGraph->buildOgdfGraphFromLayout(loadedPoints, doubleMode);
+    MyGraphicsScene loadedScene;
+    g_assemblyGraph->addGraphicsItemsToScene(&loadedScene, &loadedPoints);
+    QCOMPARE(g_assemblyGraph->getDrawnNodeCount(), drawnPoints.size());
+
+    QHashIterator<QString, std::vector<QPointF> > j(drawnPoints);
+    while (j.hasNext())
+    {
+        j.next();
+        GraphicsItemNode * graphicsItemNode = g_assemblyGraph->m_deBruijnGraphNodes[j.key()]->getGraphicsItemNode();
+        QVERIFY(graphicsItemNode != 0);
+        QCOMPARE(graphicsItemNode->m_linePoints.size(), j.value().size());
+        for (size_t k = 0; k < j.value().size(); ++k)
+            QVERIFY(QLineF(graphicsItemNode->m_linePoints[k], j.value()[k]).length() < 0.01);
+    }
+
+    //Files that aren't layouts are rejected.
+    QVERIFY(!g_assemblyGraph->loadLayout(getTestDirectory() + "test.fastg", &loadedPoints, &doubleMode, &errormsg));
+
+    //A node saved with fewer points than it has OGDF nodes has its OGDF
+    //nodes spread along its saved line, not left at the origin.
+    QFile layoutFile(layoutFilename);
+    QVERIFY(layoutFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    layoutFile.write("#Bandage layout\tsingle\n1+\t100.00\t50.00\t200.00\t50.00\n");
+    layoutFile.close();
+    QVERIFY(g_assemblyGraph->loadLayout(layoutFilename, &loadedPoints, &doubleMode, &errormsg));
+    g_assemblyGraph->buildOgdfGraphFromLayout(loadedPoints, doubleMode);
+    const std::vector<ogdf::node> & ogdfNodes = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getOgdfNode()->m_ogdfNodes;
+    QVERIFY(ogdfNodes.size() > 2);
+    QCOMPARE(g_assemblyGraph->m_graphAttributes->x(ogdfNodes.front()), 100.0);
+    QCOMPARE(g_assemblyGraph->m_graphAttributes->x(ogdfNodes.back()), 200.0);
+    for (size_t k = 1; k < ogdfNodes.size(); ++k)
+    {
+        QCOMPARE(g_assemblyGraph->m_graphAttributes->y(ogdfNodes[k]), 50.0);
+        QVERIFY(g_assemblyGraph->m_graphAttributes->x(ogdfNodes[k]) > g_assemblyGraph->m_graphAttributes->x(ogdfNodes[k - 1]));
+    }
+
+    QFile::remove(layoutFilename);
+}
+
+
+void BandageTests::incrementalRedraw()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = AROUND_NODE;
+    g_settings->doubleMode = false;
+    g_settings->startingNodes = "6";
+    g_settings->nodeDistance = 0;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, false, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene * scene = new MyGraphicsScene();
+    g_assemblyGraph->addGraphicsItemsToScene(scene);
+
+    //The user drags the node somewhere else.
+    DeBruijnNode * node6 = g_assemblyGraph->m_deBruijnGraphNodes["6+"];
+    GraphicsItemNode * graphicsItemNode6 = node6->getGraphicsItemNode();
+    QVERIFY(graphicsItemNode6 != 0);
+    for (size_t i = 0; i < graphicsItemNode6->m_linePoints.size(); ++i)
+        graphicsItemNode6->m_linePoints[i] += QPointF(1000.0, -500.0);
+    std::vector<QPointF> draggedPoints = graphicsItemNode6->m_linePoints;
+
+    QHash<QString, std::vector<double> > previousPositions;
+    g_assemblyGraph->getOgdfNodePositionsByName(&previousPositions);
+    delete scene;
+
+    //Drawing more of the graph keeps the dragged node where it was left.
+    g_settings->nodeDistance = 1;
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    ogdf::NodeArray<bool> fixedNodes(*g_assemblyGraph->m_ogdfGraph, false);
+    int fixedCount = g_assemblyGraph->setOgdfNodePositionsByName(previousPositions, &fixedNodes);
+    //Only the newly drawn nodes are left to be laid out.
+    QCOMPARE(fixedCount, int(node6->getOgdfNode()->m_ogdfNodes.size()));
+    QVERIFY(fixedCount < g_assemblyGraph->m_ogdfGraph->numberOfNodes());
+
+    ogdf::FMMMLayout fmmm;
+    GraphLayoutWorker worker(&fmmm, g_assemblyGraph->m_graphAttributes, g_assemblyGraph->m_ogdfEdgeLengths,
+                             g_settings->graphLayoutQuality, g_settings->segmentLength, false, false, 1,
+                             FMMM_LAYOUT);
+    worker.m_fixedNodes = &fixedNodes;
+    worker.layoutGraph();
+
+    scene = new MyGraphicsScene();
+    g_assemblyGraph->addGraphicsItemsToScene(scene);
+    graphicsItemNode6 = node6->getGraphicsItemNode();
+    QCOMPARE(graphicsItemNode6->m_linePoints.size(), draggedPoints.size());
+    for (size_t i = 0; i < draggedPoints.size(); ++i)
+        QVERIFY(QLineF(graphicsItemNode6->m_linePoints[i], draggedPoints[i]).length() < 0.01);
+    delete scene;
+}
+
+
+void BandageTests::nodeOutlineCache()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    std::vector<QPointF> linePoints;
+    linePoints.push_back(QPointF(0.0, 0.0));
+    linePoints.push_back(QPointF(100.0, 0.0));
+    GraphicsItemNode node(g_assemblyGraph->m_deBruijnGraphNodes["1+"], linePoints);
+
+    //The outline is only remade when the node's width or path changes.
+    QRectF outlineRect = node.shape().boundingRect();
+    QCOMPARE(node.getSimplifiedOutline().boundingRect(), outlineRect);
+
+    g_settings->averageNodeWidth *= 2.0;
+    QCOMPARE(node.shape().boundingRect(), outlineRect);
+    node.setWidth();
+    QVERIFY(node.shape().boundingRect().height() > outlineRect.height());
+    QCOMPARE(node.getSimplifiedOutline().boundingRect(), node.shape().boundingRect());
+
+    outlineRect = node.shape().boundingRect();
+    node.m_linePoints[1] = QPointF(200.0, 0.0);
+    QCOMPARE(node.shape().boundingRect(), outlineRect);
+    node.remakePath();
+    QVERIFY(node.shape().boundingRect().width() > outlineRect.width());
+}
+
+
+void BandageTests::tiledRendering()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+
+    //Scenes with fewer nodes than the setting are left alone.
+    TileRenderer tileRenderer;
+    g_settings->tiledRenderingNodeCount = g_assemblyGraph->getDrawnNodeCount() + 1;
+    tileRenderer.takeSnapshot(&scene);
+    QVERIFY(!tileRenderer.isActive());
+
+    g_settings->tiledRenderingNodeCount = 1;
+    tileRenderer.takeSnapshot(&scene);
+    QVERIFY(tileRenderer.isActive());
+    GraphicsItemNode * node = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getGraphicsItemNode();
+    QVERIFY(node->flags() & QGraphicsItem::ItemHasNoContents);
+
+    //Render the tile at the centre of the node, at a scale where the node
+    //is about half a tile across.
+    QRectF nodeRect = node->boundingRect();
+    int level = TileRenderer::getLevelForZoom(128.0 / qMax(nodeRect.width(), nodeRect.height()));
+    double tileSize = TileRenderer::getTileRect(TileKey(level, 0, 0)).width();
+    TileKey key(level, int(floor(nodeRect.center().x() / tileSize)), int(floor(nodeRect.center().y() / tileSize)));
+    QImage allNodes = TileRenderer::renderTile(tileRenderer.getSnapshot(), key);
+
+    //Selecting a node takes it out of the tiles, so it is drawn live.
+    node->setSelected(true);
+    QVERIFY(!(node->flags() & QGraphicsItem::ItemHasNoContents));
+    QImage withoutSelection = TileRenderer::renderTile(tileRenderer.getSnapshot(), key);
+    int allNodesPixels = 0;
+    int withoutSelectionPixels = 0;
+    for (int y = 0; y < allNodes.height(); ++y)
+    {
+        for (int x = 0; x < allNodes.width(); ++x)
+        {
+            if (qAlpha(allNodes.pixel(x, y)) > 0)
+                ++allNodesPixels;
+            if (qAlpha(withoutSelection.pixel(x, y)) > 0)
+                ++withoutSelectionPixels;
+        }
+    }
+    QVERIFY(allNodesPixels > 0);
+    QVERIFY(withoutSelectionPixels < allNodesPixels);
+
+    //Clearing the renderer gives every item back its contents.
+    tileRenderer.clear();
+    QVERIFY(!(g_assemblyGraph->m_deBruijnGraphNodes["2+"]->getGraphicsItemNode()->flags() & QGraphicsItem::ItemHasNoContents));
+}
+
+
+void BandageTests::labelCache()
+{
+    createGlobals();
+    g_settings->textOutline = true;
+    g_settings->textOutlineThickness = 0.3;
+
+    //The same text gives the same paths, and the outline surrounds the text.
+    LabelPaths first = LabelCache::getLabelPaths(QStringList("Node 1"));
+    LabelPaths second = LabelCache::getLabelPaths(QStringList("Node 1"));
+    QVERIFY(!first.text.isEmpty());
+    QCOMPARE(first.text.boundingRect(), second.text.boundingRect());
+    QVERIFY(first.outline.boundingRect().contains(first.text.boundingRect()));
+
+    //A second line goes above the first, so the label gets taller.
+    LabelPaths twoLines = LabelCache::getLabelPaths(QString("Node 1\n100 bp").split("\n"));
+    QVERIFY(twoLines.text.boundingRect().height() > first.text.boundingRect().height());
+
+    //Changing the font gives new paths.
+    g_settings->labelFont.setPointSize(g_settings->labelFont.pointSize() * 2);
+    LabelPaths biggerFont = LabelCache::getLabelPaths(QStringList("Node 1"));
+    QVERIFY(biggerFont.text.boundingRect().height() > first.text.boundingRect().height());
+
+    //Areas overlapping one already used are refused until the areas are
+    //cleared.
+    LabelCache::clearUsedAreas();
+    QVERIFY(LabelCache::useArea(QRectF(0.0, 0.0, 100.0, 20.0)));
+    QVERIFY(!LabelCache::useArea(QRectF(90.0, 10.0, 100.0, 20.0)));
+    QVERIFY(LabelCache::useArea(QRectF(200.0, 0.0, 100.0, 20.0)));
+    QVERIFY(LabelCache::useArea(QRectF(-150.0, -150.0, 20.0, 20.0)));
+    QVERIFY(!LabelCache::useArea(QRectF(-140.0, -140.0, 20.0, 20.0)));
+
+    //Cells with negative coordinates get keys of their own.
+    QVERIFY(getGridCellKey(-1, -1) != getGridCellKey(-1, 0));
+    QVERIFY(getGridCellKey(-1, -1) != getGridCellKey(0, -1));
+    QVERIFY(getGridCellKey(-1, 1) != getGridCellKey(1, -1));
+    LabelCache::clearUsedAreas();
+    QVERIFY(LabelCache::useArea(QRectF(90.0, 10.0, 100.0, 20.0)));
+}
+
+
+void BandageTests::sceneIndex()
+{
+    //Segment tests.
+    QCOMPARE(SceneIndex::distanceToSegment(QPointF(5.0, 3.0), QPointF(0.0, 0.0), QPointF(10.0, 0.0)), 3.0);
+    QCOMPARE(SceneIndex::distanceToSegment(QPointF(13.0, 4.0), QPointF(0.0, 0.0), QPointF(10.0, 0.0)), 5.0);
+    QPolygonF square(QRectF(0.0, 0.0, 10.0, 10.0));
+    QVERIFY(SceneIndex::segmentTouchesPolygon(QPointF(2.0, 2.0), QPointF(3.0, 3.0), 0.5, square));
+    QVERIFY(SceneIndex::segmentTouchesPolygon(QPointF(-5.0, 5.0), QPointF(15.0, 5.0), 0.5, square));
+    QVERIFY(SceneIndex::segmentTouchesPolygon(QPointF(-5.0, 11.0), QPointF(15.0, 11.0), 1.5, square));
+    QVERIFY(!SceneIndex::segmentTouchesPolygon(QPointF(-5.0, 11.0), QPointF(15.0, 11.0), 0.5, square));
+
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+    QVERIFY(scene.getIndex()->getSegmentCount() > 0);
+
+    //Every node is found at each of its points, and by a small area
+    //around its first point.
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        GraphicsItemNode * node = i.value()->getGraphicsItemNode();
+        if (node == 0)
+            continue;
+        QPointF first = node->m_linePoints.front();
+        std::vector<QGraphicsItem *> found = scene.getIndex()->getItemsInArea(QPolygonF(QRectF(first - QPointF(1.0, 1.0), QSizeF(2.0, 2.0))));
+        QVERIFY(std::find(found.begin(), found.end(), node) != found.end());
+        for (size_t j = 0; j < node->m_linePoints.size(); ++j)
+            QVERIFY(scene.getIndexedItemAt(node->m_linePoints[j]) != 0);
+    }
+
+    //Nothing is found away from the scene.
+    QRectF itemsRect = scene.itemsBoundingRect();
+    QPolygonF farAway(QRectF(itemsRect.right() + 100.0, itemsRect.bottom() + 100.0, 10.0, 10.0));
+    QVERIFY(scene.getIndex()->getItemsInArea(farAway).empty());
+
+    //Selecting everything emits selectionChanged once, and selects the same
+    //items as the scene's own shape tests.
+    QSignalSpy selectionSpy(&scene, SIGNAL(selectionChanged()));
+    QPolygonF everything(itemsRect.adjusted(-1.0, -1.0, 1.0, 1.0));
+    scene.selectItemsInArea(everything);
+    QCOMPARE(selectionSpy.count(), 1);
+    QCOMPARE(scene.selectedItems().size(), scene.items(everything, Qt::IntersectsItemShape).size());
+
+    //Moving a node makes the index out of date, and it finds the node in
+    //its new position when it is built again.
+    //Selected nodes are moved as a whole.
+    GraphicsItemNode * node = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getGraphicsItemNode();
+    node->setSelected(true);
+    node->shiftPoints(QPointF(itemsRect.width() * 10.0, 0.0));
+    node->remakePath();
+    QVERIFY(!scene.getIndex()->getItemsInArea(QPolygonF(node->boundingRect())).empty());
+    QCOMPARE(scene.getIndexedItemAt(node->m_linePoints.front()), static_cast<QGraphicsItem *>(node));
+}
+
+
+//Only the bounding rectangles of changed items are redrawn, so they must
+//hold everything the items draw.
+void BandageTests::itemBoundingRects()
+{
+    createGlobals();
+    g_settings->edgeWidth = 5.0;
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+
+    QList<QGraphicsItem *> items = scene.items();
+    for (int i = 0; i < items.size(); ++i)
+    {
+        QRectF shapeRect = items[i]->shape().boundingRect();
+        QVERIFY(items[i]->boundingRect().contains(shapeRect));
+
+        GraphicsItemNode * node = dynamic_cast<GraphicsItemNode *>(items[i]);
+        if (node != 0)
+        {
+            double selection = g_settings->selectionThickness;
+            QVERIFY(node->boundingRect().contains(shapeRect.adjusted(-selection, -selection, selection, selection)));
+        }
+    }
+
+    //Moving a node moves its bounding rectangle, and the scene finds it in
+    //its new place.
+    GraphicsItemNode * node = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getGraphicsItemNode();
+    node->setSelected(true);
+    QRectF before = node->boundingRect();
+    QPointF shift(before.width() * 10.0 + 1000.0, 0.0);
+    node->shiftPoints(shift);
+    node->remakePath();
+    QCOMPARE(node->boundingRect(), before.translated(shift));
+    QVERIFY(scene.items(before.translated(shift), Qt::IntersectsItemBoundingRect).contains(node));
+    QVERIFY(!scene.items(before, Qt::ContainsItemBoundingRect).contains(node));
+}
+
+
+//A PNG written in bands must match the image it was made from, and an
+//exported scene must look like the scene drawn in one go.
+void BandageTests::bandedImageExport()
+{
+    QImage source(37, 23, QImage::Format_RGB32);
+    for (int y = 0; y < source.height(); ++y)
+    {
+        for (int x = 0; x < source.width(); ++x)
+            source.setPixel(x, y, qRgb(x * 7, y * 11, (x * y) % 256));
+    }
+    QString pngFilename = getTestDirectory() + "banded_temp.png";
+    PngWriter writer(pngFilename);
+    QVERIFY(writer.open(source.width(), source.height()));
+    QVERIFY(writer.writeBand(PngWriter::compressBand(source.copy(0, 0, 37, 10), false)));
+    QVERIFY(writer.writeBand(PngWriter::compressBand(source.copy(0, 10, 37, 10), false)));
+
+    //A file can't be finished until every row is written.
+    QVERIFY(!writer.close());
+
+    PngWriter completeWriter(pngFilename);
+    QVERIFY(completeWriter.open(source.width(), source.height()));
+    QVERIFY(completeWriter.writeBand(PngWriter::compressBand(source.copy(0, 0, 37, 10), false)));
+    QVERIFY(completeWriter.writeBand(PngWriter::compressBand(source.copy(0, 10, 37, 10), false)));
+    QVERIFY(completeWriter.writeBand(PngWriter::compressBand(source.copy(0, 20, 37, 3), true)));
+    QVERIFY(completeWriter.close());
+    QImage written(pngFilename);
+    QCOMPARE(written.size(), source.size());
+    QCOMPARE(written.convertToFormat(QImage::Format_RGB32), source);
+
+    createGlobals();
+    g_settings->displayNodeNames = true;
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+    scene.setSceneRectangle();
+
+    QSize imageSize(600, 1500);
+    QString error;
+    QVERIFY(SceneImageExporter::savePng(&scene, pngFilename, imageSize, &error));
+    QImage exported = QImage(pngFilename).convertToFormat(QImage::Format_RGB32);
+    QCOMPARE(exported.size(), imageSize);
+
+    //Antialiasing can differ very slightly where bands meet.
+    QImage expected = renderScene(&scene, imageSize);
+    QVERIFY(countDifferentPixels(exported, expected, 8) < imageSize.width() * imageSize.height() / 1000);
+
+    //With big labels, many overlap and many cross the edges between bands.
+    //The bands of a 4096 pixel wide image are at most 1024 rows tall, so
+    //this one has at least three.  The overlapping labels must be hidden
+    //just as they are when the scene is drawn in one piece.
+    g_settings->labelFont.setPointSize(g_settings->labelFont.pointSize() * 8);
+    QSize labelImageSize(4096, 3072);
+    int labelImageArea = labelImageSize.width() * labelImageSize.height();
+    QVERIFY(SceneImageExporter::savePng(&scene, pngFilename, labelImageSize, &error));
+    QImage labelExported = QImage(pngFilename).convertToFormat(QImage::Format_RGB32);
+    QImage labelExpected = renderScene(&scene, labelImageSize);
+    QVERIFY(countDifferentPixels(labelExported, labelExpected, 8) < labelImageArea / 5000);
+
+    //Hiding the labels must change the image, or the check above shows
+    //nothing.
+    g_settings->hideOverlappingLabels = false;
+    QImage allLabels = renderScene(&scene, labelImageSize);
+    g_settings->hideOverlappingLabels = true;
+    QVERIFY(countDifferentPixels(allLabels, labelExpected, 8) > labelImageArea / 1000);
+
+    //Images wider than QPainter can draw in must still be drawn all the way
+    //across.
+    QGraphicsScene wideScene;
+    wideScene.setSceneRect(0.0, 0.0, 40000.0, 10.0);
+    wideScene.addRect(39000.0, 0.0, 1000.0, 10.0, Qt::NoPen, QBrush(Qt::black));
+    QVERIFY(SceneImageExporter::savePng(&wideScene, pngFilename, QSize(40000, 10), &error));
+    QImage wideExported = QImage(pngFilename).convertToFormat(QImage::Format_RGB32);
+    QCOMPARE(wideExported.size(), QSize(40000, 10));
+    QCOMPARE(wideExported.pixel(39500, 5), qRgb(0, 0, 0));
+    QCOMPARE(wideExported.pixel(39995, 5), qRgb(0, 0, 0));
+    QCOMPARE(wideExported.pixel(38000, 5), qRgb(255, 255, 255));
+    QCOMPARE(wideExported.pixel(100, 5), qRgb(255, 255, 255));
+    QFile::remove(pngFilename);
+}
+
+
+//SVG files written directly must be valid, hold a line for each node, be
+//smaller than those made by QSvgGenerator and look the same as them.
+void BandageTests::svgExport()
+{
+    createGlobals();
+    g_settings->doubleMode = true;
+    g_settings->displayNodeNames = true;
+    g_settings->nodeColourScheme = BLAST_HITS_SOLID_COLOUR;
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_settings->blastQueryFilename = getTestDirectory() + "test_queries1.fasta";
+    createBlastTempDirectory();
+    g_blastSearch->doAutoBlastSearch();
+    QVERIFY(g_blastSearch->m_allHits.size() > 0);
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+    scene.setSceneRectangle();
+    QSize imageSize = scene.sceneRect().size().toSize();
+    g_memory->fullDetailPainting = true;
+
+    QString svgFilename = getTestDirectory() + "svg_temp.svg";
+    SvgWriter writer(svgFilename);
+    QVERIFY(writer.writeScene(&scene, imageSize));
+
+    int nodeCount = 0;
+    int edgeCount = 0;
+    QList<QGraphicsItem *> items = scene.items();
+    for (int i = 0; i < items.size(); ++i)
+    {
+        if (dynamic_cast<GraphicsItemNode *>(items[i]) != 0)
+            ++nodeCount;
+        else if (dynamic_cast<GraphicsItemEdge *>(items[i]) != 0)
+            ++edgeCount;
+    }
+
+    QFile svgFile(svgFilename);
+    QVERIFY(svgFile.open(QIODevice::ReadOnly));
+    QXmlStreamReader reader(&svgFile);
+    int polylineCount = 0;
+    int edgePathCount = 0;
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+        if (!reader.isStartElement())
+            continue;
+        if (reader.name() == "polyline")
+            ++polylineCount;
+        if (reader.name() == "path" && reader.attributes().value("class") == "e")
+            ++edgePathCount;
+    }
+    QVERIFY(!reader.hasError());
+    QVERIFY(polylineCount >= nodeCount);
+    QCOMPARE(edgePathCount, edgeCount);
+    qint64 svgWriterSize = svgFile.size();
+    svgFile.close();
+
+    QString generatorFilename = getTestDirectory() + "svg_generator_temp.svg";
+    QSvgGenerator generator;
+    generator.setFileName(generatorFilename);
+    generator.setSize(imageSize);
+    generator.setViewBox(QRect(QPoint(0, 0), imageSize));
+    QPainter painter;
+    painter.begin(&generator);
+    painter.fillRect(QRect(QPoint(0, 0), imageSize), Qt::white);
+    scene.render(&painter);
+    painter.end();
+    QVERIFY(svgWriterSize < QFileInfo(generatorFilename).size());
+
+    //Both files are drawn and compared pixel by pixel.  Labels are left out
+    //here, as the two files give their text in different ways and fonts can
+    //be drawn slightly differently.  Antialiasing can differ along lines, so
+    //a few pixels may differ, but arrowheads, BLAST hit parts or edges which
+    //are missing or misplaced would change far more.
+    g_settings->displayNodeNames = false;
+    SvgWriter unlabelledWriter(svgFilename);
+    QVERIFY(unlabelledWriter.writeScene(&scene, imageSize));
+    QSvgGenerator unlabelledGenerator;
+    unlabelledGenerator.setFileName(generatorFilename);
+    unlabelledGenerator.setSize(imageSize);
+    unlabelledGenerator.setViewBox(QRect(QPoint(0, 0), imageSize));
+    painter.begin(&unlabelledGenerator);
+    painter.fillRect(QRect(QPoint(0, 0), imageSize), Qt::white);
+    scene.render(&painter);
+    painter.end();
+    g_memory->fullDetailPainting = false;
+
+    QSize renderSize = imageSize.scaled(1000, 1000, Qt::KeepAspectRatio);
+    QImage written = renderSvg(svgFilename, renderSize);
+    QImage generated = renderSvg(generatorFilename, renderSize);
+    int drawnPixels = 0;
+    int differentPixels = 0;
+    for (int y = 0; y < renderSize.height(); ++y)
+    {
+        for (int x = 0; x < renderSize.width(); ++x)
+        {
+            QRgb a = written.pixel(x, y);
+            QRgb b = generated.pixel(x, y);
+            if (b != qRgb(255, 255, 255))
+                ++drawnPixels;
+            if (qAbs(qRed(a) - qRed(b)) > 48 || qAbs(qGreen(a) - qGreen(b)) > 48 || qAbs(qBlue(a) - qBlue(b)) > 48)
+                ++differentPixels;
+        }
+    }
+    QVERIFY(drawnPixels > renderSize.width() * renderSize.height() / 100);
+    QVERIFY(differentPixels < drawnPixels / 50);
+
+    QFile::remove(svgFilename);
+    QFile::remove(generatorFilename);
+    deleteBlastTempDirectory();
+}
+
+
+void BandageTests::edgeBundling()
+{
+    //Three edges running side by side (one drawn the other way) are bundled,
+    //while an edge elsewhere and an edge which curves differently are not.
+    std::vector<EdgeBundleInput> edges;
+    for (int i = 0; i < 6; ++i)
+    {
+        EdgeBundleInput edge;
+        edge.valid = true;
+        edge.start = QPointF(0.0, i * 0.2);
+        edge.control1 = QPointF(10.0, i * 0.2);
+        edge.control2 = QPointF(90.0, i * 0.2);
+        edge.end = QPointF(100.0, i * 0.2);
+        edges.push_back(edge);
+    }
+    std::swap(edges[1].start, edges[1].end);
+    std::swap(edges[1].control1, edges[1].control2);
+    edges[3].start += QPointF(500.0, 0.0);
+    edges[3].control1 += QPointF(500.0, 0.0);
+    edges[3].control2 += QPointF(500.0, 0.0);
+    edges[3].end += QPointF(500.0, 0.0);
+    edges[4].control1 = QPointF(10.0, 50.0);
+    edges[4].control2 = QPointF(90.0, 50.0);
+    edges[5].valid = false;
+
+    std::vector<EdgeBundle> bundles = EdgeBundler::findBundles(edges, 1.0);
+    QCOMPARE(int(bundles.size()), 1);
+    QCOMPARE(int(bundles[0].edges.size()), 3);
+    QCOMPARE(bundles[0].edges[0], 0);
+    QCOMPARE(bundles[0].edges[1], 1);
+    QCOMPARE(bundles[0].edges[2], 2);
+    QCOMPARE(bundles[0].start, QPointF(0.0, 0.2));
+    QCOMPARE(bundles[0].end, QPointF(100.0, 0.2));
+
+    //An edge which moves breaks up its bundle, so the other edges draw
+    //themselves again.
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+
+    std::vector<GraphicsItemEdge *> sceneEdges;
+    QList<QGraphicsItem *> items = scene.items();
+    for (int i = 0; i < items.size() && sceneEdges.size() < 3; ++i)
+    {
+        GraphicsItemEdge * edge = dynamic_cast<GraphicsItemEdge *>(items[i]);
+        if (edge != 0)
+            sceneEdges.push_back(edge);
+    }
+    QCOMPARE(int(sceneEdges.size()), 3);
+    sceneEdges[0]->setBundle(sceneEdges[0]->path(), sceneEdges);
+    QVERIFY(sceneEdges[2]->m_bundleLeader == sceneEdges[0]);
+    QVERIFY(sceneEdges[0]->boundingRect().contains(sceneEdges[0]->m_bundlePath.controlPointRect()));
+
+    //When zoomed out, members leave their drawing to the leader, unless the
+    //leader is selected and so only draws itself.
+    g_settings->edgeBundling = true;
+    double zoom = 0.9 * g_settings->lowDetailNodeWidth / g_settings->averageNodeWidth;
+    QVERIFY(EdgeBundler::isLowZoom(zoom));
+    QPicture memberPicture;
+    QPainter painter(&memberPicture);
+    painter.scale(zoom, zoom);
+    sceneEdges[2]->paint(&painter, 0, 0);
+    painter.end();
+    QVERIFY(memberPicture.boundingRect().isEmpty());
+
+    sceneEdges[0]->setSelected(true);
+    QPicture selectedLeaderPicture;
+    painter.begin(&selectedLeaderPicture);
+    painter.scale(zoom, zoom);
+    sceneEdges[2]->paint(&painter, 0, 0);
+    painter.end();
+    QVERIFY(!selectedLeaderPicture.boundingRect().isEmpty());
+    sceneEdges[0]->setSelected(false);
+    g_settings->edgeBundling = false;
+
+    sceneEdges[1]->calculateAndSetPath();
+    QVERIFY(sceneEdges[0]->m_bundleLeader == 0);
+    QVERIFY(sceneEdges[2]->m_bundleLeader == 0);
+    QVERIFY(sceneEdges[0]->m_bundleMembers.empty());
+    QVERIFY(sceneEdges[0]->m_bundlePath.isEmpty());
+}
+
+
+void BandageTests::colouredPartGroups()
+{
+    //A red part after a blue one joins the earlier red group, as it doesn't
+    //overlap anything.  A blue part overlapping it can join the blue group,
+    //which is drawn later, but a red part overlapping that blue part can't
+    //go back to the red group, so it starts a new one.
+    std::vector<BlastHitPart> parts;
+    parts.push_back(BlastHitPart(Qt::red, 0.0, 0.1));
+    parts.push_back(BlastHitPart(Qt::blue, 0.1, 0.2));
+    parts.push_back(BlastHitPart(Qt::red, 0.4, 0.3));
+    parts.push_back(BlastHitPart(Qt::blue, 0.35, 0.5));
+    parts.push_back(BlastHitPart(Qt::red, 0.45, 0.6));
+    parts.push_back(BlastHitPart(Qt::red, 0.6, 0.7));
+
+    std::vector<std::vector<BlastHitPart> > groups = GraphicsItemNode::groupPartsByColour(parts);
+    QCOMPARE(int(groups.size()), 3);
+    QCOMPARE(int(groups[0].size()), 2);
+    QCOMPARE(groups[0][0].m_colour, QColor(Qt::red));
+    QCOMPARE(groups[0][1].m_nodeFractionStart, 0.4);
+    QCOMPARE(int(groups[1].size()), 2);
+    QCOMPARE(groups[1][1].m_nodeFractionStart, 0.35);
+    QCOMPARE(int(groups[2].size()), 2);
+    QCOMPARE(groups[2][0].m_colour, QColor(Qt::red));
+    QCOMPARE(groups[2][1].m_nodeFractionEnd, 0.7);
+}
+
+
+//Nodes cache their BLAST hit part paths, so a query's new colour must make
+//them build the paths again.
+void BandageTests::blastQueryColourChange()
+{
+    createGlobals();
+    g_settings->nodeColourScheme = BLAST_HITS_SOLID_COLOUR;
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_settings->blastQueryFilename = getTestDirectory() + "test_queries1.fasta";
+    createBlastTempDirectory();
+    g_blastSearch->doAutoBlastSearch();
+    QVERIFY(g_blastSearch->m_allHits.size() > 0);
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>(), 0);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+    scene.setSceneRectangle();
+
+    QSize imageSize = scene.sceneRect().size().toSize().scaled(1000, 1000, Qt::KeepAspectRatio);
+    std::vector<int> redPixels;
+    std::vector<int> greenPixels;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        QColor colour = (pass == 0) ? QColor(255, 0, 0) : QColor(0, 255, 0);
+        for (size_t i = 0; i < g_blastSearch->m_blastQueries.m_queries.size(); ++i)
+            g_blastSearch->m_blastQueries.m_queries[i]->setColour(colour);
+
+        QImage image(imageSize, QImage::Format_RGB32);
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        scene.render(&painter);
+        painter.end();
+
+        int red = 0;
+        int green = 0;
+        for (int y = 0; y < image.height(); ++y)
+        {
+            for (int x = 0; x < image.width(); ++x)
+            {
+                QRgb pixel = image.pixel(x, y);
+                if (qRed(pixel) > 200 && qGreen(pixel) < 60 && qBlue(pixel) < 60)
+                    ++red;
+                if (qGreen(pixel) > 200 && qRed(pixel) < 60 && qBlue(pixel) < 60)
+                    ++green;
+            }
+        }
+        redPixels.push_back(red);
+        greenPixels.push_back(green);
+    }
+    QVERIFY(redPixels[0] > 0);
+    QCOMPARE(greenPixels[0], 0);
+    QCOMPARE(redPixels[1], 0);
+    QVERIFY(greenPixels[1] > 0);
+
+    deleteBlastTempDirectory();
+}
+
+
+void BandageTests::mergeAdjacentParts()
+{
+    //On a node 100 pixels long, the blue part is half a pixel long.
+    std::vector<BlastHitPart> parts;
+    parts.push_back(BlastHitPart(Qt::red, 0.0, 0.1));
+    parts.push_back(BlastHitPart(Qt::red, 0.1, 0.2));
+    parts.push_back(BlastHitPart(Qt::blue, 0.2, 0.205));
+    parts.push_back(BlastHitPart(Qt::green, 0.205, 0.3));
+    parts.push_back(BlastHitPart(Qt::yellow, 0.5, 0.6));
+
+    //Adjacent parts of the same colour are always joined.
+    std::vector<BlastHitPart> merged = GraphicsItemNode::mergeAdjacentParts(parts, 100.0, 0.0);
+    QCOMPARE(int(merged.size()), 4);
+    QCOMPARE(merged[0].m_colour, QColor(Qt::red));
+    QCOMPARE(merged[0].m_nodeFractionEnd, 0.2);
+    QCOMPARE(merged[1].m_colour, QColor(Qt::blue));
+    QCOMPARE(merged[2].m_colour, QColor(Qt::green));
+
+    //With a minimum length, the short blue part takes in the green part
+    //after it, but parts that don't touch are never joined.
+    merged = GraphicsItemNode::mergeAdjacentParts(parts, 100.0, 1.0);
+    QCOMPARE(int(merged.size()), 3);
+    QCOMPARE(merged[1].m_colour, QColor(Qt::blue));
+    QCOMPARE(merged[1].m_nodeFractionStart, 0.2);
+    QCOMPARE(merged[1].m_nodeFractionEnd, 0.3);
+    QCOMPARE(merged[2].m_colour, QColor(Qt::yellow));
+    QCOMPARE(merged[2].m_nodeFractionStart, 0.5);
+}
+
+
 void BandageTests::commandLineSettings()
 {
     createGlobals();
@@ -658,6 +2141,35 @@ void BandageTests::commandLineSettings()
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->graphLayoutQuality, 1);
 
+    QCOMPARE(g_settings->layoutAlgorithm, FMMM_LAYOUT);
+    commandLineSettings = QString("--layout grid").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->layoutAlgorithm, GRID_LAYOUT);
+
+    QCOMPARE(g_settings->componentLayout, false);
+    commandLineSettings = QString("--componentlayout").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->componentLayout, true);
+
+    QCOMPARE(g_settings->capNodeSegments, false);
+    commandLineSettings = QString("--capsegments").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->capNodeSegments, true);
+
+    QCOMPARE(g_settings->coarsenChains, false);
+    commandLineSettings = QString("--coarsen").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->coarsenChains, true);
+
+    QCOMPARE(g_settings->layoutSeed, -1);
+    commandLineSettings = QString("--seed 42").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->layoutSeed, 42);
+
+    commandLineSettings = QString("--layoutfile graph.layout").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->layoutFilename, QString("graph.layout"));
+
     commandLineSettings = QString("--nodewidth 4.2").split(" ");
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->averageNodeWidth, 4.2);
@@ -737,6 +2249,11 @@ void BandageTests::commandLineSettings()
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->positionTextNodeCentre, true);
 
+    QCOMPARE(g_settings->hideOverlappingLabels, true);
+    commandLineSettings = QString("--overlap").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->hideOverlappingLabels, false);
+
     commandLineSettings = QString("--colour random").split(" ");
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->nodeColourScheme, RANDOM_COLOURS);
@@ -1252,6 +2769,27 @@ DeBruijnEdge * BandageTests::getEdgeFromNodeNames(QString startingNodeName,
 
 //This function checks to see if two circular sequences match.  It needs to
 //check each possible rotation, as well as reverse complements.
+//This function adds four chains of different lengths to the graph, so it
+//has four components, one of them a lone node.
+void BandageTests::addChainsToGraph(ogdf::Graph * graph, ogdf::GraphAttributes * graphAttributes)
+{
+    int chainLengths[] = {12, 6, 3, 1};
+    for (int i = 0; i < 4; ++i)
+    {
+        ogdf::node previousNode = 0;
+        for (int j = 0; j < chainLengths[i]; ++j)
+        {
+            ogdf::node node = graph->newNode();
+            graphAttributes->width(node) = 10.0;
+            graphAttributes->height(node) = 10.0;
+            if (previousNode != 0)
+                graph->newEdge(previousNode, node);
+            previousNode = node;
+        }
+    }
+}
+
+
 bool BandageTests::doCircularSequencesMatch(QByteArray s1, QByteArray s2)
 {
     for (int i = 0; i < s1.length() - 1; ++i)
@@ -1276,5 +2814,115 @@ bool BandageTests::doCircularSequencesMatch(QByteArray s1, QByteArray s2)
 
 
 
+//This function draws an SVG file onto a white image of the given size.
+QImage BandageTests::renderSvg(QString filename, QSize size)
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    QSvgRenderer renderer(filename);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    renderer.render(&painter);
+    painter.end();
+    return image;
+}
+
+
+//This function draws the whole scene in one piece onto a white image of
+//the given size, as the exporters did before images were made in bands.
+QImage BandageTests::renderScene(QGraphicsScene * scene, QSize size)
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    scene->render(&painter);
+    painter.end();
+    return image;
+}
+
+
+//This function counts the pixels where any colour channel differs by more
+//than the tolerance.  The images must be the same size.
+int BandageTests::countDifferentPixels(const QImage & a, const QImage & b, int tolerance)
+{
+    int differentPixels = 0;
+    for (int y = 0; y < a.height(); ++y)
+    {
+        for (int x = 0; x < a.width(); ++x)
+        {
+            QRgb pixelA = a.pixel(x, y);
+            QRgb pixelB = b.pixel(x, y);
+            if (qAbs(qRed(pixelA) - qRed(pixelB)) > tolerance ||
+                    qAbs(qGreen(pixelA) - qGreen(pixelB)) > tolerance ||
+                    qAbs(qBlue(pixelA) - qBlue(pixelB)) > tolerance)
+                ++differentPixels;
+        }
+    }
+    return differentPixels;
+}
+
+
+//This function measures how well the OGDF layout's distances match the
+//graph's distances, using breadth-first searches from a sample of nodes.
+//The layout is scaled to best fit the graph distances first, so the result
+//is from 0 (a perfect fit) to 1 and layouts of any size can be compared.
+double BandageTests::getLayoutStress()
+{
+    const ogdf::Graph & graph = *g_assemblyGraph->m_ogdfGraph;
+    const ogdf::GraphAttributes & graphAttributes = *g_assemblyGraph->m_graphAttributes;
+
+    std::vector<ogdf::node> nodes;
+    ogdf::node v;
+    forall_nodes(v, graph)
+        nodes.push_back(v);
+    size_t sampleStep = std::max(size_t(1), nodes.size() / 50);
+
+    double sumRatio = 0.0;
+    double sumRatioSquared = 0.0;
+    long long pairCount = 0;
+    for (size_t i = 0; i < nodes.size(); i += sampleStep)
+    {
+        ogdf::NodeArray<int> hops(graph, -1);
+        std::deque<ogdf::node> queue;
+        hops[nodes[i]] = 0;
+        queue.push_back(nodes[i]);
+        while (!queue.empty())
+        {
+            ogdf::node node = queue.front();
+            queue.pop_front();
+            ogdf::adjEntry adj;
+            forall_adj(adj, node)
+            {
+                ogdf::node neighbour = adj->twinNode();
+                if (hops[neighbour] < 0)
+                {
+                    hops[neighbour] = hops[node] + 1;
+                    queue.push_back(neighbour);
+                }
+            }
+        }
+
+        forall_nodes(v, graph)
+        {
+            if (hops[v] <= 0)
+                continue;
+            double dx = graphAttributes.x(v) - graphAttributes.x(nodes[i]);
+            double dy = graphAttributes.y(v) - graphAttributes.y(nodes[i]);
+            double ratio = sqrt(dx * dx + dy * dy) / hops[v];
+            sumRatio += ratio;
+            sumRatioSquared += ratio * ratio;
+            ++pairCount;
+        }
+    }
+
+    if (pairCount == 0 || sumRatioSquared == 0.0)
+        return 0.0;
+    return 1.0 - (sumRatio * sumRatio) / (pairCount * sumRatioSquared);
+}
+
+
+
 QTEST_MAIN(BandageTests)
 #include "bandagetests.moc"
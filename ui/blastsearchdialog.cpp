@@ -248,7 +248,7 @@ void BlastSearchDialog::makeQueryRow(int row)
     ColourButton * colourButton = new ColourButton();
     colourButton->setColour(query->getColour());
     connect(colourButton, SIGNAL(colourChosen(QColor)), query, SLOT(setColour(QColor)));
-    connect(colourButton, SIGNAL(colourChosen(QColor)), this, SLOT(fillHitsTable()));
+    connect(colourButton, SIGNAL(colourChosen(QColor)), this, SLOT(queryColourChanged()));
 
     QWidget * showCheckBoxWidget = new QWidget;
     QCheckBox * showCheckBox = new QCheckBox();
@@ -1007,6 +1007,13 @@ void BlastSearchDialog::queryShownChanged()
 }
 
 
+void BlastSearchDialog::queryColourChanged()
+{
+    fillHitsTable();
+    emit blastChanged();
+}
+
+
 
 void BlastSearchDialog::showPathsDialog(BlastQuery * query)
 {
@@ -80,6 +80,7 @@ private slots:
     void queryCellChanged(int row, int column);
     void queryTableSelectionChanged();
     void queryShownChanged();
+    void queryColourChanged();
     void showPathsDialog(BlastQuery * query);
     void queryPathSelectionChangedSlot();
     void openFiltersDialog();
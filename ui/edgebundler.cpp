@@ -0,0 +1,253 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "edgebundler.h"
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QPainterPath>
+#include <QHash>
+#include <QLineF>
+#include <QtConcurrentRun>
+#include <math.h>
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../graph/graphicsitemedge.h"
+
+
+static EdgeBundleResult findBundlesJob(std::vector<EdgeBundleInput> edges, double distance, int generation)
+{
+    EdgeBundleResult result;
+    result.generation = generation;
+    result.bundles = EdgeBundler::findBundles(edges, distance);
+    return result;
+}
+
+
+static double getDistance(QPointF a, QPointF b)
+{
+    return QLineF(a, b).length();
+}
+
+
+//Edges are given the same direction (left to right), so an edge and one
+//drawn the other way between the same places can be bundled.
+static EdgeBundleInput getSameDirection(const EdgeBundleInput & edge)
+{
+    if (edge.end.x() > edge.start.x() || (edge.end.x() == edge.start.x() && edge.end.y() >= edge.start.y()))
+        return edge;
+    EdgeBundleInput reversed;
+    reversed.valid = edge.valid;
+    reversed.start = edge.end;
+    reversed.control1 = edge.control2;
+    reversed.control2 = edge.control1;
+    reversed.end = edge.start;
+    return reversed;
+}
+
+
+//Edges are parallel when their ends are within the distance of each other.
+//Their control points may be twice as far apart, as they are further from
+//the nodes.
+static bool areParallel(const EdgeBundleInput & a, const EdgeBundleInput & b, double distance)
+{
+    return getDistance(a.start, b.start) <= distance &&
+            getDistance(a.end, b.end) <= distance &&
+            getDistance(a.control1, b.control1) <= 2.0 * distance &&
+            getDistance(a.control2, b.control2) <= 2.0 * distance;
+}
+
+
+
+EdgeBundler::EdgeBundler(QObject * parent) :
+    QObject(parent), m_generation(0), m_upToDate(false), m_distance(0.0)
+{
+    m_watcher = new QFutureWatcher<EdgeBundleResult>(this);
+    connect(m_watcher, SIGNAL(finished()), this, SLOT(bundlingFinished()));
+}
+
+
+//This function is called when the scene's items are all deleted, so the
+//edges in the snapshot must not be used again.
+void EdgeBundler::clear()
+{
+    m_edges.clear();
+    invalidate();
+}
+
+
+void EdgeBundler::invalidate()
+{
+    ++m_generation;
+    m_upToDate = false;
+}
+
+
+bool EdgeBundler::isLowZoom(double zoom)
+{
+    return g_settings->averageNodeWidth * zoom < g_settings->lowDetailNodeWidth;
+}
+
+
+//This function starts finding the scene's bundles, unless they are up to
+//date or already being found.
+void EdgeBundler::update(QGraphicsScene * scene)
+{
+    if (m_distance != g_settings->averageNodeWidth)
+        m_upToDate = false;
+    if (m_upToDate || m_watcher->isRunning())
+        return;
+
+    m_edges.clear();
+    std::vector<EdgeBundleInput> edges;
+    QList<QGraphicsItem *> sceneItems = scene->items();
+    for (int i = 0; i < sceneItems.size(); ++i)
+    {
+        GraphicsItemEdge * edge = dynamic_cast<GraphicsItemEdge *>(sceneItems[i]);
+        if (edge == 0 || !edge->isVisible())
+            continue;
+
+        //Only edges made of one curve are bundled, not the special paths
+        //which loop back to the same node.
+        QPainterPath path = edge->path();
+        EdgeBundleInput input;
+        input.valid = (path.elementCount() == 4 && path.elementAt(1).isCurveTo());
+        if (input.valid)
+        {
+            input.start = path.elementAt(0);
+            input.control1 = path.elementAt(1);
+            input.control2 = path.elementAt(2);
+            input.end = path.elementAt(3);
+        }
+        m_edges.push_back(edge);
+        edges.push_back(input);
+    }
+
+    m_distance = g_settings->averageNodeWidth;
+    m_watcher->setFuture(QtConcurrent::run(findBundlesJob, edges, m_distance, m_generation));
+}
+
+
+//This function gives the bundles of two or more edges.  Each edge is
+//compared with the first edge of the bundles which start near it, found
+//on a grid of cells as wide as the distance.
+std::vector<EdgeBundle> EdgeBundler::findBundles(const std::vector<EdgeBundleInput> & edges,
+                                                 double distance)
+{
+    std::vector<EdgeBundle> bundles;
+    if (distance <= 0.0)
+        return bundles;
+
+    std::vector<EdgeBundleInput> firstEdges;
+    std::vector<std::vector<int> > bundleEdges;
+    QHash<qint64, std::vector<int> > bundlesByCell;
+
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        if (!edges[i].valid)
+            continue;
+        EdgeBundleInput edge = getSameDirection(edges[i]);
+        qint64 cellX = qint64(floor(edge.start.x() / distance));
+        qint64 cellY = qint64(floor(edge.start.y() / distance));
+
+        int found = -1;
+        for (qint64 y = cellY - 1; y <= cellY + 1 && found < 0; ++y)
+        {
+            for (qint64 x = cellX - 1; x <= cellX + 1 && found < 0; ++x)
+            {
+                QHash<qint64, std::vector<int> >::const_iterator cell = bundlesByCell.constFind(getGridCellKey(x, y));
+                if (cell == bundlesByCell.constEnd())
+                    continue;
+                for (size_t j = 0; j < cell.value().size(); ++j)
+                {
+                    if (areParallel(firstEdges[cell.value()[j]], edge, distance))
+                    {
+                        found = cell.value()[j];
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (found >= 0)
+            bundleEdges[found].push_back(int(i));
+        else
+        {
+            bundlesByCell[getGridCellKey(cellX, cellY)].push_back(int(firstEdges.size()));
+            firstEdges.push_back(edge);
+            bundleEdges.push_back(std::vector<int>(1, int(i)));
+        }
+    }
+
+    for (size_t i = 0; i < bundleEdges.size(); ++i)
+    {
+        if (bundleEdges[i].size() < 2)
+            continue;
+
+        EdgeBundle bundle;
+        bundle.edges = bundleEdges[i];
+        for (size_t j = 0; j < bundle.edges.size(); ++j)
+        {
+            EdgeBundleInput edge = getSameDirection(edges[bundle.edges[j]]);
+            bundle.start += edge.start;
+            bundle.control1 += edge.control1;
+            bundle.control2 += edge.control2;
+            bundle.end += edge.end;
+        }
+        double count = bundle.edges.size();
+        bundle.start /= count;
+        bundle.control1 /= count;
+        bundle.control2 /= count;
+        bundle.end /= count;
+        bundles.push_back(bundle);
+    }
+
+    return bundles;
+}
+
+
+void EdgeBundler::bundlingFinished()
+{
+    EdgeBundleResult result = m_watcher->result();
+
+    //Bundles found from an older snapshot are thrown away.  Redrawing the
+    //scene will start finding them again.
+    if (result.generation != m_generation)
+    {
+        emit bundlesChanged();
+        return;
+    }
+
+    for (size_t i = 0; i < m_edges.size(); ++i)
+        m_edges[i]->dissolveBundle();
+
+    for (size_t i = 0; i < result.bundles.size(); ++i)
+    {
+        const EdgeBundle & bundle = result.bundles[i];
+        QPainterPath path;
+        path.moveTo(bundle.start);
+        path.cubicTo(bundle.control1, bundle.control2, bundle.end);
+
+        std::vector<GraphicsItemEdge *> members;
+        for (size_t j = 0; j < bundle.edges.size(); ++j)
+            members.push_back(m_edges[bundle.edges[j]]);
+        members[0]->setBundle(path, members);
+    }
+
+    m_upToDate = true;
+    emit bundlesChanged();
+}
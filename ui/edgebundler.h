@@ -0,0 +1,96 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef EDGEBUNDLER_H
+#define EDGEBUNDLER_H
+
+#include <QObject>
+#include <QPointF>
+#include <QFutureWatcher>
+#include <vector>
+
+class QGraphicsScene;
+class GraphicsItemEdge;
+
+//EdgeBundler simplifies the edges of dense graphs when zoomed out (when an
+//average node would be drawn in low detail).  Edges which start and end
+//within a node width of each other and curve the same way are drawn as one
+//curve, the average of theirs, by the first edge in the bundle.  The other
+//edges in the bundle (and edges shorter than a pixel) then draw nothing.
+//
+//Bundles are found on the global thread pool from a snapshot of the edges'
+//curves, the first time the scene is drawn zoomed out after its edges
+//change.  Any change to an edge breaks up its bundle at once and makes the
+//bundles out of date, so bundles found from an older snapshot are thrown
+//away.
+
+struct EdgeBundleInput
+{
+    bool valid;
+    QPointF start;
+    QPointF control1;
+    QPointF control2;
+    QPointF end;
+};
+
+struct EdgeBundle
+{
+    std::vector<int> edges;
+    QPointF start;
+    QPointF control1;
+    QPointF control2;
+    QPointF end;
+};
+
+struct EdgeBundleResult
+{
+    int generation;
+    std::vector<EdgeBundle> bundles;
+};
+
+class EdgeBundler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EdgeBundler(QObject * parent = 0);
+
+    void clear();
+    void invalidate();
+    void update(QGraphicsScene * scene);
+    bool isUpToDate() const {return m_upToDate;}
+
+    static bool isLowZoom(double zoom);
+    static std::vector<EdgeBundle> findBundles(const std::vector<EdgeBundleInput> & edges,
+                                               double distance);
+
+signals:
+    void bundlesChanged();
+
+private:
+    int m_generation;
+    bool m_upToDate;
+    double m_distance;
+    std::vector<GraphicsItemEdge *> m_edges;
+    QFutureWatcher<EdgeBundleResult> * m_watcher;
+
+private slots:
+    void bundlingFinished();
+};
+
+#endif // EDGEBUNDLER_H
@@ -40,6 +40,7 @@
 #include <QProgressDialog>
 #include <QThread>
 #include "../program/graphlayoutworker.h"
+#include "../program/layoutcache.h"
 #include <QRegExp>
 #include <QMessageBox>
 #include <QInputDialog>
@@ -68,10 +69,12 @@
 #include "graph/barcodesetting.h"
 #include "changenodenamedialog.h"
 #include "changenodereaddepthdialog.h"
+#include "sceneimageexporter.h"
+#include "svgwriter.h"
 
 MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     QMainWindow(0),
-    ui(new Ui::MainWindow), m_layoutThread(0), m_imageFilter("PNG (*.png)"),
+    ui(new Ui::MainWindow), m_layoutThread(0), m_fmmm(0), m_fixedOgdfNodes(0), m_layoutCancelled(false), m_imageFilter("PNG (*.png)"),
     m_fileToLoadOnStartup(fileToLoadOnStartup), m_drawGraphAfterLoad(drawGraphAfterLoad),
     m_uiState(NO_GRAPH_LOADED), m_blastSearchDialog(0), m_alreadyShown(false)
 {
@@ -131,8 +134,11 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
 #endif
 
     connect(ui->drawGraphButton, SIGNAL(clicked()), this, SLOT(drawGraph()));
+    connect(ui->actionRedo_graph_layout, SIGNAL(triggered()), this, SLOT(redoGraphLayout()));
     connect(ui->actionLoad_graph, SIGNAL(triggered()), this, SLOT(loadGraph()));
     connect(ui->actionLoad_CSV, SIGNAL(triggered(bool)), this, SLOT(loadCSV()));
+    connect(ui->actionLoad_layout, SIGNAL(triggered(bool)), this, SLOT(loadLayout()));
+    connect(ui->actionSave_layout, SIGNAL(triggered(bool)), this, SLOT(saveLayout()));
     connect(ui->actionExit, SIGNAL(triggered()), this, SLOT(close()));
     connect(ui->graphScopeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(graphScopeChanged()));
     connect(ui->zoomSpinBox, SIGNAL(valueChanged(double)), this, SLOT(zoomSpinBoxChanged()));
@@ -223,10 +229,16 @@ void MainWindow::afterMainWindowShow()
         setupBlastQueryComboBox();
     }
 
-    //If the draw option was used and the graph appears to have loaded (i.e. there
-    //is at least one node), then draw the graph.
-    if (m_fileToLoadOnStartup != "" && m_drawGraphAfterLoad && g_assemblyGraph->m_deBruijnGraphNodes.size() > 0)
-        drawGraph();
+    //If a layout file was given, the graph is drawn from it.  Otherwise, if
+    //the draw option was used and the graph appears to have loaded (i.e.
+    //there is at least one node), then draw the graph.
+    if (m_fileToLoadOnStartup != "" && g_assemblyGraph->m_deBruijnGraphNodes.size() > 0)
+    {
+        if (g_settings->layoutFilename != "")
+            loadLayout(g_settings->layoutFilename);
+        else if (m_drawGraphAfterLoad)
+            drawGraph();
+    }
 
     m_alreadyShown = true;
 }
@@ -297,6 +309,12 @@ void MainWindow::loadCSV(QString fullFileName)
         ui->csvComboBox->clear();
         ui->csvComboBox->addItems(columns);
         g_settings->displayNodeCsvDataCol = 0;
+
+        if (g_settings->nodeColourScheme == CSV_COLOURS)
+        {
+            g_assemblyGraph->resetAllNodeColours();
+            g_graphicsView->invalidateTiles();
+        }
     }
 
     catch (...)
@@ -315,7 +333,7 @@ void MainWindow::loadGraph(QString fullFileName)
     QString selectedFilter = "Any supported graph (*)";
     if (fullFileName == "")
         fullFileName = QFileDialog::getOpenFileName(this, "Load graph", g_memory->rememberedPath,
-                                                    "Any supported graph (*);;LastGraph (*LastGraph*);;FASTG (*.fastg);;FASTG with barcodes(*.fastgbc);;GFA (*.gfa);;Trinity.fasta (*.fasta)",
+                                                    "Any supported graph (*);;LastGraph (*LastGraph*);;FASTG (*.fastg *.fastg.gz);;FASTG with barcodes(*.fastgbc);;GFA (*.gfa *.gfa.gz);;Trinity.fasta (*.fasta *.fasta.gz)",
                                                     &selectedFilter);
 
     if (fullFileName != "") //User did not hit cancel
@@ -327,11 +345,11 @@ void MainWindow::loadGraph(QString fullFileName)
             selectedFileType = LAST_GRAPH;
         else if (selectedFilter == "FASTGBC (*.fastgbc)")
             selectedFileType = FASTG_BC;
-        else if (selectedFilter == "FASTG (*.fastg)")
+        else if (selectedFilter == "FASTG (*.fastg *.fastg.gz)")
             selectedFileType = FASTG;
-        else if (selectedFilter == "GFA (*.gfa)")
+        else if (selectedFilter == "GFA (*.gfa *.gfa.gz)")
             selectedFileType = GFA;
-        else if (selectedFilter == "Trinity.fasta (*.fasta)")
+        else if (selectedFilter == "Trinity.fasta (*.fasta *.fasta.gz)")
             selectedFileType = TRINITY;
 
         if (selectedFileType == ANY_FILE_TYPE)
@@ -339,6 +357,7 @@ void MainWindow::loadGraph(QString fullFileName)
             //If the user chose any file type but it can't be determined, show an error and quit.
             if (detectedFileType == UNKNOWN_FILE_TYPE)
             {
+                g_assemblyGraph->clearSniffedFile();
                 QMessageBox::warning(this, "Graph format not recognised", "Cannot load file. The selected file's format was not recognised as any supported graph type.");
                 return;
             }
@@ -359,7 +378,10 @@ void MainWindow::loadGraph(QString fullFileName)
                                           "\nDo you want to load it as a " + graphFileTypeString + " file anyway?",
                                           QMessageBox::Yes|QMessageBox::No);
             if (reply == QMessageBox::No)
+            {
+                g_assemblyGraph->clearSniffedFile();
                 return;
+            }
         }
         //qDebug() << selectedFileType;
         loadGraph2(selectedFileType, fullFileName);
@@ -670,6 +692,26 @@ void MainWindow::setReadDepthRangeWidgetVisibility(bool visible)
 
 void MainWindow::drawGraph()
 {
+    drawGraph2(true);
+}
+
+
+//This function draws the graph with a fresh layout, ignoring any cached
+//layout and the positions of nodes that are already drawn.
+void MainWindow::redoGraphLayout()
+{
+    drawGraph2(false);
+}
+
+
+void MainWindow::drawGraph2(bool reuseLayout)
+{
+    //Positions of the nodes drawn now are kept, so that if they are drawn
+    //again only the new nodes need to be laid out.
+    QHash<QString, std::vector<double> > previousPositions;
+    if (reuseLayout && g_settings->incrementalLayout && m_uiState == GRAPH_DRAWN)
+        g_assemblyGraph->getOgdfNodePositionsByName(&previousPositions);
+
     QString errorTitle;
     QString errorMessage;
     std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
@@ -685,15 +727,44 @@ void MainWindow::drawGraph()
 
     resetScene();
     g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
-    layoutGraph();
+    layoutGraph(reuseLayout, previousPositions);
 }
 
 
 void MainWindow::graphLayoutFinished()
 {
+    //Only complete layouts are cached, not ones the user cut short.  An
+    //incremental layout depends on where the fixed nodes were drawn, which
+    //the cache key doesn't cover, so it isn't cached either.
+    bool cacheLayout = !m_layoutCancelled && m_fixedOgdfNodes == 0;
+
     delete m_fmmm;
+    m_fmmm = 0;
+    delete m_fixedOgdfNodes;
+    m_fixedOgdfNodes = 0;
     m_layoutThread = 0;
-    g_assemblyGraph->addGraphicsItemsToScene(m_scene);
+
+    if (cacheLayout)
+    {
+        std::vector<double> positions;
+        g_assemblyGraph->getOgdfNodePositions(&positions);
+        LayoutCache::saveLayout(m_layoutCacheKey, positions);
+    }
+
+    displayGraphLayout();
+}
+
+
+void MainWindow::graphLayoutCancelled()
+{
+    m_layoutCancelled = true;
+}
+
+
+void MainWindow::displayGraphLayout(const QHash<QString, std::vector<QPointF> > * linePoints)
+{
+    g_graphicsView->invalidateTiles();
+    g_assemblyGraph->addGraphicsItemsToScene(m_scene, linePoints);
     m_scene->setSceneRectangle();
     zoomToFitScene();
     selectionChanged();
@@ -705,14 +776,6 @@ void MainWindow::graphLayoutFinished()
 }
 
 
-void MainWindow::graphLayoutCancelled()
-{
-    m_fmmm->fixedIterations(0);
-    m_fmmm->fineTuningIterations(0);
-    m_fmmm->threshold(std::numeric_limits<double>::max());
-}
-
-
 void MainWindow::resetScene()
 {
     m_scene->blockSignals(true);
@@ -740,8 +803,45 @@ std::vector<DeBruijnNode *> MainWindow::getNodesFromLineEdit(QLineEdit * lineEdi
 
 
 
-void MainWindow::layoutGraph()
+void MainWindow::layoutGraph(bool reuseLayout, const QHash<QString, std::vector<double> > & previousPositions)
 {
+    m_layoutCancelled = false;
+    m_layoutCacheKey = g_assemblyGraph->getLayoutCacheKey();
+
+    //If this graph has been laid out before with the same settings, the
+    //cached positions are used instead of doing the layout again.
+    if (reuseLayout)
+    {
+        std::vector<double> positions;
+        if (LayoutCache::loadLayout(m_layoutCacheKey, &positions) &&
+                g_assemblyGraph->setOgdfNodePositions(positions))
+        {
+            displayGraphLayout();
+            return;
+        }
+    }
+
+    //Nodes that were already drawn go back where they were, and if that
+    //covers every node there's nothing left to lay out.
+    ogdf::NodeArray<bool> * fixedNodes = 0;
+    if (!previousPositions.isEmpty())
+    {
+        fixedNodes = new ogdf::NodeArray<bool>(*g_assemblyGraph->m_ogdfGraph, false);
+        int fixedCount = g_assemblyGraph->setOgdfNodePositionsByName(previousPositions, fixedNodes);
+        if (fixedCount == g_assemblyGraph->m_ogdfGraph->numberOfNodes())
+        {
+            delete fixedNodes;
+            displayGraphLayout();
+            return;
+        }
+        if (fixedCount == 0)
+        {
+            delete fixedNodes;
+            fixedNodes = 0;
+        }
+    }
+    m_fixedOgdfNodes = fixedNodes;
+
     //The actual layout is done in a different thread so the UI will stay responsive.
     MyProgressDialog * progress = new MyProgressDialog(this, "Laying out graph...", true, "Cancel layout", "Cancelling layout...",
                                                        "Clicking this button will halt the graph layout and display "
@@ -761,10 +861,18 @@ void MainWindow::layoutGraph()
 
     m_layoutThread = new QThread;
     GraphLayoutWorker * graphLayoutWorker = new GraphLayoutWorker(m_fmmm, g_assemblyGraph->m_graphAttributes,
-                                                                  g_settings->graphLayoutQuality, g_settings->segmentLength);
+                                                                  g_assemblyGraph->m_ogdfEdgeLengths,
+                                                                  g_settings->graphLayoutQuality, g_settings->segmentLength,
+                                                                  g_settings->componentLayout, g_settings->coarsenChains,
+                                                                  g_settings->layoutSeed, g_settings->layoutAlgorithm);
+    graphLayoutWorker->m_fixedNodes = m_fixedOgdfNodes;
     graphLayoutWorker->moveToThread(m_layoutThread);
 
+    //The worker's thread is busy laying out, so cancelling is done directly.
+    connect(progress, SIGNAL(halt()), graphLayoutWorker, SLOT(cancelLayout()), Qt::DirectConnection);
     connect(progress, SIGNAL(halt()), this, SLOT(graphLayoutCancelled()));
+    connect(graphLayoutWorker, SIGNAL(setLayoutTotalCount(int)), progress, SLOT(setMaxValue(int)));
+    connect(graphLayoutWorker, SIGNAL(setLayoutCompletedCount(int)), progress, SLOT(setValue(int)));
     connect(m_layoutThread, SIGNAL(started()), graphLayoutWorker, SLOT(layoutGraph()));
     connect(graphLayoutWorker, SIGNAL(finishedLayout()), m_layoutThread, SLOT(quit()));
     connect(graphLayoutWorker, SIGNAL(finishedLayout()), graphLayoutWorker, SLOT(deleteLater()));
@@ -1036,11 +1144,16 @@ void MainWindow::switchColourScheme()
         ui->contiguityButton->setVisible(false);
         ui->contiguityInfoText->setVisible(false);
         break;
+    case 8:
+        g_settings->nodeColourScheme = CSV_COLOURS;
+        ui->contiguityButton->setVisible(false);
+        ui->contiguityInfoText->setVisible(false);
+        break;
 
     }
 
     g_assemblyGraph->resetAllNodeColours();
-    g_graphicsView->viewport()->update();
+    g_graphicsView->invalidateTiles();
 }
 
 
@@ -1061,7 +1174,7 @@ void MainWindow::determineContiguityFromSelectedNode()
 
         g_assemblyGraph->m_contiguitySearchDone = true;
         g_assemblyGraph->resetAllNodeColours();
-        g_graphicsView->viewport()->update();
+        g_graphicsView->invalidateTiles();
     }
     else
         QMessageBox::information(this, "No nodes selected", "Please select one or more nodes for which "
@@ -1109,6 +1222,11 @@ void MainWindow::saveImageCurrentView()
     {
         m_imageFilter = selectedFilter;
 
+        //Items drawn from tiles must be given back their contents so they
+        //appear in the image.
+        g_graphicsView->invalidateTiles();
+        g_memory->fullDetailPainting = true;
+
         QPainter painter;
         if (pixelImage)
         {
@@ -1136,6 +1254,7 @@ void MainWindow::saveImageCurrentView()
             g_graphicsView->render(&painter);
             painter.end();
         }
+        g_memory->fullDetailPainting = false;
     }
 }
 
@@ -1177,12 +1296,15 @@ void MainWindow::saveImageEntireScene()
         {
             QSize imageSize = g_absoluteZoom * m_scene->sceneRect().size().toSize();
 
-            if (imageSize.width() > 32767 || imageSize.height() > 32767)
+            //PNG images are saved in bands, so only JPEG images are limited to
+            //the largest size of a QImage.
+            bool png = (selectedFilter == "PNG (*.png)");
+            if (!png && (imageSize.width() > 32767 || imageSize.height() > 32767))
             {
                 QString error = "Images can not be taller or wider than 32767 pixels, but at the "
                                 "current zoom level, the image to be saved would be ";
                 error += QString::number(imageSize.width()) + "x" + QString::number(imageSize.height()) + " pixels.\n\n";
-                error += "Please reduce the zoom level before saving the entire scene to image or use the SVG format.";
+                error += "Please reduce the zoom level before saving the entire scene to image or use the PNG or SVG format.";
 
                 QMessageBox::information(this, "Image too large", error);
                 return;
@@ -1200,33 +1322,65 @@ void MainWindow::saveImageEntireScene()
                     return;
             }
 
-            QImage image(imageSize, QImage::Format_ARGB32);
-            image.fill(Qt::white);
-            painter.begin(&image);
-            painter.setRenderHint(QPainter::Antialiasing);
-            painter.setRenderHint(QPainter::TextAntialiasing);
+            //Items drawn from tiles must be given back their contents so
+            //they appear in the image.
+            g_graphicsView->invalidateTiles();
             m_scene->setSceneRectangle();
-            m_scene->render(&painter);
-            image.save(fullFileName);
+            g_memory->fullDetailPainting = true;
+
+            if (png)
+            {
+                QApplication::setOverrideCursor(Qt::WaitCursor);
+                QString error;
+                bool saved = SceneImageExporter::savePng(m_scene, fullFileName, imageSize, &error);
+                QApplication::restoreOverrideCursor();
+                if (!saved)
+                    QMessageBox::warning(this, "Error saving image", "There was an error writing the image to file:\n" + error);
+            }
+            else
+            {
+                QImage image(imageSize, QImage::Format_ARGB32);
+                image.fill(Qt::white);
+                painter.begin(&image);
+                painter.setRenderHint(QPainter::Antialiasing);
+                painter.setRenderHint(QPainter::TextAntialiasing);
+                m_scene->render(&painter);
+                image.save(fullFileName);
+                painter.end();
+            }
             g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-            painter.end();
         }
         else //SVG
         {
-            QSvgGenerator generator;
-            generator.setFileName(fullFileName);
-            QSize size = g_absoluteZoom * m_scene->sceneRect().size().toSize();
-            generator.setSize(size);
-            generator.setViewBox(QRect(0, 0, size.width(), size.height()));
-            painter.begin(&generator);
-            painter.fillRect(0, 0, size.width(), size.height(), Qt::white);
-            painter.setRenderHint(QPainter::Antialiasing);
-            painter.setRenderHint(QPainter::TextAntialiasing);
+            g_graphicsView->invalidateTiles();
             m_scene->setSceneRectangle();
-            m_scene->render(&painter);
-            painter.end();
+            g_memory->fullDetailPainting = true;
+            QSize size = g_absoluteZoom * m_scene->sceneRect().size().toSize();
+
+            //Path highlighting is only drawn by the items themselves, so
+            //while it is shown the image is made from their paint functions.
+            if (g_memory->pathDialogIsVisible || g_memory->queryPathDialogIsVisible)
+            {
+                QSvgGenerator generator;
+                generator.setFileName(fullFileName);
+                generator.setSize(size);
+                generator.setViewBox(QRect(0, 0, size.width(), size.height()));
+                painter.begin(&generator);
+                painter.fillRect(0, 0, size.width(), size.height(), Qt::white);
+                painter.setRenderHint(QPainter::Antialiasing);
+                painter.setRenderHint(QPainter::TextAntialiasing);
+                m_scene->render(&painter);
+                painter.end();
+            }
+            else
+            {
+                SvgWriter writer(fullFileName);
+                if (!writer.writeScene(m_scene, size))
+                    QMessageBox::warning(this, "Error saving image", "There was an error writing the image to file:\n" + writer.errorString());
+            }
         }
 
+        g_memory->fullDetailPainting = false;
         g_settings->positionTextNodeCentre = positionTextNodeCentreSettingBefore;
         g_graphicsView->setRotation(rotationBefore);
     }
@@ -1261,10 +1415,17 @@ void MainWindow::setTextDisplaySettings()
     g_settings->displayNodeReadDepth = ui->nodeReadDepthCheckBox->isChecked();
     g_settings->displayBlastHits = ui->blastHitsCheckBox->isChecked();
     g_settings->displayNodeCsvData = ui->csvCheckBox->isChecked();
-    g_settings->displayNodeCsvDataCol = ui->csvComboBox->currentIndex();
     g_settings->textOutline = ui->textOutlineCheckBox->isChecked();
 
-    g_graphicsView->viewport()->update();
+    //The CSV colour scheme colours by the selected CSV column, so the node
+    //colours need updating if that column changes.
+    int csvColumn = ui->csvComboBox->currentIndex();
+    bool csvColumnChanged = (csvColumn != g_settings->displayNodeCsvDataCol);
+    g_settings->displayNodeCsvDataCol = csvColumn;
+    if (csvColumnChanged && g_settings->nodeColourScheme == CSV_COLOURS)
+        g_assemblyGraph->resetAllNodeColours();
+
+    g_graphicsView->invalidateTiles();
 }
 
 
@@ -1273,7 +1434,7 @@ void MainWindow::fontButtonPressed()
     bool ok;
     g_settings->labelFont = QFontDialog::getFont(&ok, g_settings->labelFont, this);
     if (ok)
-        g_graphicsView->viewport()->update();
+        g_graphicsView->invalidateTiles();
 }
 
 
@@ -1302,7 +1463,7 @@ void MainWindow::setNodeCustomColour()
                 selectedNodes[i]->getGraphicsItemNode()->setNodeColour();
 
         }
-        g_graphicsView->viewport()->update();
+        g_graphicsView->invalidateTiles();
     }
 }
 
@@ -1346,12 +1507,18 @@ void MainWindow::openSettingsDialog()
 
         settingsDialog.setSettingsFromWidgets();
 
-        //If the settings affecting node width was changed, reset the width on
-        //each GraphicsItemNode.
+        //If the settings affecting node width (or the outline thickness, which
+        //is part of each node's bounding rectangle) were changed, reset the
+        //width on each GraphicsItemNode.
         if (settingsBefore.readDepthEffectOnWidth != g_settings->readDepthEffectOnWidth ||
-                settingsBefore.readDepthPower != g_settings->readDepthPower)
+                settingsBefore.readDepthPower != g_settings->readDepthPower ||
+                settingsBefore.outlineThickness != g_settings->outlineThickness)
             g_assemblyGraph->recalculateAllNodeWidths();
 
+        //Likewise, edge bounding rectangles include the edge width.
+        if (settingsBefore.edgeWidth != g_settings->edgeWidth)
+            g_assemblyGraph->updateAllEdgeGeometry();
+
         //If any of the colours changed, reset the node colours now.
         if (settingsBefore.uniformPositiveNodeColour != g_settings->uniformPositiveNodeColour ||
                 settingsBefore.uniformNegativeNodeColour != g_settings->uniformNegativeNodeColour ||
@@ -1378,7 +1545,7 @@ void MainWindow::openSettingsDialog()
         }
 
         g_graphicsView->setAntialiasing(g_settings->antialiasing);
-        g_graphicsView->viewport()->update();
+        g_graphicsView->invalidateTiles();
     }
 }
 
@@ -1647,7 +1814,7 @@ void MainWindow::blastChanged()
     }
 
     g_blastSearch->blastQueryChanged(ui->blastQueryComboBox->currentText());
-    g_graphicsView->viewport()->update();
+    g_graphicsView->invalidateTiles();
 }
 
 
@@ -1680,7 +1847,7 @@ void MainWindow::setupBlastQueryComboBox()
 void MainWindow::blastQueryChanged()
 {
     g_blastSearch->blastQueryChanged(ui->blastQueryComboBox->currentText());
-    g_graphicsView->viewport()->update();
+    g_graphicsView->invalidateTiles();
 }
 
 
@@ -1811,6 +1978,63 @@ void MainWindow::setInfoTexts()
 
 
 
+//This function draws the graph from a layout file, so no layout is needed.
+//The nodes in the file are drawn, whatever the graph scope is.
+void MainWindow::loadLayout(QString fullFileName)
+{
+    if (m_uiState == NO_GRAPH_LOADED)
+        return;
+
+    QString selectedFilter = "Bandage layout (*.layout)";
+    if (fullFileName == "")
+    {
+        fullFileName = QFileDialog::getOpenFileName(this, "Load layout", g_memory->rememberedPath,
+                                                    "Bandage layout (*.layout);;All files (*)",
+                                                    &selectedFilter);
+    }
+
+    if (fullFileName == "")
+        return; // user clicked on cancel
+
+    QHash<QString, std::vector<QPointF> > linePoints;
+    bool doubleMode;
+    QString errormsg;
+    if (!g_assemblyGraph->loadLayout(fullFileName, &linePoints, &doubleMode, &errormsg))
+    {
+        QMessageBox::warning(this, "Error loading layout",
+                             "There was an error when attempting to load:\n" + fullFileName + "\n\n" + errormsg);
+        return;
+    }
+    g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
+
+    ui->singleNodesRadioButton->setChecked(!doubleMode);
+    ui->doubleNodesRadioButton->setChecked(doubleMode);
+
+    resetScene();
+    g_assemblyGraph->buildOgdfGraphFromLayout(linePoints, doubleMode);
+    displayGraphLayout(&linePoints);
+}
+
+
+void MainWindow::saveLayout()
+{
+    QString defaultFileNameAndPath = g_memory->rememberedPath + "/layout.layout";
+    QString fullFileName = QFileDialog::getSaveFileName(this, "Save layout", defaultFileNameAndPath,
+                                                        "Bandage layout (*.layout)");
+
+    if (fullFileName == "")
+        return; // user clicked on cancel
+
+    if (!g_assemblyGraph->saveLayout(fullFileName))
+    {
+        QMessageBox::warning(this, "Error saving layout",
+                             "There was an error when attempting to save:\n" + fullFileName);
+        return;
+    }
+    g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
+}
+
+
 void MainWindow::setUiState(UiState uiState)
 {
     m_uiState = uiState;
@@ -1825,6 +2049,9 @@ void MainWindow::setUiState(UiState uiState)
         ui->blastSearchWidget->setEnabled(false);
         ui->selectionScrollAreaWidgetContents->setEnabled(false);
         ui->actionLoad_CSV->setEnabled(false);
+        ui->actionLoad_layout->setEnabled(false);
+        ui->actionSave_layout->setEnabled(false);
+        ui->actionRedo_graph_layout->setEnabled(false);
         break;
     case GRAPH_LOADED:
         ui->graphDetailsWidget->setEnabled(true);
@@ -1834,6 +2061,9 @@ void MainWindow::setUiState(UiState uiState)
         ui->blastSearchWidget->setEnabled(true);
         ui->selectionScrollAreaWidgetContents->setEnabled(false);
         ui->actionLoad_CSV->setEnabled(true);
+        ui->actionLoad_layout->setEnabled(true);
+        ui->actionSave_layout->setEnabled(false);
+        ui->actionRedo_graph_layout->setEnabled(true);
         break;
     case GRAPH_DRAWN:
         ui->graphDetailsWidget->setEnabled(true);
@@ -1844,6 +2074,9 @@ void MainWindow::setUiState(UiState uiState)
         ui->selectionScrollAreaWidgetContents->setEnabled(true);
         ui->actionZoom_to_selection->setEnabled(true);
         ui->actionLoad_CSV->setEnabled(true);
+        ui->actionLoad_layout->setEnabled(true);
+        ui->actionSave_layout->setEnabled(true);
+        ui->actionRedo_graph_layout->setEnabled(true);
         break;
     }
 }
@@ -1881,7 +2114,7 @@ void MainWindow::bringSelectedNodesToFront()
         graphicsItemNode->setZValue(newZ);
     }
     m_scene->blockSignals(false);
-    g_graphicsView->viewport()->update();
+    g_graphicsView->invalidateTiles();
 }
 
 
@@ -2137,6 +2370,8 @@ void MainWindow::setNodeColourSchemeComboBox(NodeColourScheme nodeColourScheme)
     case BLAST_HITS_RAINBOW_COLOUR: ui->coloursComboBox->setCurrentIndex(4); break;
     case CONTIGUITY_COLOUR: ui->coloursComboBox->setCurrentIndex(5); break;
     case CUSTOM_COLOURS: ui->coloursComboBox->setCurrentIndex(6); break;
+    case BARCODE_COLOR: ui->coloursComboBox->setCurrentIndex(7); break;
+    case CSV_COLOURS: ui->coloursComboBox->setCurrentIndex(8); break;
     }
 }
 
@@ -2183,6 +2418,7 @@ void MainWindow::openPathSpecifyDialog()
 
     PathSpecifyDialog * pathSpecifyDialog = new PathSpecifyDialog(this);
     connect(g_graphicsView, SIGNAL(doubleClickedNode(DeBruijnNode*)), pathSpecifyDialog, SLOT(addNodeName(DeBruijnNode*)));
+    connect(pathSpecifyDialog, SIGNAL(destroyed()), g_graphicsView, SLOT(invalidateTiles()));
     pathSpecifyDialog->show();
 }
 
@@ -2228,7 +2464,7 @@ void MainWindow::nodeWidthChanged()
 {
     g_settings->averageNodeWidth = ui->nodeWidthSpinBox->value();
     g_assemblyGraph->recalculateAllNodeWidths();
-    g_graphicsView->viewport()->update();
+    g_graphicsView->invalidateTiles();
 }
 
 
@@ -2439,7 +2675,7 @@ void MainWindow::refreshDisplay(){
 
 
     m_scene->blockSignals(false);
-    g_graphicsView->viewport()->update();
+    g_graphicsView->invalidateTiles();
 
 }
 
@@ -2551,6 +2787,7 @@ QByteArray MainWindow::makeStringUrlSafe(QByteArray s)
 //actual graph.
 void MainWindow::hideNodes()
 {
+    g_graphicsView->invalidateTiles();
     std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
     g_assemblyGraph->removeGraphicsItemNodes(&selectedNodes, !g_settings->doubleMode, m_scene);
 }
@@ -2559,6 +2796,7 @@ void MainWindow::hideNodes()
 //This function removes selected nodes/edges from the graph.
 void MainWindow::removeSelection()
 {
+    g_graphicsView->invalidateTiles();
     std::vector<DeBruijnEdge *> selectedEdges = m_scene->getSelectedEdges();
     std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
 
@@ -2600,6 +2838,7 @@ void MainWindow::duplicateSelectedNodes()
             nodesToDuplicate.push_back(node);
     }
 
+    g_graphicsView->invalidateTiles();
     for (int i = 0; i < nodesToDuplicate.size(); ++i)
         g_assemblyGraph->duplicateNodePair(nodesToDuplicate[i], m_scene);
 
@@ -2640,6 +2879,7 @@ void MainWindow::mergeSelectedNodes()
         return;
     }
 
+    g_graphicsView->invalidateTiles();
     bool success = g_assemblyGraph->mergeNodes(nodesToMerge, m_scene, true);
 
     if (!success)
@@ -2673,6 +2913,7 @@ void MainWindow::mergeAllPossible()
         connect(g_assemblyGraph.data(), SIGNAL(setMergeCompletedCount(int)), &progress, SLOT(setValue(int)));
 
 
+        g_graphicsView->invalidateTiles();
         g_graphicsView->viewport()->setUpdatesEnabled(false);
         merges = g_assemblyGraph->mergeAllPossible(m_scene, &progress);
         g_graphicsView->viewport()->setUpdatesEnabled(true);
@@ -2749,6 +2990,6 @@ void MainWindow::changeNodeReadDepth()
         selectionChanged();
         g_assemblyGraph->recalculateAllReadDepthsRelativeToDrawnMean();
         g_assemblyGraph->recalculateAllNodeWidths();
-        g_graphicsView->viewport()->update();
+        g_graphicsView->invalidateTiles();
     }
 }
@@ -22,6 +22,7 @@
 #include <QMainWindow>
 #include <QGraphicsScene>
 #include <QMap>
+#include <QHash>
 #include <QString>
 #include <vector>
 #include <QLineEdit>
@@ -58,6 +59,9 @@ private:
     double m_previousZoomSpinBoxValue;
     QThread * m_layoutThread;
     ogdf::FMMMLayout * m_fmmm;
+    ogdf::NodeArray<bool> * m_fixedOgdfNodes;
+    QString m_layoutCacheKey;
+    bool m_layoutCancelled;
     QString m_imageFilter;
     QString m_fileToLoadOnStartup;
     bool m_drawGraphAfterLoad;
@@ -69,7 +73,9 @@ private:
     void displayGraphDetails();
     void clearGraphDetails();
     void resetScene();
-    void layoutGraph();
+    void drawGraph2(bool reuseLayout);
+    void layoutGraph(bool reuseLayout, const QHash<QString, std::vector<double> > & previousPositions);
+    void displayGraphLayout(const QHash<QString, std::vector<QPointF> > * linePoints = 0);
     void addGraphicsItemsToScene();
     void zoomToFitRect(QRectF rect);
     void zoomToFitScene();
@@ -105,9 +111,12 @@ private:
 private slots:
     void loadGraph(QString fullFileName = "");
     void loadCSV(QString fullFileNAme = "");
+    void loadLayout(QString fullFileName = "");
+    void saveLayout();
     void selectionChanged();
     void graphScopeChanged();
     void drawGraph();
+    void redoGraphLayout();
     void zoomSpinBoxChanged();
     void zoomedWithMouseWheel();
     void copySelectedSequencesToClipboardActionTriggered();
@@ -130,11 +139,11 @@ private slots:
     void selectUserSpecifiedNodes();
     void selectUserSpecifiedBarcodes();
     void graphLayoutFinished();
+    void graphLayoutCancelled();
     void openBlastSearchDialog();
     void blastChanged();
     void blastQueryChanged();
     void showHidePanels();
-    void graphLayoutCancelled();
     void bringSelectedNodesToFront();
     void selectNodesWithBlastHits();
     void selectAll();
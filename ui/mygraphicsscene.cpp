@@ -21,11 +21,19 @@
 #include "../graph/debruijnedge.h"
 #include "../graph/graphicsitemnode.h"
 #include "../graph/graphicsitemedge.h"
+#include "../graph/labelcache.h"
+#include <QSet>
+#include <QStyleOptionGraphicsItem>
 #include "../graph/debruijnnode.h"
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "edgebundler.h"
 
 MyGraphicsScene::MyGraphicsScene(QObject *parent) :
     QGraphicsScene(parent)
 {
+    m_edgeBundler = new EdgeBundler(this);
+    connect(m_edgeBundler, SIGNAL(bundlesChanged()), this, SLOT(update()));
 }
 
 
@@ -251,3 +259,100 @@ void MyGraphicsScene::possiblyExpandSceneRectangle(std::vector<GraphicsItemNode
         setSceneRect(newSceneRect);
 }
 
+
+
+//Clearing the scene deletes its items without telling them, so the index
+//has to be thrown away here.
+void MyGraphicsScene::clear()
+{
+    m_index.clear();
+    m_edgeBundler->clear();
+    QGraphicsScene::clear();
+}
+
+
+void MyGraphicsScene::invalidateEdgeBundles()
+{
+    m_edgeBundler->invalidate();
+}
+
+
+//The index is built when it is first needed after the scene changes.
+const SceneIndex * MyGraphicsScene::getIndex()
+{
+    if (!m_index.isUpToDate())
+        m_index.build(this);
+    return &m_index;
+}
+
+
+QGraphicsItem * MyGraphicsScene::getIndexedItemAt(QPointF point)
+{
+    return getIndex()->getItemAt(point);
+}
+
+
+//This function replaces the selection with the selectable items touching
+//the area, as a rubber band selection does.
+void MyGraphicsScene::selectItemsInArea(const QPolygonF & area)
+{
+    std::vector<QGraphicsItem *> itemsInArea = getIndex()->getItemsInArea(area);
+    std::vector<QGraphicsItem *> selectableItems;
+    for (size_t i = 0; i < itemsInArea.size(); ++i)
+    {
+        if (itemsInArea[i]->flags() & QGraphicsItem::ItemIsSelectable)
+            selectableItems.push_back(itemsInArea[i]);
+    }
+    setSelectedItems(selectableItems);
+}
+
+
+//This function makes the given items the selection.  Selecting items one
+//at a time would emit selectionChanged for each of them, so the signal is
+//held back and emitted once at the end, if anything changed.
+void MyGraphicsScene::setSelectedItems(const std::vector<QGraphicsItem *> & items)
+{
+    QSet<QGraphicsItem *> newSelection;
+    for (size_t i = 0; i < items.size(); ++i)
+        newSelection.insert(items[i]);
+
+    bool changed = false;
+    bool signalsWereBlocked = blockSignals(true);
+    QList<QGraphicsItem *> oldSelection = selectedItems();
+    for (int i = 0; i < oldSelection.size(); ++i)
+    {
+        if (!newSelection.contains(oldSelection[i]))
+        {
+            oldSelection[i]->setSelected(false);
+            changed = true;
+        }
+    }
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (!items[i]->isSelected())
+        {
+            items[i]->setSelected(true);
+            changed = true;
+        }
+    }
+    blockSignals(signalsWereBlocked);
+
+    if (changed)
+        emit selectionChanged();
+}
+
+
+//The background is drawn at the start of every paint of the scene, whether
+//to the screen or to an image, so this is where the labels drawn in the
+//previous paint are forgotten.  It is also where edge bundles are found, if
+//they are needed at this zoom and out of date.
+void MyGraphicsScene::drawBackground(QPainter * painter, const QRectF & rect)
+{
+    LabelCache::clearUsedAreas();
+
+    double zoom = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (g_settings->edgeBundling && EdgeBundler::isLowZoom(zoom))
+        m_edgeBundler->update(this);
+
+    QGraphicsScene::drawBackground(painter, rect);
+}
@@ -20,9 +20,12 @@
 #define MYGRAPHICSSCENE_H
 
 #include <QGraphicsScene>
+#include <QPolygonF>
 #include <vector>
+#include "sceneindex.h"
 
 class DeBruijnNode;
+class EdgeBundler;
 class DeBruijnEdge;
 class GraphicsItemNode;
 
@@ -42,6 +45,21 @@ public:
     void setSceneRectangle();
     void possiblyExpandSceneRectangle(std::vector<GraphicsItemNode *> * movedNodes);
 
+    void clear();
+    void invalidateIndex() {m_index.clear();}
+    void invalidateEdgeBundles();
+    const SceneIndex * getIndex();
+    QGraphicsItem * getIndexedItemAt(QPointF point);
+    void selectItemsInArea(const QPolygonF & area);
+    void setSelectedItems(const std::vector<QGraphicsItem *> & items);
+
+protected:
+    void drawBackground(QPainter * painter, const QRectF & rect);
+
+private:
+    SceneIndex m_index;
+    EdgeBundler * m_edgeBundler;
+
 };
 
 #endif // MYGRAPHICSSCENE_H
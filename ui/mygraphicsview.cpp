@@ -26,17 +26,29 @@
 #include <QMessageBox>
 #include <math.h>
 #include "../graph/graphicsitemnode.h"
+#include "tilerenderer.h"
+#include "mygraphicsscene.h"
+#include <QRubberBand>
+#include <QStyleOptionGraphicsItem>
 
 MyGraphicsView::MyGraphicsView(QObject * /*parent*/) :
-    QGraphicsView(), m_rotation(0.0)
+    QGraphicsView(), m_rotation(0.0), m_rubberBanding(false)
 {
     setDragMode(QGraphicsView::RubberBandDrag);
     setAntialiasing(g_settings->antialiasing);
-    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    updateViewportUpdateMode();
+
+    m_tileRenderer = new TileRenderer(this);
+    connect(m_tileRenderer, SIGNAL(tilesChanged(QRectF)), this, SLOT(tilesChanged(QRectF)));
+
+    m_rubberBand = new QRubberBand(QRubberBand::Rectangle, viewport());
 }
 
 
 
+//Rubber band selection is done here, rather than by QGraphicsView, so the
+//items under the band can be found with the scene's index instead of by
+//testing their full shapes.
 void MyGraphicsView::mousePressEvent(QMouseEvent * event)
 {
     if (event->modifiers() == Qt::CTRL)
@@ -46,12 +58,30 @@ void MyGraphicsView::mousePressEvent(QMouseEvent * event)
 
     m_previousPos = event->pos();
 
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (isInteractive() && dragMode() == QGraphicsView::RubberBandDrag && event->button() == Qt::LeftButton &&
+            graphicsScene != 0 && graphicsScene->getIndexedItemAt(mapToScene(event->pos())) == 0)
+    {
+        graphicsScene->setSelectedItems(std::vector<QGraphicsItem *>());
+        m_rubberBanding = true;
+        m_rubberBandOrigin = event->pos();
+        m_rubberBand->setGeometry(QRect(m_rubberBandOrigin, QSize()));
+        m_rubberBand->show();
+        return;
+    }
+
     QGraphicsView::mousePressEvent(event);
 }
 
 void MyGraphicsView::mouseReleaseEvent(QMouseEvent * event)
 {
-    QGraphicsView::mouseReleaseEvent(event);
+    if (m_rubberBanding)
+    {
+        m_rubberBand->hide();
+        m_rubberBanding = false;
+    }
+    else
+        QGraphicsView::mouseReleaseEvent(event);
     setDragMode(QGraphicsView::RubberBandDrag);
     g_settings->nodeDragging = NEARBY_PIECES;
 }
@@ -73,21 +103,99 @@ void MyGraphicsView::mouseMoveEvent(QMouseEvent * event)
 
         m_previousPos = event->pos();
     }
+    else if (m_rubberBanding)
+        updateRubberBand(event->pos());
     else
         QGraphicsView::mouseMoveEvent(event);
 }
 
 
+//The rubber band is a rectangle on screen, but it may be rotated in the
+//scene, so the items are found with its scene polygon.
+void MyGraphicsView::updateRubberBand(QPoint pos)
+{
+    QRect rubberBandRect = QRect(m_rubberBandOrigin, pos).normalized();
+    m_rubberBand->setGeometry(rubberBandRect);
+
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+        graphicsScene->selectItemsInArea(mapToScene(rubberBandRect));
+}
+
+
 void MyGraphicsView::mouseDoubleClickEvent(QMouseEvent * event)
 {
     //Find the node beneath the cursor.
-    QGraphicsItem * item = itemAt(event->pos());
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene == 0)
+        return;
+    QGraphicsItem * item = graphicsScene->getIndexedItemAt(mapToScene(event->pos()));
 
     GraphicsItemNode * graphicsItemNode = dynamic_cast<GraphicsItemNode *>(item);
     if (graphicsItemNode != 0)
         emit doubleClickedNode(graphicsItemNode->m_deBruijnNode);
 }
 
+//Large scenes are drawn from prerendered tiles underneath the live items.
+//This is only done on screen: when the view is rendered to an image, the
+//background is drawn as usual.
+void MyGraphicsView::drawBackground(QPainter * painter, const QRectF & rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+    if (scene() == 0 || painter->device() != viewport())
+        return;
+
+    updateViewportUpdateMode();
+
+    if (!m_tileRenderer->isUpToDate(scene()))
+        m_tileRenderer->takeSnapshot(scene());
+    double zoom = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    m_tileRenderer->drawTiles(painter, rect, zoom);
+}
+
+
+//This function must be called whenever the scene's items are changed,
+//added or removed (other than by selecting or dragging them), and before
+//the scene is rendered anywhere other than the screen.  The tiles are made
+//again from the items the next time the view is drawn, as are the nodes'
+//cached BLAST hit and barcode paths.
+void MyGraphicsView::invalidateTiles()
+{
+    m_tileRenderer->clear();
+    GraphicsItemNode::invalidateAllColouredPartPaths();
+    viewport()->update();
+}
+
+
+void MyGraphicsView::tilesChanged(const QRectF & sceneRect)
+{
+    updateScene(QList<QRectF>() << sceneRect);
+}
+
+
+//Usually only the parts of the view where items have changed are redrawn,
+//e.g. around a node being dragged and the edges that follow it.  Labels are
+//the exception: they can reach well outside their node's bounding
+//rectangle, they may be placed over the visible parts of their nodes and
+//they may be hidden where they overlap labels elsewhere in the view.  So
+//while any labels are shown, the whole view is redrawn for every change.
+//This is checked each time the view is drawn, which always happens after
+//the label settings change.
+void MyGraphicsView::updateViewportUpdateMode()
+{
+    bool labelsShown = g_settings->displayNodeCustomLabels ||
+            g_settings->displayNodeNames ||
+            g_settings->displayNodeLengths ||
+            g_settings->displayNodeReadDepth ||
+            g_settings->displayNodeCsvData ||
+            g_settings->displayBlastHits;
+
+    ViewportUpdateMode mode = labelsShown ? QGraphicsView::FullViewportUpdate : QGraphicsView::SmartViewportUpdate;
+    if (viewportUpdateMode() != mode)
+        setViewportUpdateMode(mode);
+}
+
+
 //Adapted from:
 //http://stackoverflow.com/questions/2663570/how-to-calculate-both-positive-and-negative-angle-between-two-lines
 double MyGraphicsView::angleBetweenTwoLines(QPointF line1Start, QPointF line1End, QPointF line2Start, QPointF line2End)
@@ -24,7 +24,9 @@
 #include <QLineF>
 
 class GraphicsViewZoom;
+class TileRenderer;
 class DeBruijnNode;
+class QRubberBand;
 
 class MyGraphicsView : public QGraphicsView
 {
@@ -55,14 +57,27 @@ protected:
     void mouseMoveEvent(QMouseEvent * event);
     void keyPressEvent(QKeyEvent * event);
     void mouseDoubleClickEvent(QMouseEvent * event);
+    void drawBackground(QPainter * painter, const QRectF & rect);
 
 private:
     double m_rotation;
+    TileRenderer * m_tileRenderer;
+    QRubberBand * m_rubberBand;
+    QPoint m_rubberBandOrigin;
+    bool m_rubberBanding;
 
     double distance(double x1, double y1, double x2, double y2);
     double angleBetweenTwoLines(QPointF line1Start, QPointF line1End, QPointF line2Start, QPointF line2End);
     void getFourViewportCornersInSceneCoordinates(QPointF * c1, QPointF * c2, QPointF * c3, QPointF * c4);
     bool differentSidesOfLine(QPointF p1, QPointF p2, QLineF line);
+    void updateRubberBand(QPoint pos);
+    void updateViewportUpdateMode();
+
+public slots:
+    void invalidateTiles();
+
+private slots:
+    void tilesChanged(const QRectF & sceneRect);
 
 signals:
     void doubleClickedNode(DeBruijnNode * node);
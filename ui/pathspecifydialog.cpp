@@ -38,8 +38,23 @@ PathSpecifyDialog::PathSpecifyDialog(QWidget *parent) :
     ui->pathTextEdit->setPlainText(g_memory->userSpecifiedPathString);
     ui->circularPathCheckBox->setChecked(g_memory->userSpecifiedPathCircular);
     g_memory->pathDialogIsVisible = true;
+    g_graphicsView->invalidateTiles();
     checkPathValidity();
 
+    //If the graph file came with its own paths (GFA P and W lines), they
+    //are offered in a combo box so they can be shown without typing them.
+    const PathTable * pathTable = &g_assemblyGraph->m_pathTable;
+    if (pathTable->getPathCount() > 0)
+    {
+        ui->graphPathsComboBox->addItem("");
+        ui->graphPathsComboBox->addItems(pathTable->getPathNames());
+    }
+    else
+    {
+        ui->graphPathsLabel->setVisible(false);
+        ui->graphPathsComboBox->setVisible(false);
+    }
+
     ui->circularPathInfoText->setInfoText("Tick this box to indicate that the path is circular, i.e. there is an edge connecting the "
                                           "last node in the list to the first.<br><br>"
                                           "Circular paths must contain the entirety of their nodes and therefore cannot contain "
@@ -51,6 +66,7 @@ PathSpecifyDialog::PathSpecifyDialog(QWidget *parent) :
     connect(ui->circularPathCheckBox, SIGNAL(toggled(bool)), g_graphicsView->viewport(), SLOT(update()));
     connect(ui->copyButton, SIGNAL(clicked(bool)), this, SLOT(copyPathToClipboard()));
     connect(ui->saveButton, SIGNAL(clicked(bool)), this, SLOT(savePathToFile()));
+    connect(ui->graphPathsComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(loadPathFromGraph(int)));
     connect(this, SIGNAL(rejected()), this, SLOT(deleteLater()));
 }
 
@@ -144,6 +160,43 @@ void PathSpecifyDialog::savePathToFile()
 }
 
 
+//This function shows one of the paths loaded with the graph.  The Path is
+//taken straight from the path table instead of being rebuilt from its text.
+void PathSpecifyDialog::loadPathFromGraph(int index)
+{
+    //Index 0 is the blank entry.
+    int pathIndex = index - 1;
+    if (pathIndex < 0 || pathIndex >= g_assemblyGraph->m_pathTable.getPathCount())
+        return;
+
+    Path path = g_assemblyGraph->m_pathTable.getPath(pathIndex);
+
+    ui->pathTextEdit->blockSignals(true);
+    ui->circularPathCheckBox->blockSignals(true);
+    ui->pathTextEdit->setPlainText(path.getString(true));
+    ui->circularPathCheckBox->setChecked(path.isCircular());
+    ui->pathTextEdit->blockSignals(false);
+    ui->circularPathCheckBox->blockSignals(false);
+
+    g_memory->userSpecifiedPathString = ui->pathTextEdit->toPlainText();
+    g_memory->userSpecifiedPathCircular = path.isCircular();
+    g_memory->userSpecifiedPath = path;
+
+    if (path.isEmpty())
+    {
+        ui->validPathLabel->setText("Invalid path: the path could not be built from the graph");
+        setPathValidityUiElements(false);
+    }
+    else
+    {
+        ui->validPathLabel->setText("Valid path");
+        setPathValidityUiElements(true);
+    }
+
+    g_graphicsView->viewport()->update();
+}
+
+
 void PathSpecifyDialog::addNodeName(DeBruijnNode * node)
 {
     QString pathText = ui->pathTextEdit->toPlainText();
@@ -46,6 +46,7 @@ private slots:
     void checkPathValidity();
     void copyPathToClipboard();
     void savePathToFile();
+    void loadPathFromGraph(int index);
 };
 
 #endif // PATHSPECIFYDIALOG_H
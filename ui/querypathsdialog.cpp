@@ -25,6 +25,7 @@
 #include "tablewidgetitemdouble.h"
 #include "../program/globals.h"
 #include "../program/memory.h"
+#include "mygraphicsview.h"
 
 QueryPathsDialog::QueryPathsDialog(QWidget * parent, BlastQuery * query) :
     QDialog(parent),
@@ -37,6 +38,7 @@ QueryPathsDialog::QueryPathsDialog(QWidget * parent, BlastQuery * query) :
     connect(ui->tableWidget, SIGNAL(itemSelectionChanged()), this, SLOT(tableSelectionChanged()));
 
     g_memory->queryPathDialogIsVisible = true;
+    g_graphicsView->invalidateTiles();
     g_memory->queryPaths.clear();
 
     ui->tableWidget->setHorizontalHeaderLabels(QStringList() << "Path" << "Length\n(bp)" << "Query\ncovered\nby path" <<
@@ -171,6 +173,7 @@ QueryPathsDialog::~QueryPathsDialog()
 void QueryPathsDialog::hidden()
 {
     g_memory->queryPathDialogIsVisible = false;
+    g_graphicsView->invalidateTiles();
     emit selectionChanged();
 }
 
@@ -0,0 +1,204 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sceneimageexporter.h"
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QPicture>
+#include <QImage>
+#include <QList>
+#include <QVector>
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentRun>
+#include "../program/pngwriter.h"
+#include "../graph/graphicsitemnode.h"
+#include "../graph/labelcache.h"
+#include "../program/globals.h"
+#include "../program/settings.h"
+
+//Bands are made about this many pixels in size, but never taller than
+//needed to give each thread at least one band.
+static const int BAND_PIXELS = 4 * 1024 * 1024;
+
+//QPainter's raster engine can't draw past about 32767 pixels, so bands
+//wider than this are drawn in tiles.  It leaves room for label margins.
+static const int MAX_TILE_WIDTH = 16384;
+
+
+//This function draws one band's recorded tiles side by side and compresses
+//the band.  Each tile is drawn into its own part of the band's image, in
+//its own coordinates.  It runs on the thread pool, so it only uses its own
+//copies of the pictures.
+static PngBand renderBandJob(QVector<QByteArray> tilePictures, int width, int rowCount, bool lastBand)
+{
+    QImage image(width, rowCount, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    for (int i = 0; i < tilePictures.size(); ++i)
+    {
+        int left = i * MAX_TILE_WIDTH;
+        int tileWidth = qMin(MAX_TILE_WIDTH, width - left);
+        QImage tileImage(image.bits() + left * 4, tileWidth, rowCount, image.bytesPerLine(), QImage::Format_RGB32);
+
+        QPicture picture;
+        picture.setData(tilePictures[i].constData(), uint(tilePictures[i].size()));
+        QPainter painter(&tileImage);
+        painter.drawPicture(0, 0, picture);
+        painter.end();
+    }
+
+    return PngWriter::compressBand(image, lastBand);
+}
+
+
+
+//This function returns false, with an error message, if the image could
+//not be saved.  The scene's items must already be set up for drawing the
+//whole scene (e.g. without tiles and with node-centred labels).
+bool SceneImageExporter::savePng(QGraphicsScene * scene, QString fullFileName,
+                                 QSize imageSize, QString * errorMessage)
+{
+    PngWriter writer(fullFileName);
+    if (!writer.open(imageSize.width(), imageSize.height()))
+    {
+        *errorMessage = writer.errorString();
+        return false;
+    }
+
+    double margin = getLabelMargin(scene);
+    int bandHeight = getBandHeight(imageSize);
+    int maxPendingBands = qMax(2, QThread::idealThreadCount() * 2);
+
+    //Labels are culled once for the whole image, not once per band, so a
+    //label crossing a band boundary is drawn (or left out) in both bands.
+    LabelCache::clearUsedAreas();
+    LabelCache::setKeepUsedAreas(true);
+    if (g_settings->hideOverlappingLabels)
+        chooseLabels(scene, imageSize);
+
+    bool success = true;
+    QList<QFuture<PngBand> > pendingBands;
+    for (int top = 0; top < imageSize.height(); top += bandHeight)
+    {
+        int rowCount = qMin(bandHeight, imageSize.height() - top);
+        bool lastBand = (top + rowCount == imageSize.height());
+        QVector<QByteArray> tilePictures;
+        for (int left = 0; left < imageSize.width(); left += MAX_TILE_WIDTH)
+        {
+            QRect tile(left, top, qMin(MAX_TILE_WIDTH, imageSize.width() - left), rowCount);
+            LabelCache::setDeviceOffset(tile.topLeft());
+            tilePictures.push_back(recordTile(scene, imageSize, tile, margin));
+        }
+        LabelCache::setDeviceOffset(QPointF());
+        pendingBands.push_back(QtConcurrent::run(renderBandJob, tilePictures, imageSize.width(),
+                                                 rowCount, lastBand));
+
+        while (pendingBands.size() >= maxPendingBands)
+        {
+            PngBand band = pendingBands.takeFirst().result();
+            if (success)
+                success = writer.writeBand(band);
+        }
+    }
+    while (!pendingBands.isEmpty())
+    {
+        PngBand band = pendingBands.takeFirst().result();
+        if (success)
+            success = writer.writeBand(band);
+    }
+
+    LabelCache::setKeepUsedAreas(false);
+
+    if (success)
+        success = writer.close();
+    if (!success)
+        *errorMessage = writer.errorString();
+    return success;
+}
+
+
+//Items are only drawn in a tile if their bounding rectangles reach it, but
+//labels can reach outside their nodes' bounding rectangles.  So each tile
+//also takes in the items this far (in scene units) around it.
+double SceneImageExporter::getLabelMargin(QGraphicsScene * scene)
+{
+    double margin = 0.0;
+    QList<QGraphicsItem *> items = scene->items();
+    for (int i = 0; i < items.size(); ++i)
+    {
+        GraphicsItemNode * node = dynamic_cast<GraphicsItemNode *>(items[i]);
+        if (node != 0 && node->isVisible())
+            margin = qMax(margin, node->getLargestLabelSize());
+    }
+    return margin;
+}
+
+
+//This function decides which overlapping labels are hidden before any band
+//is drawn.  The whole scene is painted once, at the image's scale, onto a
+//single pixel, which costs little as nearly everything is clipped away.
+//The labels are then taken in the same order as when the scene is drawn in
+//one piece, and their used areas are kept in image coordinates.  Each band
+//then shows a label only if it was kept here, whichever bands it crosses.
+void SceneImageExporter::chooseLabels(QGraphicsScene * scene, QSize imageSize)
+{
+    QImage pixel(1, 1, QImage::Format_RGB32);
+    QPainter painter(&pixel);
+    scene->render(&painter, QRectF(QPointF(0.0, 0.0), imageSize), scene->sceneRect(), Qt::KeepAspectRatio);
+    painter.end();
+}
+
+
+int SceneImageExporter::getBandHeight(QSize imageSize)
+{
+    int bandHeight = qMax(1, BAND_PIXELS / imageSize.width());
+    int threadCount = qMax(1, QThread::idealThreadCount());
+    int heightPerThread = (imageSize.height() + threadCount - 1) / threadCount;
+    return qMax(1, qMin(bandHeight, heightPerThread));
+}
+
+
+//This function records the drawing of one tile of the image, in the
+//tile's own coordinates and clipped to it.  The scene is scaled by the same
+//amount in both directions and centred in the image, so the source is the
+//part of the scene under the tile (plus the label margin).
+QByteArray SceneImageExporter::recordTile(QGraphicsScene * scene, QSize imageSize, QRect tile, double margin)
+{
+    QRectF sceneRect = scene->sceneRect();
+    double scale = qMin(imageSize.width() / sceneRect.width(), imageSize.height() / sceneRect.height());
+    double offsetX = (imageSize.width() - sceneRect.width() * scale) / 2.0;
+    double offsetY = (imageSize.height() - sceneRect.height() * scale) / 2.0;
+    double marginPixels = margin * scale;
+
+    QRectF imageRect = QRectF(tile).adjusted(-marginPixels, -marginPixels, marginPixels, marginPixels);
+    QRectF source(sceneRect.left() + (imageRect.left() - offsetX) / scale,
+                  sceneRect.top() + (imageRect.top() - offsetY) / scale,
+                  imageRect.width() / scale, imageRect.height() / scale);
+    QRectF target = imageRect.translated(-tile.left(), -tile.top());
+
+    QPicture picture;
+    QPainter painter(&picture);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setClipRect(QRectF(0.0, 0.0, tile.width(), tile.height()));
+    scene->render(&painter, target, source, Qt::KeepAspectRatio);
+    painter.end();
+
+    return QByteArray(picture.data(), int(picture.size()));
+}
@@ -0,0 +1,51 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SCENEIMAGEEXPORTER_H
+#define SCENEIMAGEEXPORTER_H
+
+#include <QString>
+#include <QSize>
+#include <QByteArray>
+
+class QGraphicsScene;
+
+//SceneImageExporter saves the entire scene as a PNG image of any size.
+//The image is made in horizontal bands, and a band wider than QPainter can
+//draw in is split into tiles.  Each tile's drawing is recorded into a
+//QPicture on the calling thread, as the scene's items can only be used
+//there, and the pictures are then rasterised and compressed a band at a
+//time on the global thread pool.  Finished bands are streamed to the file
+//in order, so only a few bands are ever held in memory, not the whole
+//image.  Like QGraphicsScene::render, the scene is scaled to fit the image
+//without changing its aspect ratio, and centred.
+
+class SceneImageExporter
+{
+public:
+    static bool savePng(QGraphicsScene * scene, QString fullFileName,
+                        QSize imageSize, QString * errorMessage);
+
+private:
+    static double getLabelMargin(QGraphicsScene * scene);
+    static int getBandHeight(QSize imageSize);
+    static void chooseLabels(QGraphicsScene * scene, QSize imageSize);
+    static QByteArray recordTile(QGraphicsScene * scene, QSize imageSize, QRect tile, double margin);
+};
+
+#endif // SCENEIMAGEEXPORTER_H
@@ -0,0 +1,333 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sceneindex.h"
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QLineF>
+#include <QList>
+#include <QSet>
+#include <algorithm>
+#include <math.h>
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../graph/graphicsitemnode.h"
+#include "../graph/graphicsitemedge.h"
+
+//Each tree node holds up to this many segments or child tree nodes.
+static const int TREE_NODE_CAPACITY = 16;
+
+
+//Unlike QRectF::intersects, this counts rectangles which only touch, and
+//rectangles with no width or height, as overlapping.
+static bool rectsOverlap(const QRectF & a, const QRectF & b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() &&
+            a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+static bool compareSegmentsX(const SceneIndexSegment & a, const SceneIndexSegment & b)
+{
+    return a.bounds.center().x() < b.bounds.center().x();
+}
+
+static bool compareSegmentsY(const SceneIndexSegment & a, const SceneIndexSegment & b)
+{
+    return a.bounds.center().y() < b.bounds.center().y();
+}
+
+static bool compareTreeNodesX(const SceneIndexTreeNode & a, const SceneIndexTreeNode & b)
+{
+    return a.bounds.center().x() < b.bounds.center().x();
+}
+
+static bool compareTreeNodesY(const SceneIndexTreeNode & a, const SceneIndexTreeNode & b)
+{
+    return a.bounds.center().y() < b.bounds.center().y();
+}
+
+
+//This function puts things in sort-tile-recursive order: sorted into
+//vertical slices by x, then by y within each slice, so that each run of
+//TREE_NODE_CAPACITY things covers a compact area.
+template <typename T>
+static void sortTileRecursive(std::vector<T> * things,
+                              bool (*compareX)(const T &, const T &),
+                              bool (*compareY)(const T &, const T &))
+{
+    int count = int(things->size());
+    int groupCount = (count + TREE_NODE_CAPACITY - 1) / TREE_NODE_CAPACITY;
+    int sliceCount = int(ceil(sqrt(double(groupCount))));
+    int sliceSize = sliceCount * TREE_NODE_CAPACITY;
+
+    std::sort(things->begin(), things->end(), compareX);
+    for (int start = 0; start < count; start += sliceSize)
+    {
+        int end = std::min(start + sliceSize, count);
+        std::sort(things->begin() + start, things->begin() + end, compareY);
+    }
+}
+
+
+//This function makes a tree node covering a run of things (segments or
+//tree nodes) starting at the given index.
+template <typename T>
+static SceneIndexTreeNode makeTreeNode(const std::vector<T> & things, int start, int firstChild)
+{
+    SceneIndexTreeNode treeNode;
+    treeNode.firstChild = firstChild;
+    treeNode.childCount = std::min(TREE_NODE_CAPACITY, int(things.size()) - start);
+    treeNode.bounds = things[start].bounds;
+    for (int i = start + 1; i < start + treeNode.childCount; ++i)
+        treeNode.bounds = treeNode.bounds.united(things[i].bounds);
+    return treeNode;
+}
+
+
+
+SceneIndex::SceneIndex() :
+    m_leafCount(0), m_built(false), m_edgeWidth(0.0)
+{
+}
+
+
+void SceneIndex::clear()
+{
+    m_segments.clear();
+    m_treeNodes.clear();
+    m_leafCount = 0;
+    m_built = false;
+}
+
+
+//The edge width is a global setting, so the index must be built again if
+//it changes.
+bool SceneIndex::isUpToDate() const
+{
+    return m_built && m_edgeWidth == g_settings->edgeWidth;
+}
+
+
+void SceneIndex::build(QGraphicsScene * scene)
+{
+    clear();
+    m_edgeWidth = g_settings->edgeWidth;
+
+    //The scene lists its items from the top down, which gives the stacking
+    //order of items with the same Z value.
+    QList<QGraphicsItem *> items = scene->items();
+    for (int i = 0; i < items.size(); ++i)
+    {
+        QGraphicsItem * item = items[i];
+
+        GraphicsItemNode * node = dynamic_cast<GraphicsItemNode *>(item);
+        if (node != 0)
+        {
+            for (size_t j = 1; j < node->m_linePoints.size(); ++j)
+                addSegment(node, i, node->m_linePoints[j - 1], node->m_linePoints[j], node->m_width / 2.0);
+            if (node->m_linePoints.size() == 1)
+                addSegment(node, i, node->m_linePoints[0], node->m_linePoints[0], node->m_width / 2.0);
+            continue;
+        }
+
+        //Edges are Bezier curves, which are flattened to line segments.
+        GraphicsItemEdge * edge = dynamic_cast<GraphicsItemEdge *>(item);
+        if (edge != 0)
+        {
+            QList<QPolygonF> polygons = edge->path().toSubpathPolygons();
+            for (int j = 0; j < polygons.size(); ++j)
+            {
+                const QPolygonF & polygon = polygons[j];
+                for (int k = 1; k < polygon.size(); ++k)
+                    addSegment(edge, i, polygon[k - 1], polygon[k], m_edgeWidth / 2.0);
+            }
+        }
+    }
+
+    buildTree();
+    m_built = true;
+}
+
+
+void SceneIndex::addSegment(QGraphicsItem * item, int stackingOrder, QPointF p1, QPointF p2, double halfWidth)
+{
+    SceneIndexSegment segment;
+    segment.item = item;
+    segment.stackingOrder = stackingOrder;
+    segment.p1 = p1;
+    segment.p2 = p2;
+    segment.halfWidth = halfWidth;
+    segment.bounds = QRectF(p1, p2).normalized().adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth);
+    m_segments.push_back(segment);
+}
+
+
+//The leaves are made from runs of segments, and then each level above is
+//made from runs of the level below, until there is a single root.  Sorting
+//a level only moves its tree nodes around, so their own children are not
+//affected.
+void SceneIndex::buildTree()
+{
+    if (m_segments.empty())
+        return;
+
+    sortTileRecursive(&m_segments, compareSegmentsX, compareSegmentsY);
+    std::vector<SceneIndexTreeNode> level;
+    for (int start = 0; start < int(m_segments.size()); start += TREE_NODE_CAPACITY)
+        level.push_back(makeTreeNode(m_segments, start, start));
+    m_leafCount = int(level.size());
+
+    while (true)
+    {
+        if (!m_treeNodes.empty())
+            sortTileRecursive(&level, compareTreeNodesX, compareTreeNodesY);
+
+        int levelStart = int(m_treeNodes.size());
+        m_treeNodes.insert(m_treeNodes.end(), level.begin(), level.end());
+        if (level.size() == 1)
+            break;
+
+        std::vector<SceneIndexTreeNode> parentLevel;
+        for (int start = 0; start < int(level.size()); start += TREE_NODE_CAPACITY)
+            parentLevel.push_back(makeTreeNode(level, start, levelStart + start));
+        level.swap(parentLevel);
+    }
+}
+
+
+//This function finds the segments whose bounds (including their width)
+//overlap the rectangle.
+void SceneIndex::findSegments(const QRectF & rect, std::vector<int> * segmentIndices) const
+{
+    if (m_treeNodes.empty())
+        return;
+
+    std::vector<int> stack;
+    stack.push_back(int(m_treeNodes.size()) - 1);
+    while (!stack.empty())
+    {
+        const SceneIndexTreeNode & treeNode = m_treeNodes[stack.back()];
+        bool isLeaf = stack.back() < m_leafCount;
+        stack.pop_back();
+        if (!rectsOverlap(treeNode.bounds, rect))
+            continue;
+
+        int end = treeNode.firstChild + treeNode.childCount;
+        for (int i = treeNode.firstChild; i < end; ++i)
+        {
+            if (!isLeaf)
+                stack.push_back(i);
+            else if (rectsOverlap(m_segments[i].bounds, rect))
+                segmentIndices->push_back(i);
+        }
+    }
+}
+
+
+//This function returns the visible items with any part in the area.
+std::vector<QGraphicsItem *> SceneIndex::getItemsInArea(const QPolygonF & area) const
+{
+    std::vector<int> segmentIndices;
+    findSegments(area.boundingRect(), &segmentIndices);
+
+    std::vector<QGraphicsItem *> items;
+    QSet<QGraphicsItem *> foundItems;
+    for (size_t i = 0; i < segmentIndices.size(); ++i)
+    {
+        const SceneIndexSegment & segment = m_segments[segmentIndices[i]];
+        if (foundItems.contains(segment.item) || !segment.item->isVisible())
+            continue;
+        if (segmentTouchesPolygon(segment.p1, segment.p2, segment.halfWidth, area))
+        {
+            foundItems.insert(segment.item);
+            items.push_back(segment.item);
+        }
+    }
+    return items;
+}
+
+
+//This function returns the topmost visible item at the point, or null if
+//there isn't one.
+QGraphicsItem * SceneIndex::getItemAt(QPointF point) const
+{
+    std::vector<int> segmentIndices;
+    findSegments(QRectF(point, point), &segmentIndices);
+
+    const SceneIndexSegment * topSegment = 0;
+    for (size_t i = 0; i < segmentIndices.size(); ++i)
+    {
+        const SceneIndexSegment & segment = m_segments[segmentIndices[i]];
+        if (!segment.item->isVisible())
+            continue;
+        if (topSegment != 0)
+        {
+            double z = segment.item->zValue();
+            double topZ = topSegment->item->zValue();
+            if (z < topZ || (z == topZ && segment.stackingOrder >= topSegment->stackingOrder))
+                continue;
+        }
+        if (distanceToSegment(point, segment.p1, segment.p2) <= segment.halfWidth)
+            topSegment = &segment;
+    }
+    return topSegment == 0 ? 0 : topSegment->item;
+}
+
+
+double SceneIndex::distanceToSegment(QPointF point, QPointF p1, QPointF p2)
+{
+    QPointF segmentVector = p2 - p1;
+    double lengthSquared = QPointF::dotProduct(segmentVector, segmentVector);
+    double t = 0.0;
+    if (lengthSquared > 0.0)
+        t = std::max(0.0, std::min(1.0, QPointF::dotProduct(point - p1, segmentVector) / lengthSquared));
+    QPointF difference = point - (p1 + t * segmentVector);
+    return sqrt(QPointF::dotProduct(difference, difference));
+}
+
+
+//A segment with a width touches a polygon if one of its ends is inside the
+//polygon, if it crosses the polygon's boundary, or if it comes within half
+//its width of the boundary.  The closest approach of two segments which
+//don't cross is always at an end of one of them, so only the ends need to
+//be checked for that.
+bool SceneIndex::segmentTouchesPolygon(QPointF p1, QPointF p2, double halfWidth,
+                                       const QPolygonF & polygon)
+{
+    if (polygon.isEmpty())
+        return false;
+    if (polygon.containsPoint(p1, Qt::OddEvenFill))
+        return true;
+
+    QLineF segment(p1, p2);
+    int pointCount = polygon.size();
+    for (int i = 0; i < pointCount; ++i)
+    {
+        QPointF a = polygon[i];
+        QPointF b = polygon[(i + 1) % pointCount];
+
+        QPointF intersection;
+        if (segment.intersect(QLineF(a, b), &intersection) == QLineF::BoundedIntersection)
+            return true;
+        if (distanceToSegment(a, p1, p2) <= halfWidth ||
+                distanceToSegment(p1, a, b) <= halfWidth ||
+                distanceToSegment(p2, a, b) <= halfWidth)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SCENEINDEX_H
+#define SCENEINDEX_H
+
+#include <QRectF>
+#include <QPointF>
+#include <QPolygonF>
+#include <vector>
+
+class QGraphicsScene;
+class QGraphicsItem;
+
+//SceneIndex is an R-tree over the line segments of the scene's nodes and
+//(flattened) edges.  It is used for rubber band selection and for finding
+//the item under the mouse, in place of the scene's own index, which tests
+//each candidate item against its full stroked shape.  Here, each candidate
+//is just a segment with a width, so testing it is a few multiplications.
+//
+//The tree is packed in one go from all of the segments (sort-tile-recursive
+//bulk loading), so it is never updated piecemeal.  When the scene changes,
+//it is thrown away and built again the next time it is needed.
+
+struct SceneIndexSegment
+{
+    QGraphicsItem * item;
+    QPointF p1;
+    QPointF p2;
+    double halfWidth;
+    QRectF bounds;
+    int stackingOrder;
+};
+
+//The children of a leaf are segments and the children of other tree nodes
+//are tree nodes in the level below.
+struct SceneIndexTreeNode
+{
+    QRectF bounds;
+    int firstChild;
+    int childCount;
+};
+
+class SceneIndex
+{
+public:
+    SceneIndex();
+
+    void build(QGraphicsScene * scene);
+    void clear();
+    bool isBuilt() const {return m_built;}
+    bool isUpToDate() const;
+    int getSegmentCount() const {return int(m_segments.size());}
+
+    std::vector<QGraphicsItem *> getItemsInArea(const QPolygonF & area) const;
+    QGraphicsItem * getItemAt(QPointF point) const;
+
+    static double distanceToSegment(QPointF point, QPointF p1, QPointF p2);
+    static bool segmentTouchesPolygon(QPointF p1, QPointF p2, double halfWidth,
+                                      const QPolygonF & polygon);
+
+private:
+    //The tree is stored level by level, leaves first, so the root is the
+    //last tree node.
+    std::vector<SceneIndexSegment> m_segments;
+    std::vector<SceneIndexTreeNode> m_treeNodes;
+    int m_leafCount;
+    bool m_built;
+    double m_edgeWidth;
+
+    void addSegment(QGraphicsItem * item, int stackingOrder, QPointF p1, QPointF p2, double halfWidth);
+    void buildTree();
+    void findSegments(const QRectF & rect, std::vector<int> * segmentIndices) const;
+};
+
+#endif // SCENEINDEX_H
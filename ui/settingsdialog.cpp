@@ -143,6 +143,9 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
     doubleFunctionPointer(&settings->edgeWidth, ui->edgeWidthSpinBox, false);
     doubleFunctionPointer(&settings->outlineThickness, ui->outlineThicknessSpinBox, false);
     doubleFunctionPointer(&settings->textOutlineThickness, ui->textOutlineThicknessSpinBox, false);
+    doubleFunctionPointer(&settings->lowDetailNodeWidth, ui->lowDetailNodeWidthSpinBox, false);
+    doubleFunctionPointer(&settings->minimumLabelHeight, ui->minimumLabelHeightSpinBox, false);
+    intFunctionPointer(&settings->tiledRenderingNodeCount, ui->tiledRenderingNodeCountSpinBox);
     colourFunctionPointer(&settings->edgeColour, ui->edgeColourButton);
     colourFunctionPointer(&settings->outlineColour, ui->outlineColourButton);
     colourFunctionPointer(&settings->selectionColour, ui->selectionColourButton);
@@ -180,6 +183,13 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
     if (setWidgets)
     {
         ui->graphLayoutQualitySlider->setValue(settings->graphLayoutQuality);
+        ui->incrementalLayoutCheckBox->setChecked(settings->incrementalLayout);
+        ui->capNodeSegmentsCheckBox->setChecked(settings->capNodeSegments);
+        ui->coarsenChainsCheckBox->setChecked(settings->coarsenChains);
+        ui->componentLayoutCheckBox->setChecked(settings->componentLayout);
+        ui->edgeBundlingCheckBox->setChecked(settings->edgeBundling);
+        ui->fmmmLayoutRadioButton->setChecked(settings->layoutAlgorithm == FMMM_LAYOUT);
+        ui->gridLayoutRadioButton->setChecked(settings->layoutAlgorithm == GRID_LAYOUT);
         ui->antialiasingOnRadioButton->setChecked(settings->antialiasing);
         ui->antialiasingOffRadioButton->setChecked(!settings->antialiasing);
         ui->readDepthValueAutoRadioButton->setChecked(settings->autoReadDepthValue);
@@ -192,10 +202,21 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
         ui->basePairsPerSegmentManualRadioButton->setChecked(settings->nodeLengthMode != AUTO_NODE_LENGTH);
         ui->positionVisibleRadioButton->setChecked(!settings->positionTextNodeCentre);
         ui->positionCentreRadioButton->setChecked(settings->positionTextNodeCentre);
+        ui->overlappingLabelsHideRadioButton->setChecked(settings->hideOverlappingLabels);
+        ui->overlappingLabelsShowRadioButton->setChecked(!settings->hideOverlappingLabels);
     }
     else
     {
         settings->graphLayoutQuality = ui->graphLayoutQualitySlider->value();
+        settings->incrementalLayout = ui->incrementalLayoutCheckBox->isChecked();
+        settings->capNodeSegments = ui->capNodeSegmentsCheckBox->isChecked();
+        settings->coarsenChains = ui->coarsenChainsCheckBox->isChecked();
+        settings->componentLayout = ui->componentLayoutCheckBox->isChecked();
+        settings->edgeBundling = ui->edgeBundlingCheckBox->isChecked();
+        if (ui->gridLayoutRadioButton->isChecked())
+            settings->layoutAlgorithm = GRID_LAYOUT;
+        else
+            settings->layoutAlgorithm = FMMM_LAYOUT;
         settings->antialiasing = ui->antialiasingOnRadioButton->isChecked();
         settings->autoReadDepthValue = ui->readDepthValueAutoRadioButton->isChecked();
         if (ui->basePairsPerSegmentAutoRadioButton->isChecked())
@@ -203,6 +224,7 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
         else
             settings->nodeLengthMode = MANUAL_NODE_LENGTH;
         settings->positionTextNodeCentre = ui->positionCentreRadioButton->isChecked();
+        settings->hideOverlappingLabels = ui->overlappingLabelsHideRadioButton->isChecked();
     }
 }
 
@@ -239,6 +261,41 @@ void SettingsDialog::setInfoTexts()
                                                 "positioning the graph components.<br><br>Low values are faster and "
                                                 "recommended for big assembly graphs. Higher values may result in smoother, "
                                                 "more pleasing layouts.");
+    ui->incrementalLayoutInfoText->setInfoText("When this is ticked and the graph is drawn again (e.g. with a larger "
+                                               "distance around the starting nodes), nodes that are already drawn stay "
+                                               "where they are and only the newly drawn nodes are laid out.<br><br>"
+                                               "Use 'Redo graph layout' in the 'View' menu to lay out the whole graph "
+                                               "from scratch.");
+    ui->capNodeSegmentsInfoText->setInfoText("When this is ticked, long nodes are laid out with fewer segments "
+                                             "than they are drawn with.  Past 10 segments, the number used "
+                                             "in the layout only grows logarithmically with node length.<br><br>"
+                                             "This can make the layout much faster for graphs with long "
+                                             "contigs, such as nearly complete assemblies.  The nodes are "
+                                             "drawn along smooth curves through the laid out segments, so "
+                                             "they keep their length.");
+    ui->coarsenChainsInfoText->setInfoText("When this is ticked, the graph layout is first done on a simpler "
+                                           "graph, in which each unbranched chain (such as a long node, or "
+                                           "nodes joined end to end without any branches) is replaced by a "
+                                           "single point.  The chains are then put back and the layout is "
+                                           "refined.<br><br>"
+                                           "This makes the layout faster, especially for graphs with long "
+                                           "nodes.  It only affects the layout - the graph itself is not "
+                                           "changed.");
+    ui->layoutAlgorithmInfoText->setInfoText("This is the algorithm used to lay out the graph.<br><br>"
+                                             "FMMM gives the best looking layouts and is suitable for most "
+                                             "graphs.<br><br>"
+                                             "Grid is a simpler multilevel layout which only looks at nearby "
+                                             "nodes.  It is much faster and uses less memory than FMMM, so it "
+                                             "is better for very large graphs (e.g. over a million segments).<br><br>"
+                                             "This setting is not used when only newly drawn nodes are laid out "
+                                             "(see 'Keep drawn node positions').  Those nodes are placed by a "
+                                             "simple layout around the nodes already drawn.");
+    ui->componentLayoutInfoText->setInfoText("When this is ticked, each connected component of the graph is laid "
+                                             "out on its own, several at a time, and the components are then "
+                                             "packed together in rows.<br><br>"
+                                             "This is much faster for graphs made of many pieces, but the "
+                                             "components are arranged differently from a layout of the whole "
+                                             "graph.");
     ui->readDepthPowerInfoText->setInfoText("This is the power used in the function for determining node widths.");
     ui->readDepthEffectOnWidthInfoText->setInfoText("This setting controls the degree to which a node's read depth affects its width.<br><br>"
                                                    "If set to 0%, all nodes will have the same width (equal to the average "
@@ -255,9 +312,29 @@ void SettingsDialog::setInfoTexts()
                                           "of the view to stay visible.<br><br>"
                                           "When 'On node centre' is selected, node labels will always be displayed at the centre "
                                           "of each node, regardless of the view's position.");
+    ui->overlappingLabelsInfoText->setInfoText("When 'Hide' is selected, a label that would overlap one already drawn is "
+                                               "left out, which keeps crowded regions of the graph readable. Zooming in "
+                                               "will make room for the hidden labels.<br><br>"
+                                               "When 'Show' is selected, all labels are drawn, even if they overlap.");
 
     ui->antialiasingInfoText->setInfoText("Antialiasing makes the display smoother and more pleasing. Disable antialiasing "
                                           "if you are experiencing slow performance when viewing large graphs.");
+    ui->lowDetailNodeWidthInfoText->setInfoText("Nodes which appear narrower than this many pixels on the screen are drawn as simple "
+                                                "lines, without outlines or arrowheads, and their BLAST hits are simplified.<br><br>"
+                                                "This makes zoomed-out views of large graphs much faster to draw. Set this to zero "
+                                                "to always draw nodes in full detail.");
+    ui->minimumLabelHeightInfoText->setInfoText("Node labels and BLAST hit labels which would appear shorter than this many pixels "
+                                                "on the screen are not drawn, as they would be too small to read.");
+    ui->tiledRenderingNodeCountInfoText->setInfoText("Graphs with at least this many drawn nodes are displayed from images prepared "
+                                                     "in the background, which makes moving around very large graphs much faster. "
+                                                     "Selected nodes, and nodes showing labels or BLAST hits, are still drawn "
+                                                     "directly.<br><br>"
+                                                     "Set this to zero to always draw every node directly.");
+    ui->edgeBundlingInfoText->setInfoText("When this is ticked and nodes are drawn as simple lines (see 'Low detail "
+                                          "node width'), edges which run side by side between the same places are drawn "
+                                          "as a single curve, and edges shorter than a pixel are not drawn.<br><br>"
+                                          "This makes zoomed-out views of dense graphs faster to draw. Selected edges "
+                                          "are always drawn individually.");
     ui->uniformPositiveNodeColourInfoText->setInfoText("This is the colour of all positive nodes when Bandage is set to the "
                                                        "'Uniform colour' option.");
     ui->uniformNegativeNodeColourInfoText->setInfoText("This is the colour of all negative nodes when Bandage is set to the "
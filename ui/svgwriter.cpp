@@ -0,0 +1,518 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "svgwriter.h"
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QList>
+#include <QLineF>
+#include <math.h>
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../program/memory.h"
+#include "../graph/graphicsitemnode.h"
+#include "../graph/graphicsitemedge.h"
+#include "../graph/debruijnnode.h"
+#include "../graph/labelcache.h"
+
+
+static QPointF getUnitVector(QPointF from, QPointF to)
+{
+    double length = QLineF(from, to).length();
+    if (length == 0.0)
+        return QPointF(0.0, 0.0);
+    return (to - from) / length;
+}
+
+
+//Partial node paths are made only of straight lines, so their points are
+//just the path's elements.
+static std::vector<QPointF> getPathPoints(const QPainterPath & path)
+{
+    std::vector<QPointF> points;
+    for (int i = 0; i < path.elementCount(); ++i)
+        points.push_back(QPointF(path.elementAt(i).x, path.elementAt(i).y));
+    return points;
+}
+
+
+//Colours are given as presentation attributes, e.g. fill="#ff0000".
+static QString getColourAttribute(QString property, QColor colour)
+{
+    QString attribute = " " + property + "=\"" + colour.name() + "\"";
+    if (colour.alpha() < 255)
+        attribute += " " + property + "-opacity=\"" + QString::number(colour.alphaF(), 'f', 3) + "\"";
+    return attribute;
+}
+
+
+//Colours in the style sheet are given as properties, e.g. fill:#ff0000.
+static QString getColourStyle(QString property, QColor colour)
+{
+    QString style = property + ":" + colour.name();
+    if (colour.alpha() < 255)
+        style += ";" + property + "-opacity:" + QString::number(colour.alphaF(), 'f', 3);
+    return style;
+}
+
+
+static QString getFillRuleAttribute(QString property, const QPainterPath & path)
+{
+    if (path.fillRule() == Qt::OddEvenFill)
+        return " " + property + "=\"evenodd\"";
+    return "";
+}
+
+
+
+SvgWriter::SvgWriter(QString fullFileName) :
+    m_file(fullFileName), m_scale(1.0), m_decimals(2), m_clipPathCount(0)
+{
+}
+
+
+//This function writes the whole scene, at the scale which fits it to the
+//image size.  The scene's rotation should be undone first, as labels are
+//written upright.
+bool SvgWriter::writeScene(QGraphicsScene * scene, QSize imageSize)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_out.setDevice(&m_file);
+    m_out.setCodec("UTF-8");
+
+    QRectF sceneRect = scene->sceneRect();
+    m_scale = qMin(imageSize.width() / sceneRect.width(), imageSize.height() / sceneRect.height());
+
+    //Coordinates are written to a hundredth of a pixel in the image.
+    m_decimals = qBound(0, int(ceil(log10(m_scale))) + 2, 6);
+
+    m_deviceTransform = QTransform::fromScale(m_scale, m_scale);
+    m_deviceTransform.translate(-sceneRect.left(), -sceneRect.top());
+    m_labelIds.clear();
+    m_clipPathCount = 0;
+
+    m_out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    m_out << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" version=\"1.1\""
+          << " width=\"" << imageSize.width() << "\" height=\"" << imageSize.height() << "\""
+          << " viewBox=\"" << getNumber(sceneRect.left()) << " " << getNumber(sceneRect.top()) << " "
+          << getNumber(sceneRect.width()) << " " << getNumber(sceneRect.height()) << "\">\n";
+    writeStyles();
+    m_out << "<rect x=\"" << getNumber(sceneRect.left()) << "\" y=\"" << getNumber(sceneRect.top())
+          << "\" width=\"" << getNumber(sceneRect.width()) << "\" height=\"" << getNumber(sceneRect.height())
+          << "\" fill=\"#ffffff\"/>\n";
+
+    //Items are written from the bottom up, so they stack as they do in the
+    //scene.
+    LabelCache::clearUsedAreas();
+    QList<QGraphicsItem *> items = scene->items(Qt::AscendingOrder);
+    for (int i = 0; i < items.size(); ++i)
+    {
+        if (!items[i]->isVisible())
+            continue;
+
+        GraphicsItemEdge * edge = dynamic_cast<GraphicsItemEdge *>(items[i]);
+        if (edge != 0)
+        {
+            writeEdge(edge);
+            continue;
+        }
+        GraphicsItemNode * node = dynamic_cast<GraphicsItemNode *>(items[i]);
+        if (node != 0)
+            writeNode(node);
+    }
+
+    m_out << "</svg>\n";
+    m_out.flush();
+
+    bool success = (m_out.status() == QTextStream::Ok && m_file.error() == QFileDevice::NoError);
+    if (!success)
+        m_errorString = m_file.errorString();
+    m_file.close();
+    return success;
+}
+
+
+//The pens which are the same for many items are given as style classes:
+//  e, es: edges and selected edges
+//  n: node lines (the node itself, its outline underneath and low detail nodes)
+//  p: BLAST hit and barcode parts
+//  o, s: node outlines and selected node outlines
+//  lo, lt: label outlines and label text
+void SvgWriter::writeStyles()
+{
+    QString edgeWidth = getNumber(g_settings->edgeWidth);
+
+    m_out << "<style type=\"text/css\"><![CDATA[\n";
+    m_out << ".e{fill:none;" << getColourStyle("stroke", g_settings->edgeColour) << ";stroke-width:" << edgeWidth
+          << ";stroke-linecap:round;stroke-linejoin:bevel}\n";
+    m_out << ".es{fill:none;" << getColourStyle("stroke", g_settings->selectionColour) << ";stroke-width:" << edgeWidth
+          << ";stroke-linecap:round;stroke-linejoin:bevel}\n";
+    m_out << ".n{fill:none;stroke-linecap:butt;stroke-linejoin:round}\n";
+    m_out << ".p{fill:none;stroke-linecap:butt;stroke-linejoin:bevel}\n";
+    m_out << ".o{fill:none;" << getColourStyle("stroke", g_settings->outlineColour) << ";stroke-width:"
+          << getNumber(g_settings->outlineThickness) << ";stroke-linecap:round;stroke-linejoin:round}\n";
+    m_out << ".s{fill:none;" << getColourStyle("stroke", g_settings->selectionColour) << ";stroke-width:"
+          << getNumber(g_settings->selectionThickness) << ";stroke-linecap:round;stroke-linejoin:round}\n";
+    m_out << ".lo{fill:none;" << getColourStyle("stroke", g_settings->textOutlineColour) << ";stroke-width:"
+          << getNumber(g_settings->textOutlineThickness * 2.0) << ";stroke-linecap:square;stroke-linejoin:round}\n";
+    m_out << ".lt{" << getColourStyle("fill", g_settings->textColour) << ";stroke:none}\n";
+    m_out << "]]></style>\n";
+}
+
+
+void SvgWriter::writeEdge(GraphicsItemEdge * edge)
+{
+    m_out << "<path class=\"" << (edge->isSelected() ? "es" : "e") << "\" d=\""
+          << getPathData(edge->path()) << "\"/>\n";
+}
+
+
+//Nodes are written as GraphicsItemNode::paint draws them: the node, then
+//its BLAST hits or barcodes, its outline and its labels.
+void SvgWriter::writeNode(GraphicsItemNode * node)
+{
+    bool lowDetail = !g_memory->fullDetailPainting && node->m_width * m_scale < g_settings->lowDetailNodeWidth;
+    std::vector<BlastHitPart> parts = node->getColouredParts(m_scale, lowDetail);
+
+    if (lowDetail)
+        writeLowDetailNode(node, parts);
+    else
+    {
+        QString outlineClass = "o";
+        QColor outlineColour = g_settings->outlineColour;
+        double outlineThickness = g_settings->outlineThickness;
+        if (node->isSelected())
+        {
+            outlineClass = "s";
+            outlineColour = g_settings->selectionColour;
+            outlineThickness = g_settings->selectionThickness;
+        }
+
+        if (canWriteAsPolylines(node, outlineColour, outlineThickness))
+            writePolylineNode(node, parts, outlineClass, outlineColour, outlineThickness);
+        else
+            writeExactNode(node, parts, outlineClass, outlineThickness);
+    }
+
+    writeNodeLabels(node);
+}
+
+
+void SvgWriter::writeLowDetailNode(GraphicsItemNode * node, const std::vector<BlastHitPart> & parts)
+{
+    if (node->isSelected())
+        writePolyline(node->m_linePoints, "n", g_settings->selectionColour,
+                      node->m_width + 2.0 * g_settings->selectionThickness);
+    writePolyline(node->m_linePoints, "n", node->m_colour, node->m_width);
+
+    for (size_t i = 0; i < parts.size(); ++i)
+        writePolyline(getPathPoints(node->makePartialPath(parts[i].m_nodeFractionStart, parts[i].m_nodeFractionEnd)),
+                      "p", parts[i].m_colour, node->m_width);
+}
+
+
+//The node's outline is half inside and half outside its shape.  So the
+//outline is written as a line wider than the node by the outline thickness,
+//and the node (and its parts) on top of it as a line narrower by the same
+//amount.  The ends of both lines are moved by half the outline thickness to
+//leave the outline across the node's ends.  In double mode, the lines stop
+//at the back of the arrowhead, which is a triangle outlined on two sides.
+void SvgWriter::writePolylineNode(GraphicsItemNode * node, const std::vector<BlastHitPart> & parts,
+                                  QString outlineClass, QColor outlineColour, double outlineThickness)
+{
+    const std::vector<QPointF> & points = node->m_linePoints;
+    double width = node->m_width;
+    double halfOutline = outlineThickness / 2.0;
+    double length = node->getNodePathLength();
+    bool arrow = node->m_hasArrow;
+
+    std::vector<QPointF> body(points);
+    QPointF arrowBase, direction, normal;
+    double bodyEndFraction = 1.0;
+    if (arrow)
+    {
+        direction = getUnitVector(points[points.size() - 2], points.back());
+        normal = QPointF(-direction.y(), direction.x());
+        arrowBase = points.back() - direction * (width / 2.0);
+        body.back() = arrowBase;
+        bodyEndFraction = (length - width / 2.0) / length;
+    }
+
+    QPointF startDirection = getUnitVector(body[0], body[1]);
+    QPointF endDirection = getUnitVector(body[body.size() - 2], body.back());
+
+    if (outlineThickness > 0.0)
+    {
+        std::vector<QPointF> outline(body);
+        outline.front() -= startDirection * halfOutline;
+        if (!arrow)
+            outline.back() += endDirection * halfOutline;
+        writePolyline(outline, "n", outlineColour, width + outlineThickness);
+    }
+
+    std::vector<QPointF> fill(body);
+    fill.front() += startDirection * halfOutline;
+    if (!arrow)
+        fill.back() -= endDirection * halfOutline;
+    writePolyline(fill, "n", node->m_colour, width - outlineThickness);
+
+    std::vector<QPointF> arrowhead;
+    if (arrow)
+    {
+        arrowhead.push_back(arrowBase + normal * (width / 2.0));
+        arrowhead.push_back(points.back());
+        arrowhead.push_back(arrowBase - normal * (width / 2.0));
+        writePolygon(arrowhead, node->m_colour);
+    }
+
+    //Parts stop short of the outline across the node's ends.  In the
+    //arrowhead, they are cut to its shape.
+    double startLimit = halfOutline / length;
+    double endLimit = arrow ? bodyEndFraction : 1.0 - halfOutline / length;
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        double start = qMin(parts[i].m_nodeFractionStart, parts[i].m_nodeFractionEnd);
+        double end = qMax(parts[i].m_nodeFractionStart, parts[i].m_nodeFractionEnd);
+
+        double bodyStart = qMax(start, startLimit);
+        double bodyEnd = qMin(end, endLimit);
+        if (bodyEnd > bodyStart)
+            writePolyline(getPathPoints(node->makePartialPath(bodyStart, bodyEnd)), "p",
+                          parts[i].m_colour, width - outlineThickness);
+
+        if (arrow && end > bodyEndFraction)
+        {
+            double distance1 = (qMax(start, bodyEndFraction) - bodyEndFraction) * length;
+            double distance2 = (qMin(end, 1.0) - bodyEndFraction) * length;
+            double halfWidth1 = qMax(0.0, width / 2.0 - distance1);
+            double halfWidth2 = qMax(0.0, width / 2.0 - distance2);
+            std::vector<QPointF> arrowPart;
+            arrowPart.push_back(arrowBase + direction * distance1 + normal * halfWidth1);
+            arrowPart.push_back(arrowBase + direction * distance2 + normal * halfWidth2);
+            arrowPart.push_back(arrowBase + direction * distance2 - normal * halfWidth2);
+            arrowPart.push_back(arrowBase + direction * distance1 - normal * halfWidth1);
+            writePolygon(arrowPart, parts[i].m_colour);
+        }
+    }
+
+    if (arrow && outlineThickness > 0.0)
+        m_out << "<polyline class=\"" << outlineClass << "\" points=\"" << getPointsText(arrowhead) << "\"/>\n";
+}
+
+
+//This writes the node as it is painted, with its outline path filled and
+//then stroked.
+void SvgWriter::writeExactNode(GraphicsItemNode * node, const std::vector<BlastHitPart> & parts,
+                               QString outlineClass, double outlineThickness)
+{
+    QPainterPath shape = node->shape();
+    m_out << "<path d=\"" << getPathData(shape) << "\"" << getColourAttribute("fill", node->m_colour)
+          << getFillRuleAttribute("fill-rule", shape) << "/>\n";
+
+    if (!parts.empty())
+    {
+        if (node->m_hasArrow)
+        {
+            m_out << "<clipPath id=\"c" << m_clipPathCount << "\"><path d=\"" << getPathData(shape) << "\""
+                  << getFillRuleAttribute("clip-rule", shape) << "/></clipPath>\n";
+            m_out << "<g clip-path=\"url(#c" << m_clipPathCount << ")\">\n";
+            ++m_clipPathCount;
+        }
+        for (size_t i = 0; i < parts.size(); ++i)
+            writePolyline(getPathPoints(node->makePartialPath(parts[i].m_nodeFractionStart, parts[i].m_nodeFractionEnd)),
+                          "p", parts[i].m_colour, node->m_width);
+        if (node->m_hasArrow)
+            m_out << "</g>\n";
+    }
+
+    if (outlineThickness > 0.0)
+        m_out << "<path class=\"" << outlineClass << "\" d=\"" << getPathData(node->getSimplifiedOutline()) << "\"/>\n";
+}
+
+
+//The polyline form matches the painted node when the node and its outline
+//are opaque, the node is wider than its outline and its end segments are
+//long enough to hold the outline (and arrowhead).
+bool SvgWriter::canWriteAsPolylines(GraphicsItemNode * node, QColor outlineColour,
+                                    double outlineThickness) const
+{
+    const std::vector<QPointF> & points = node->m_linePoints;
+    if (points.size() < 2)
+        return false;
+    if (node->m_colour.alpha() < 255)
+        return false;
+    if (outlineThickness > 0.0 && outlineColour.alpha() < 255)
+        return false;
+    if (node->m_width <= 2.0 * outlineThickness)
+        return false;
+
+    double firstLength = QLineF(points[0], points[1]).length();
+    double lastLength = QLineF(points[points.size() - 2], points.back()).length();
+    double endSpace = outlineThickness;
+    if (node->m_hasArrow)
+    {
+        if (points.size() == 2)
+            return lastLength > node->m_width / 2.0 + endSpace;
+        return firstLength > endSpace && lastLength > node->m_width / 2.0;
+    }
+    return firstLength > endSpace && lastLength > endSpace;
+}
+
+
+void SvgWriter::writeNodeLabels(GraphicsItemNode * node)
+{
+    if (!g_memory->fullDetailPainting && LabelCache::getLineHeight() * m_scale < g_settings->minimumLabelHeight)
+        return;
+
+    if (node->anyNodeDisplayText())
+    {
+        QStringList nodeText = node->getNodeText();
+        std::vector<QPointF> centres;
+        if (g_settings->positionTextNodeCentre)
+            centres.push_back(node->getCentre(node->m_linePoints));
+        else
+            centres = node->getCentres();
+        for (size_t i = 0; i < centres.size(); ++i)
+            writeLabel(nodeText, centres[i]);
+    }
+
+    bool nodeHasBlastHits;
+    if (g_settings->doubleMode)
+        nodeHasBlastHits = node->m_deBruijnNode->thisNodeHasBlastHits();
+    else
+        nodeHasBlastHits = node->m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits();
+    if (g_settings->displayBlastHits && nodeHasBlastHits)
+    {
+        std::vector<QString> blastHitText;
+        std::vector<QPointF> blastHitLocation;
+        if (g_settings->doubleMode)
+            node->getBlastHitsTextAndLocationThisNode(&blastHitText, &blastHitLocation);
+        else
+            node->getBlastHitsTextAndLocationThisNodeOrReverseComplement(&blastHitText, &blastHitLocation);
+        for (size_t i = 0; i < blastHitText.size(); ++i)
+            writeLabel(QStringList(blastHitText[i]), blastHitLocation[i]);
+    }
+}
+
+
+//Each distinct label's path is defined once, the first time it is used,
+//and then drawn where needed.  The text outline is the same path stroked.
+void SvgWriter::writeLabel(const QStringList & lines, QPointF centre)
+{
+    LabelPaths labelPaths = LabelCache::getLabelPaths(lines);
+    QRectF textBoundingRect = labelPaths.text.boundingRect();
+    QPointF position = centre + QPointF(0.0, textBoundingRect.height() / 2.0);
+
+    QRectF labelRect = g_settings->textOutline ? labelPaths.outline.boundingRect() : textBoundingRect;
+    if (g_settings->hideOverlappingLabels &&
+            !LabelCache::useArea(m_deviceTransform.mapRect(labelRect.translated(position))))
+        return;
+
+    QString key = lines.join("\n");
+    int id;
+    QHash<QString, int>::const_iterator found = m_labelIds.constFind(key);
+    if (found != m_labelIds.constEnd())
+        id = found.value();
+    else
+    {
+        id = m_labelIds.size();
+        m_labelIds.insert(key, id);
+        m_out << "<defs><path id=\"l" << id << "\" d=\"" << getPathData(labelPaths.text) << "\""
+              << getFillRuleAttribute("fill-rule", labelPaths.text) << "/></defs>\n";
+    }
+
+    QString location = " x=\"" + getNumber(position.x()) + "\" y=\"" + getNumber(position.y()) + "\"";
+    if (g_settings->textOutline)
+        m_out << "<use class=\"lo\" xlink:href=\"#l" << id << "\"" << location << "/>\n";
+    m_out << "<use class=\"lt\" xlink:href=\"#l" << id << "\"" << location << "/>\n";
+}
+
+
+void SvgWriter::writePolyline(const std::vector<QPointF> & points, QString className,
+                              QColor colour, double width)
+{
+    if (points.size() < 2)
+        return;
+    m_out << "<polyline class=\"" << className << "\" points=\"" << getPointsText(points) << "\""
+          << getColourAttribute("stroke", colour) << " stroke-width=\"" << getNumber(width) << "\"/>\n";
+}
+
+
+void SvgWriter::writePolygon(const std::vector<QPointF> & points, QColor colour)
+{
+    m_out << "<polygon points=\"" << getPointsText(points) << "\"" << getColourAttribute("fill", colour) << "/>\n";
+}
+
+
+QString SvgWriter::getPointsText(const std::vector<QPointF> & points)
+{
+    QString text;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        if (i > 0)
+            text += " ";
+        text += getNumber(points[i].x()) + "," + getNumber(points[i].y());
+    }
+    return text;
+}
+
+
+QString SvgWriter::getPathData(const QPainterPath & path)
+{
+    QString data;
+    for (int i = 0; i < path.elementCount(); ++i)
+    {
+        const QPainterPath::Element & element = path.elementAt(i);
+        if (element.isMoveTo())
+            data += "M" + getNumber(element.x) + " " + getNumber(element.y);
+        else if (element.isLineTo())
+            data += "L" + getNumber(element.x) + " " + getNumber(element.y);
+        else if (element.isCurveTo() && i + 2 < path.elementCount())
+        {
+            const QPainterPath::Element & control2 = path.elementAt(i + 1);
+            const QPainterPath::Element & end = path.elementAt(i + 2);
+            data += "C" + getNumber(element.x) + " " + getNumber(element.y) + " " +
+                    getNumber(control2.x) + " " + getNumber(control2.y) + " " +
+                    getNumber(end.x) + " " + getNumber(end.y);
+            i += 2;
+        }
+    }
+    return data;
+}
+
+
+//Numbers are written with no more decimal places than the image needs and
+//without trailing zeros.
+QString SvgWriter::getNumber(double value)
+{
+    QString number = QString::number(value, 'f', m_decimals);
+    if (number.contains('.'))
+    {
+        while (number.endsWith('0'))
+            number.chop(1);
+        if (number.endsWith('.'))
+            number.chop(1);
+    }
+    if (number == "-0")
+        number = "0";
+    return number;
+}
@@ -0,0 +1,92 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SVGWRITER_H
+#define SVGWRITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+#include <QHash>
+#include <QSize>
+#include <QRectF>
+#include <QPointF>
+#include <QColor>
+#include <QTransform>
+#include <QPainterPath>
+#include <vector>
+#include "../blast/blasthitpart.h"
+
+class QGraphicsScene;
+class GraphicsItemNode;
+class GraphicsItemEdge;
+
+//SvgWriter saves the scene as an SVG file without going through
+//QSvgGenerator and each item's paint function, which write every node as
+//filled and stroked outline paths.  Instead, a node is written as a
+//polyline stroked to the node's width (over a wider one for its outline),
+//with an arrowhead polygon in double mode, and its BLAST hits and barcodes
+//are short stroked segments along the same line.  Edges are written as the
+//Bezier curves they are made from.  Shared pen settings are in style
+//classes and each distinct label is defined once, so the files are much
+//smaller.  The SVG is written to the file as the scene is read.
+//
+//Nodes whose shape can't be matched that way (e.g. with see-through
+//colours or very short arrowheads) are written as their exact outlines.
+
+class SvgWriter
+{
+public:
+    explicit SvgWriter(QString fullFileName);
+
+    bool writeScene(QGraphicsScene * scene, QSize imageSize);
+    QString errorString() const {return m_errorString;}
+
+private:
+    QFile m_file;
+    QTextStream m_out;
+    double m_scale;
+    int m_decimals;
+    QTransform m_deviceTransform;
+    QHash<QString, int> m_labelIds;
+    int m_clipPathCount;
+    QString m_errorString;
+
+    void writeStyles();
+    void writeEdge(GraphicsItemEdge * edge);
+    void writeNode(GraphicsItemNode * node);
+    void writeLowDetailNode(GraphicsItemNode * node, const std::vector<BlastHitPart> & parts);
+    void writePolylineNode(GraphicsItemNode * node, const std::vector<BlastHitPart> & parts,
+                           QString outlineClass, QColor outlineColour, double outlineThickness);
+    void writeExactNode(GraphicsItemNode * node, const std::vector<BlastHitPart> & parts,
+                        QString outlineClass, double outlineThickness);
+    bool canWriteAsPolylines(GraphicsItemNode * node, QColor outlineColour,
+                             double outlineThickness) const;
+    void writeNodeLabels(GraphicsItemNode * node);
+    void writeLabel(const QStringList & lines, QPointF centre);
+
+    void writePolyline(const std::vector<QPointF> & points, QString className,
+                       QColor colour, double width);
+    void writePolygon(const std::vector<QPointF> & points, QColor colour);
+    QString getPointsText(const std::vector<QPointF> & points);
+    QString getPathData(const QPainterPath & path);
+    QString getNumber(double value);
+};
+
+#endif // SVGWRITER_H
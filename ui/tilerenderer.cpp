@@ -0,0 +1,516 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "tilerenderer.h"
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QThread>
+#include <QtConcurrentRun>
+#include <algorithm>
+#include <math.h>
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../program/memory.h"
+#include "../graph/graphicsitemnode.h"
+#include "../graph/graphicsitemedge.h"
+#include "../graph/debruijnnode.h"
+#include "../graph/debruijnedge.h"
+
+//Tiles are this many pixels square.  They are rendered with an extra pixel
+//around each side, so neighbouring tiles join without seams when scaled.
+static const int TILE_SIZE = 256;
+static const int TILE_PADDING = 1;
+
+//The most memory (in kilobytes) the tile cache can use.
+static const int TILE_CACHE_SIZE = 256 * 1024;
+
+//Levels are limited so that tile coordinates stay well inside an int.
+static const int MIN_TILE_LEVEL = -24;
+static const int MAX_TILE_LEVEL = 16;
+
+
+static TileResult renderTileJob(QSharedPointer<TileSnapshot> snapshot, TileKey key, int generation)
+{
+    TileResult result;
+    result.key = key;
+    result.generation = generation;
+    result.image = TileRenderer::renderTile(snapshot, key);
+    return result;
+}
+
+
+//This function finds the range of grid cells touched by a rectangle.
+//Rectangles outside the grid use the cells on its edge, which is where
+//items that have moved outside the grid are kept.
+static void getCellRange(const TileSnapshot * snapshot, const QRectF & rect,
+                         int * left, int * top, int * right, int * bottom)
+{
+    double maxColumn = snapshot->columns - 1;
+    double maxRow = snapshot->rows - 1;
+    *left = int(qBound(0.0, floor((rect.left() - snapshot->gridRect.left()) / snapshot->cellSize), maxColumn));
+    *right = int(qBound(0.0, floor((rect.right() - snapshot->gridRect.left()) / snapshot->cellSize), maxColumn));
+    *top = int(qBound(0.0, floor((rect.top() - snapshot->gridRect.top()) / snapshot->cellSize), maxRow));
+    *bottom = int(qBound(0.0, floor((rect.bottom() - snapshot->gridRect.top()) / snapshot->cellSize), maxRow));
+}
+
+
+
+TileRenderer::TileRenderer(QObject * parent) :
+    QObject(parent), m_active(false), m_tiles(TILE_CACHE_SIZE), m_generation(0)
+{
+    m_maxPendingTiles = qMax(2, QThread::idealThreadCount() * 2);
+}
+
+TileRenderer::~TileRenderer()
+{
+    waitForPendingTiles();
+}
+
+
+//This function copies what the tiles need from the scene's items, and
+//flags the items that will be drawn from tiles.  Scenes with fewer nodes
+//than the tiledRenderingNodeCount setting are left to draw as normal.
+void TileRenderer::takeSnapshot(QGraphicsScene * scene)
+{
+    clear();
+    m_scene = scene;
+    if (scene == 0 || g_settings->tiledRenderingNodeCount <= 0)
+        return;
+
+    //Path highlighting is drawn by the nodes themselves and changes as the
+    //user types, so tiles aren't used while a path dialog is open.
+    if (g_memory->pathDialogIsVisible || g_memory->queryPathDialogIsVisible)
+        return;
+
+    QList<QGraphicsItem *> sceneItems = scene->items(Qt::AscendingOrder);
+    int nodeCount = 0;
+    for (int i = 0; i < sceneItems.size(); ++i)
+    {
+        if (dynamic_cast<GraphicsItemNode *>(sceneItems[i]) != 0)
+            ++nodeCount;
+    }
+    if (nodeCount < g_settings->tiledRenderingNodeCount)
+        return;
+
+    m_active = true;
+    m_snapshot = QSharedPointer<TileSnapshot>(new TileSnapshot);
+    m_snapshot->edgeColour = g_settings->edgeColour;
+    m_snapshot->edgeWidth = g_settings->edgeWidth;
+    m_snapshot->outlineColour = g_settings->outlineColour;
+    m_snapshot->outlineThickness = g_settings->outlineThickness;
+    m_snapshot->lowDetailNodeWidth = g_settings->lowDetailNodeWidth;
+    m_snapshot->antialiasing = g_settings->antialiasing;
+
+    m_selectedItems = getSelectionLiveItems();
+
+    //The scene's ascending stacking order is the order it paints items in.
+    for (int i = 0; i < sceneItems.size(); ++i)
+    {
+        TileItem tileItem;
+        tileItem.item = sceneItems[i];
+        tileItem.isNode = (dynamic_cast<GraphicsItemNode *>(sceneItems[i]) != 0);
+        if (!tileItem.isNode && dynamic_cast<GraphicsItemEdge *>(sceneItems[i]) == 0)
+            continue;
+        tileItem.hidden = true;
+        tileItem.width = 0.0;
+
+        int index = int(m_snapshot->items.size());
+        m_snapshot->items.push_back(tileItem);
+        m_itemIndices.insert(sceneItems[i], index);
+        refreshItem(index);
+        m_snapshot->itemsRect = m_snapshot->itemsRect.united(m_snapshot->items[index].bounds);
+    }
+
+    //Cells are sized so that there are a few items in each, on average.
+    QRectF gridRect = m_snapshot->itemsRect;
+    double itemCount = qMax(size_t(1), m_snapshot->items.size());
+    double cellSize = 2.0 * sqrt(gridRect.width() * gridRect.height() / itemCount);
+    if (cellSize <= 0.0)
+        cellSize = qMax(1.0, qMax(gridRect.width(), gridRect.height()));
+    m_snapshot->gridRect = gridRect;
+    m_snapshot->cellSize = cellSize;
+    m_snapshot->columns = qMax(1, int(ceil(gridRect.width() / cellSize)));
+    m_snapshot->rows = qMax(1, int(ceil(gridRect.height() / cellSize)));
+    m_snapshot->cells.resize(size_t(m_snapshot->columns) * m_snapshot->rows);
+    for (size_t i = 0; i < m_snapshot->items.size(); ++i)
+        addToGrid(int(i));
+
+    connect(scene, SIGNAL(selectionChanged()), this, SLOT(updateSelectedItems()));
+}
+
+
+//This function drops the snapshot and all tiles, and gives every item in
+//the scene back its contents.  It only uses items that are still in the
+//scene, so it is safe to call after items have been deleted.
+void TileRenderer::clear()
+{
+    waitForPendingTiles();
+
+    if (m_scene != 0)
+    {
+        disconnect(m_scene, 0, this, 0);
+        if (m_active)
+        {
+            QList<QGraphicsItem *> sceneItems = m_scene->items();
+            for (int i = 0; i < sceneItems.size(); ++i)
+                sceneItems[i]->setFlag(QGraphicsItem::ItemHasNoContents, false);
+        }
+    }
+
+    m_scene = 0;
+    m_snapshot.clear();
+    m_active = false;
+    m_itemIndices.clear();
+    m_selectedItems.clear();
+    m_tiles.clear();
+    m_staleTiles.clear();
+}
+
+
+//This function draws the tiles covering the exposed part of the scene.
+//Tiles that aren't ready yet are requested, and in the meantime the
+//matching part of a coarser tile is drawn if there is one.
+void TileRenderer::drawTiles(QPainter * painter, const QRectF & exposedRect, double zoom)
+{
+    if (!m_active)
+        return;
+
+    QRectF rect = exposedRect.intersected(m_snapshot->itemsRect);
+    if (rect.isEmpty())
+        return;
+
+    int level = getLevelForZoom(zoom);
+    double tileSceneSize = ldexp(double(TILE_SIZE), -level);
+    int left = int(floor(rect.left() / tileSceneSize));
+    int right = int(floor(rect.right() / tileSceneSize));
+    int top = int(floor(rect.top() / tileSceneSize));
+    int bottom = int(floor(rect.bottom() / tileSceneSize));
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+        {
+            TileKey key(level, x, y);
+            if (!drawTile(painter, key) || m_staleTiles.contains(key))
+                requestTile(key);
+        }
+    }
+    painter->restore();
+}
+
+
+//This function returns false if the tile itself wasn't available.
+bool TileRenderer::drawTile(QPainter * painter, const TileKey & key)
+{
+    QRectF sourceRect(TILE_PADDING, TILE_PADDING, TILE_SIZE, TILE_SIZE);
+    QImage * image = m_tiles.object(key);
+    if (image != 0)
+    {
+        painter->drawImage(getTileRect(key), *image, sourceRect);
+        return true;
+    }
+
+    for (int levelsUp = 1; levelsUp <= 4 && key.level - levelsUp >= MIN_TILE_LEVEL; ++levelsUp)
+    {
+        double scale = ldexp(1.0, -levelsUp);
+        TileKey coarserKey(key.level - levelsUp, int(floor(key.x * scale)), int(floor(key.y * scale)));
+        QImage * coarserImage = m_tiles.object(coarserKey);
+        if (coarserImage == 0)
+            continue;
+
+        double partSize = TILE_SIZE * scale;
+        QRectF partRect(TILE_PADDING + (key.x - coarserKey.x / scale) * partSize,
+                        TILE_PADDING + (key.y - coarserKey.y / scale) * partSize,
+                        partSize, partSize);
+        painter->drawImage(getTileRect(key), *coarserImage, partRect);
+        break;
+    }
+    return false;
+}
+
+
+void TileRenderer::requestTile(const TileKey & key)
+{
+    if (m_pendingTiles.contains(key) || m_pendingTiles.size() >= m_maxPendingTiles)
+        return;
+
+    QFutureWatcher<TileResult> * watcher = new QFutureWatcher<TileResult>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(tileFinished()));
+    watcher->setFuture(QtConcurrent::run(renderTileJob, m_snapshot, key, m_generation));
+    m_pendingTiles.insert(key, watcher);
+}
+
+
+void TileRenderer::tileFinished()
+{
+    QFutureWatcher<TileResult> * watcher = static_cast<QFutureWatcher<TileResult> *>(sender());
+    TileResult result = watcher->result();
+    watcher->deleteLater();
+
+    //Tiles from an older snapshot are thrown away.
+    if (result.generation != m_generation)
+        return;
+
+    m_pendingTiles.remove(result.key);
+    m_staleTiles.remove(result.key);
+    m_tiles.insert(result.key, new QImage(result.image), qMax(1, result.image.byteCount() / 1024));
+    emit tilesChanged(getTileRect(result.key));
+}
+
+
+//The worker threads read the snapshot, so they must finish before it can
+//be changed.  Tiles still on their way were rendered from the old snapshot,
+//so they are discarded by moving to a new generation.
+void TileRenderer::waitForPendingTiles()
+{
+    QHashIterator<TileKey, QFutureWatcher<TileResult> *> i(m_pendingTiles);
+    while (i.hasNext())
+    {
+        i.next();
+        i.value()->waitForFinished();
+    }
+    m_pendingTiles.clear();
+    ++m_generation;
+}
+
+
+//When the selection changes, nodes that become selected (and the edges that
+//move with them) are taken out of the tiles and drawn live, and items that
+//are no longer selected go back into the tiles where they now are.
+void TileRenderer::updateSelectedItems()
+{
+    if (!m_active || m_scene == 0)
+        return;
+
+    QSet<QGraphicsItem *> selectedItems = getSelectionLiveItems();
+    QSet<QGraphicsItem *> changedItems = selectedItems;
+    changedItems.unite(m_selectedItems);
+    QSet<QGraphicsItem *> unchangedItems = selectedItems;
+    changedItems.subtract(unchangedItems.intersect(m_selectedItems));
+    if (changedItems.isEmpty())
+        return;
+
+    waitForPendingTiles();
+    m_selectedItems = selectedItems;
+
+    QRectF changedRect;
+    QSetIterator<QGraphicsItem *> i(changedItems);
+    while (i.hasNext())
+    {
+        int index = m_itemIndices.value(i.next(), -1);
+        if (index < 0)
+            continue;
+        changedRect = changedRect.united(m_snapshot->items[index].bounds);
+        invalidateRect(m_snapshot->items[index].bounds);
+        removeFromGrid(index);
+        refreshItem(index);
+        addToGrid(index);
+        invalidateRect(m_snapshot->items[index].bounds);
+        changedRect = changedRect.united(m_snapshot->items[index].bounds);
+        m_snapshot->itemsRect = m_snapshot->itemsRect.united(m_snapshot->items[index].bounds);
+    }
+    emit tilesChanged(changedRect);
+}
+
+
+//Tiles touching the rectangle are kept on screen until their replacements
+//are ready, so the view doesn't flicker.
+void TileRenderer::invalidateRect(const QRectF & sceneRect)
+{
+    QList<TileKey> keys = m_tiles.keys();
+    for (int i = 0; i < keys.size(); ++i)
+    {
+        if (getTileRect(keys[i]).intersects(sceneRect))
+            m_staleTiles.insert(keys[i]);
+    }
+}
+
+
+//This function copies an item's current appearance into the snapshot and
+//decides whether it is drawn in the tiles or live.
+void TileRenderer::refreshItem(int index)
+{
+    TileItem * tileItem = &m_snapshot->items[index];
+    if (tileItem->isNode)
+    {
+        GraphicsItemNode * node = static_cast<GraphicsItemNode *>(tileItem->item);
+        tileItem->path = node->shape();
+        tileItem->linePoints = node->m_linePoints;
+        tileItem->width = node->m_width;
+        tileItem->colour = node->m_colour;
+        tileItem->bounds = node->boundingRect();
+        tileItem->hidden = m_selectedItems.contains(node) || !node->hasOnlyFillAndOutline();
+    }
+    else
+    {
+        GraphicsItemEdge * edge = static_cast<GraphicsItemEdge *>(tileItem->item);
+        double halfWidth = m_snapshot->edgeWidth / 2.0;
+        tileItem->path = edge->path();
+        tileItem->bounds = tileItem->path.boundingRect().adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth);
+        tileItem->hidden = m_selectedItems.contains(edge);
+    }
+    tileItem->item->setFlag(QGraphicsItem::ItemHasNoContents, !tileItem->hidden);
+}
+
+
+void TileRenderer::addToGrid(int index)
+{
+    int left, top, right, bottom;
+    getCellRange(m_snapshot.data(), m_snapshot->items[index].bounds, &left, &top, &right, &bottom);
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+            m_snapshot->cells[size_t(y) * m_snapshot->columns + x].push_back(index);
+    }
+}
+
+
+void TileRenderer::removeFromGrid(int index)
+{
+    int left, top, right, bottom;
+    getCellRange(m_snapshot.data(), m_snapshot->items[index].bounds, &left, &top, &right, &bottom);
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+        {
+            std::vector<int> * cell = &m_snapshot->cells[size_t(y) * m_snapshot->columns + x];
+            cell->erase(std::remove(cell->begin(), cell->end(), index), cell->end());
+        }
+    }
+}
+
+
+//Selected items are drawn live, along with the edges of selected nodes, as
+//those edges move when the nodes are dragged.
+QSet<QGraphicsItem *> TileRenderer::getSelectionLiveItems() const
+{
+    QSet<QGraphicsItem *> liveItems;
+    QList<QGraphicsItem *> selectedItems = m_scene->selectedItems();
+    for (int i = 0; i < selectedItems.size(); ++i)
+    {
+        liveItems.insert(selectedItems[i]);
+
+        GraphicsItemNode * node = dynamic_cast<GraphicsItemNode *>(selectedItems[i]);
+        if (node == 0)
+            continue;
+        const std::vector<DeBruijnEdge *> * edges = node->m_deBruijnNode->getEdgesPointer();
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            GraphicsItemEdge * edge = (*edges)[j]->getGraphicsItemEdge();
+            if (edge == 0 && !g_settings->doubleMode)
+                edge = (*edges)[j]->getReverseComplement()->getGraphicsItemEdge();
+            if (edge != 0)
+                liveItems.insert(edge);
+        }
+    }
+    return liveItems;
+}
+
+
+int TileRenderer::getLevelForZoom(double zoom)
+{
+    if (zoom <= 0.0)
+        return MIN_TILE_LEVEL;
+    int level = int(ceil(log(zoom) / log(2.0) - 1e-9));
+    return qBound(MIN_TILE_LEVEL, level, MAX_TILE_LEVEL);
+}
+
+
+QRectF TileRenderer::getTileRect(const TileKey & key)
+{
+    double size = ldexp(double(TILE_SIZE), -key.level);
+    return QRectF(key.x * size, key.y * size, size, size);
+}
+
+
+//This function draws one tile from the snapshot.  It runs on the thread
+//pool, so it only reads the snapshot and never touches the scene.
+QImage TileRenderer::renderTile(QSharedPointer<TileSnapshot> snapshot, TileKey key)
+{
+    QImage image(TILE_SIZE + 2 * TILE_PADDING, TILE_SIZE + 2 * TILE_PADDING,
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    if (snapshot->items.empty())
+        return image;
+
+    double scale = ldexp(1.0, key.level);
+    double padding = TILE_PADDING / scale;
+    QRectF tileRect = getTileRect(key).adjusted(-padding, -padding, padding, padding);
+
+    //Items can be in more than one cell, so the list is sorted to remove
+    //repeats and to put the items back in drawing order.
+    std::vector<int> indices;
+    int left, top, right, bottom;
+    getCellRange(snapshot.data(), tileRect, &left, &top, &right, &bottom);
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+        {
+            const std::vector<int> & cell = snapshot->cells[size_t(y) * snapshot->columns + x];
+            for (size_t i = 0; i < cell.size(); ++i)
+            {
+                const TileItem & tileItem = snapshot->items[cell[i]];
+                if (!tileItem.hidden && tileItem.bounds.intersects(tileRect))
+                    indices.push_back(cell[i]);
+            }
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, snapshot->antialiasing);
+    painter.scale(scale, scale);
+    painter.translate(-tileRect.left(), -tileRect.top());
+
+    //Items are drawn the same way GraphicsItemEdge::paint and
+    //GraphicsItemNode::paint draw them when not selected.
+    QPen edgePen(QBrush(snapshot->edgeColour), snapshot->edgeWidth, Qt::SolidLine, Qt::RoundCap);
+    QPen outlinePen(QBrush(snapshot->outlineColour), snapshot->outlineThickness, Qt::SolidLine,
+                    Qt::SquareCap, Qt::RoundJoin);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        const TileItem & tileItem = snapshot->items[indices[i]];
+        if (!tileItem.isNode)
+        {
+            painter.setPen(edgePen);
+            painter.setBrush(Qt::NoBrush);
+            painter.drawPath(tileItem.path);
+        }
+        else if (tileItem.width * scale < snapshot->lowDetailNodeWidth)
+        {
+            painter.setPen(QPen(QBrush(tileItem.colour), tileItem.width, Qt::SolidLine, Qt::FlatCap, Qt::RoundJoin));
+            painter.drawPolyline(tileItem.linePoints.data(), int(tileItem.linePoints.size()));
+        }
+        else
+        {
+            painter.fillPath(tileItem.path, QBrush(tileItem.colour));
+            if (snapshot->outlineThickness > 0.0)
+            {
+                painter.setPen(outlinePen);
+                painter.setBrush(Qt::NoBrush);
+                painter.drawPath(tileItem.path.simplified());
+            }
+        }
+    }
+
+    return image;
+}
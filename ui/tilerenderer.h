@@ -0,0 +1,169 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+#include <QObject>
+#include <QImage>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QRectF>
+#include <QPointF>
+#include <QColor>
+#include <QPainterPath>
+#include <QPointer>
+#include <QGraphicsScene>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+#include <vector>
+
+class QGraphicsItem;
+class QPainter;
+
+//TileRenderer draws very large scenes from a pyramid of prerendered tiles,
+//instead of painting every item in the view each time it is redrawn.  Each
+//level of the pyramid is drawn at twice the scale of the level below it,
+//and the view shows the first level with at least as much detail as the
+//screen.  Tiles are rendered on the global thread pool from a snapshot of
+//the scene's items, so the worker threads never touch the items themselves.
+//
+//Items which are drawn into tiles are flagged as having no contents, so
+//the scene skips them when painting, but they can still be clicked and
+//selected as normal.  Selected nodes (and the edges which move with them),
+//and nodes showing BLAST hits, barcodes, labels or paths, stay as live
+//items drawn by the scene on top of the tiles.
+
+struct TileKey
+{
+    TileKey() : level(0), x(0), y(0) {}
+    TileKey(int l, int tx, int ty) : level(l), x(tx), y(ty) {}
+    int level;
+    int x;
+    int y;
+};
+
+inline bool operator==(const TileKey & a, const TileKey & b)
+{
+    return a.level == b.level && a.x == b.x && a.y == b.y;
+}
+
+inline uint qHash(const TileKey & key)
+{
+    return uint(key.level) * 1000003u ^ uint(key.x) * 8191u ^ uint(key.y);
+}
+
+struct TileItem
+{
+    QGraphicsItem * item;
+    bool isNode;
+    bool hidden;
+    QRectF bounds;
+
+    //For nodes this is the outline, for edges it is the edge's path.
+    QPainterPath path;
+    std::vector<QPointF> linePoints;
+    double width;
+    QColor colour;
+};
+
+struct TileSnapshot
+{
+    //Items are kept in drawing order: edges first, then nodes from the
+    //bottom up.
+    std::vector<TileItem> items;
+    QRectF itemsRect;
+
+    //Each item is listed in every cell of this grid that its bounds touch,
+    //so a tile only looks at the items near it.
+    QRectF gridRect;
+    double cellSize;
+    int columns;
+    int rows;
+    std::vector<std::vector<int> > cells;
+
+    QColor edgeColour;
+    double edgeWidth;
+    QColor outlineColour;
+    double outlineThickness;
+    double lowDetailNodeWidth;
+    bool antialiasing;
+};
+
+struct TileResult
+{
+    TileKey key;
+    int generation;
+    QImage image;
+};
+
+class TileRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TileRenderer(QObject * parent = 0);
+    ~TileRenderer();
+
+    bool isUpToDate(QGraphicsScene * scene) const {return m_scene != 0 && m_scene == scene;}
+    bool isActive() const {return m_active;}
+    void takeSnapshot(QGraphicsScene * scene);
+    void clear();
+    void drawTiles(QPainter * painter, const QRectF & exposedRect, double zoom);
+    int getTileCount() const {return m_tiles.count();}
+    QSharedPointer<TileSnapshot> getSnapshot() const {return m_snapshot;}
+
+    static int getLevelForZoom(double zoom);
+    static QRectF getTileRect(const TileKey & key);
+    static QImage renderTile(QSharedPointer<TileSnapshot> snapshot, TileKey key);
+
+public slots:
+    void updateSelectedItems();
+
+signals:
+    void tilesChanged(const QRectF & sceneRect);
+
+private:
+    QPointer<QGraphicsScene> m_scene;
+    QSharedPointer<TileSnapshot> m_snapshot;
+    bool m_active;
+    QHash<QGraphicsItem *, int> m_itemIndices;
+    QSet<QGraphicsItem *> m_selectedItems;
+
+    QCache<TileKey, QImage> m_tiles;
+    QSet<TileKey> m_staleTiles;
+    QHash<TileKey, QFutureWatcher<TileResult> *> m_pendingTiles;
+    int m_generation;
+    int m_maxPendingTiles;
+
+    void requestTile(const TileKey & key);
+    bool drawTile(QPainter * painter, const TileKey & key);
+    void waitForPendingTiles();
+    void invalidateRect(const QRectF & sceneRect);
+    void refreshItem(int index);
+    void addToGrid(int index);
+    void removeFromGrid(int index);
+    QSet<QGraphicsItem *> getSelectionLiveItems() const;
+
+private slots:
+    void tileFinished();
+};
+
+#endif // TILERENDERER_H